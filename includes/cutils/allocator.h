@@ -28,6 +28,13 @@ void cutils_static_pool_init (cutils_static_pool_t *pool, void *memory,
 /* Create default allocator based on configuration */
 cutils_allocator_t cutils_create_default_allocator (void);
 
+/* Get the shared default allocator (valid for the program's lifetime) */
+cutils_allocator_t *cutils_get_default_allocator (void);
+
+/* Check if two allocators hand out and reclaim memory from the same source */
+bool cutils_allocator_equal (const cutils_allocator_t *a,
+                             const cutils_allocator_t *b);
+
 /* Allocate memory with alignment */
 void *cutils_allocate_aligned (cutils_allocator_t *allocator, size_t size,
                                size_t alignment);
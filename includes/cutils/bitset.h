@@ -0,0 +1,291 @@
+#ifndef CUTILS_BITSET_H
+#define CUTILS_BITSET_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Dynamic bitset stored as 64-bit words, bit i in word i / 64 at position
+ * i % 64. Bits past the length are always zero.
+ *
+ * An optional rank index keeps the number of set bits before every
+ * CUTILS_BITSET_RANK_BLOCK_BITS bits, so rank and select stop scanning the
+ * whole set. Any modification invalidates the index until
+ * bitset_build_rank_index is called again.
+ */
+typedef struct
+{
+  uint64_t *words;
+  size_t len;
+  size_t word_capacity;
+  uint64_t *rank;
+  size_t rank_capacity;
+  bool rank_valid;
+  cutils_allocator_t *allocator;
+} bitset_t;
+
+typedef enum
+{
+  BITSET_OK = 0,
+  BITSET_NULL_PTR = 1,
+  BITSET_NO_MEMORY = 2,
+  BITSET_INVALID_ARG = 3,
+  BITSET_OUT_OF_RANGE = 4,
+  BITSET_OVERFLOW = 5,
+  BITSET_TIMEOUT = 6,
+  BITSET_NOT_FOUND = 7
+} bitset_result_t;
+
+/**
+ * Gets the last bitset operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] bitset_result_t bitset_get_error (void);
+
+/**
+ * Creates a new bitset with the specified allocator.
+ *
+ * @param len Initial number of bits, all cleared
+ * @param allocator Allocator to use
+ * @return Newly allocated bitset or NULL on error
+ * @note Sets error to BITSET_INVALID_ARG if allocator is NULL
+ * @note Sets error to BITSET_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] bitset_t *bitset_create_with_allocator (
+    size_t len, cutils_allocator_t *allocator);
+
+/**
+ * Creates a new bitset using the default allocator.
+ *
+ * @param len Initial number of bits, all cleared
+ * @return Newly allocated bitset or NULL on error
+ */
+[[nodiscard]] bitset_t *bitset_create (size_t len);
+
+/**
+ * Frees all memory associated with the bitset.
+ *
+ * @param bs Bitset to destroy
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ */
+void bitset_destroy (bitset_t *bs);
+
+/**
+ * Changes the number of bits. New bits are cleared.
+ *
+ * @param bs Bitset to resize
+ * @param len New number of bits
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_NO_MEMORY if allocation fails
+ */
+bool bitset_resize (bitset_t *bs, size_t len);
+
+/**
+ * Appends a bit with timeout.
+ *
+ * @param bs Bitset to append to
+ * @param value Bit to append
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_NO_MEMORY if growing fails
+ * @note Sets error to BITSET_TIMEOUT if growing takes too long
+ */
+bool bitset_push_timeout (bitset_t *bs, bool value, uint32_t timeout_ms);
+
+/**
+ * Appends a bit.
+ *
+ * @param bs Bitset to append to
+ * @param value Bit to append
+ * @return true if successful, false otherwise
+ */
+bool bitset_push (bitset_t *bs, bool value);
+
+/**
+ * Sets a bit to 1.
+ *
+ * @param bs Bitset to modify
+ * @param index Bit index
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_OUT_OF_RANGE if index is out of bounds
+ */
+bool bitset_set (bitset_t *bs, size_t index);
+
+/**
+ * Clears a bit to 0.
+ *
+ * @param bs Bitset to modify
+ * @param index Bit index
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_OUT_OF_RANGE if index is out of bounds
+ */
+bool bitset_reset (bitset_t *bs, size_t index);
+
+/**
+ * Toggles a bit.
+ *
+ * @param bs Bitset to modify
+ * @param index Bit index
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_OUT_OF_RANGE if index is out of bounds
+ */
+bool bitset_flip (bitset_t *bs, size_t index);
+
+/**
+ * Reads a bit.
+ *
+ * @param bs Bitset to read
+ * @param index Bit index
+ * @return Value of the bit, false on error
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_OUT_OF_RANGE if index is out of bounds
+ */
+bool bitset_test (const bitset_t *bs, size_t index);
+
+/**
+ * Sets or clears every bit.
+ *
+ * @param bs Bitset to modify
+ * @param value Value to fill with
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ */
+bool bitset_fill (bitset_t *bs, bool value);
+
+/**
+ * Computes dst &= src word by word.
+ *
+ * @param dst Bitset to modify
+ * @param src Other operand
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if any parameter is NULL
+ * @note Sets error to BITSET_INVALID_ARG if lengths differ
+ */
+bool bitset_and (bitset_t *dst, const bitset_t *src);
+
+/**
+ * Computes dst |= src word by word.
+ *
+ * @param dst Bitset to modify
+ * @param src Other operand
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if any parameter is NULL
+ * @note Sets error to BITSET_INVALID_ARG if lengths differ
+ */
+bool bitset_or (bitset_t *dst, const bitset_t *src);
+
+/**
+ * Computes dst ^= src word by word.
+ *
+ * @param dst Bitset to modify
+ * @param src Other operand
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if any parameter is NULL
+ * @note Sets error to BITSET_INVALID_ARG if lengths differ
+ */
+bool bitset_xor (bitset_t *dst, const bitset_t *src);
+
+/**
+ * Computes dst &= ~src word by word.
+ *
+ * @param dst Bitset to modify
+ * @param src Bits to remove from dst
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if any parameter is NULL
+ * @note Sets error to BITSET_INVALID_ARG if lengths differ
+ */
+bool bitset_andnot (bitset_t *dst, const bitset_t *src);
+
+/**
+ * Counts the set bits.
+ *
+ * @param bs Bitset to count
+ * @return Number of set bits, or 0 if bs is NULL
+ * @note Uses an AVX2 nibble-lookup popcount when available
+ */
+size_t bitset_count (const bitset_t *bs);
+
+/**
+ * Counts the bits set in both bitsets without building the intersection.
+ *
+ * @param a First bitset
+ * @param b Second bitset
+ * @return Number of common set bits, or 0 on error
+ * @note Sets error to BITSET_NULL_PTR if any parameter is NULL
+ * @note Sets error to BITSET_INVALID_ARG if lengths differ
+ */
+size_t bitset_count_and (const bitset_t *a, const bitset_t *b);
+
+/**
+ * Finds the first set bit at or after a position.
+ *
+ * Iterate over set bits with
+ * for (i = bitset_find_next (bs, 0); i != SIZE_MAX;
+ *      i = bitset_find_next (bs, i + 1)).
+ *
+ * @param bs Bitset to search
+ * @param from First index to consider
+ * @return Index of the set bit, or SIZE_MAX if there is none
+ * @note Sets error to BITSET_NOT_FOUND if no bit is set at or after from
+ */
+size_t bitset_find_next (const bitset_t *bs, size_t from);
+
+/**
+ * Builds the rank/select index for the current contents.
+ *
+ * @param bs Bitset to index
+ * @return true if successful, false otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_NO_MEMORY if allocation fails
+ */
+bool bitset_build_rank_index (bitset_t *bs);
+
+/**
+ * Counts the set bits before a position.
+ *
+ * @param bs Bitset to query
+ * @param index Position, at most the bitset length
+ * @return Number of set bits in [0, index), or 0 on error
+ * @note Constant time with a valid rank index, linear otherwise
+ * @note Sets error to BITSET_NULL_PTR if bs is NULL
+ * @note Sets error to BITSET_OUT_OF_RANGE if index exceeds the length
+ */
+size_t bitset_rank (const bitset_t *bs, size_t index);
+
+/**
+ * Finds the position of the k-th set bit, counting from 0.
+ *
+ * @param bs Bitset to query
+ * @param k Number of set bits to skip
+ * @return Index of the bit, or SIZE_MAX if fewer than k + 1 bits are set
+ * @note Logarithmic with a valid rank index, linear otherwise
+ * @note Sets error to BITSET_NOT_FOUND if fewer than k + 1 bits are set
+ */
+size_t bitset_select (const bitset_t *bs, size_t k);
+
+/**
+ * Gets the number of bits.
+ *
+ * @param bs Bitset to query
+ * @return Number of bits, or 0 if bs is NULL
+ */
+size_t bitset_length (const bitset_t *bs);
+
+/**
+ * Calculates total memory usage of the bitset.
+ *
+ * @param bs Bitset to measure
+ * @return Total bytes used, or 0 if bs is NULL
+ */
+size_t bitset_memory_usage (const bitset_t *bs);
+
+#endif // CUTILS_BITSET_H
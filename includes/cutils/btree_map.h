@@ -0,0 +1,267 @@
+#ifndef CUTILS_BTREE_MAP_H
+#define CUTILS_BTREE_MAP_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Ordered map stored as a B+ tree. Every node is about
+ * CUTILS_BTREE_MAP_NODE_BYTES and keeps its keys contiguous, so a lookup
+ * does a binary search within one node per level instead of one cache miss
+ * per key. Entries live in the leaves, which are linked in key order, so
+ * iteration and range scans walk arrays.
+ *
+ * Leaves hold their keys followed by their values; internal nodes hold
+ * separator keys followed by child pointers. Entry addresses are not
+ * stable: inserts and removes move entries between nodes.
+ */
+typedef struct btree_map_node
+{
+  struct btree_map_node *next; // leaves only
+  struct btree_map_node *prev; // leaves only
+  size_t count;
+  bool is_leaf;
+  alignas (max_align_t) unsigned char data[];
+} btree_map_node_t;
+
+typedef struct
+{
+  btree_map_node_t *root;
+  btree_map_node_t *first;
+  btree_map_node_t *last;
+  size_t size;
+  size_t height;
+  size_t leaf_count;
+  size_t internal_count;
+  size_t key_size;
+  size_t value_size;
+  size_t leaf_capacity;
+  size_t internal_capacity;
+  size_t value_offset;
+  size_t child_offset;
+  cutils_allocator_t *allocator;
+  int (*compare) (const void *a, const void *b);
+} btree_map_t;
+
+typedef enum
+{
+  BTREE_MAP_OK = 0,
+  BTREE_MAP_NULL_PTR = 1,
+  BTREE_MAP_NO_MEMORY = 2,
+  BTREE_MAP_INVALID_ARG = 3,
+  BTREE_MAP_KEY_EXISTS = 4,
+  BTREE_MAP_KEY_NOT_FOUND = 5,
+  BTREE_MAP_TIMEOUT = 6,
+  BTREE_MAP_OVERFLOW = 7
+} btree_map_result_t;
+
+/**
+ * Creates a new B-tree map with the specified allocator.
+ *
+ * @param key_size Size of key in bytes
+ * @param value_size Size of value in bytes
+ * @param compare Key comparison function
+ * @param allocator Allocator to use
+ * @return Newly allocated map or NULL on error
+ * @note Sets error to BTREE_MAP_INVALID_ARG if a size is 0 or compare or
+ *       allocator is NULL
+ * @note Sets error to BTREE_MAP_OVERFLOW if the sizes are too large
+ */
+[[nodiscard]] btree_map_t *
+btree_map_create_with_allocator (size_t key_size, size_t value_size,
+                                 int (*compare) (const void *a,
+                                                 const void *b),
+                                 cutils_allocator_t *allocator);
+
+/**
+ * Creates a new B-tree map using the default allocator.
+ *
+ * @param key_size Size of key in bytes
+ * @param value_size Size of value in bytes
+ * @param compare Key comparison function
+ * @return Newly allocated map or NULL on error
+ */
+[[nodiscard]] btree_map_t *
+btree_map_create (size_t key_size, size_t value_size,
+                  int (*compare) (const void *a, const void *b));
+
+/**
+ * Destroys a map and frees all allocated memory.
+ *
+ * @param map Map to destroy
+ */
+void btree_map_destroy (btree_map_t *map);
+
+/**
+ * Inserts a key-value pair with timeout.
+ *
+ * @param map Map to insert into
+ * @param key Key to insert
+ * @param value Value to insert
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note Nodes needed for splits are allocated before the tree is touched,
+ *       so a failed insert leaves the map unchanged
+ * @note Sets error to BTREE_MAP_NULL_PTR if any parameter is NULL
+ * @note Sets error to BTREE_MAP_KEY_EXISTS if the key is already present
+ * @note Sets error to BTREE_MAP_NO_MEMORY if allocation fails
+ * @note Sets error to BTREE_MAP_TIMEOUT if allocation takes too long
+ */
+bool btree_map_insert_timeout (btree_map_t *map, const void *key,
+                               const void *value, uint32_t timeout_ms);
+
+/**
+ * Inserts a key-value pair.
+ *
+ * @param map Map to insert into
+ * @param key Key to insert
+ * @param value Value to insert
+ * @return true if successful, false otherwise
+ */
+bool btree_map_insert (btree_map_t *map, const void *key, const void *value);
+
+/**
+ * Removes a key-value pair.
+ *
+ * @param map Map to remove from
+ * @param key Key to remove
+ * @param out_value Output parameter to store the removed value (optional)
+ * @return true if successful, false otherwise
+ * @note Sets error to BTREE_MAP_NULL_PTR if map or key is NULL
+ * @note Sets error to BTREE_MAP_KEY_NOT_FOUND if the key is absent
+ */
+bool btree_map_remove (btree_map_t *map, const void *key, void *out_value);
+
+/**
+ * Gets a value from the map.
+ *
+ * @param map Map to get from
+ * @param key Key to get
+ * @param out_value Output parameter to store the value
+ * @return true if successful, false otherwise
+ * @note Sets error to BTREE_MAP_NULL_PTR if any parameter is NULL
+ * @note Sets error to BTREE_MAP_KEY_NOT_FOUND if the key is absent
+ */
+bool btree_map_get (const btree_map_t *map, const void *key,
+                    void *out_value);
+
+/**
+ * Checks if a key exists in the map.
+ *
+ * @param map Map to check
+ * @param key Key to check
+ * @return true if key exists, false otherwise
+ */
+bool btree_map_contains (const btree_map_t *map, const void *key);
+
+/**
+ * Gets the number of key-value pairs in the map.
+ *
+ * @param map Map to get size from
+ * @return Number of key-value pairs
+ */
+size_t btree_map_size (const btree_map_t *map);
+
+/**
+ * Checks if the map is empty.
+ *
+ * @param map Map to check
+ * @return true if empty, false otherwise
+ */
+bool btree_map_is_empty (const btree_map_t *map);
+
+/**
+ * Clears all key-value pairs from the map.
+ *
+ * @param map Map to clear
+ * @return true if successful, false otherwise
+ */
+bool btree_map_clear (btree_map_t *map);
+
+/**
+ * Gets the memory usage of the map.
+ *
+ * @param map Map to get memory usage from
+ * @return Memory usage in bytes
+ */
+size_t btree_map_memory_usage (const btree_map_t *map);
+
+/**
+ * Gets the last B-tree map operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] btree_map_result_t btree_map_get_error (void);
+
+typedef struct
+{
+  btree_map_t *map;
+  btree_map_node_t *node;
+  size_t index;
+} btree_map_iterator_t;
+
+/**
+ * Creates an iterator starting from the first element.
+ *
+ * @param map Map to create iterator for
+ * @return Iterator starting from the first element
+ */
+btree_map_iterator_t btree_map_begin (btree_map_t *map);
+
+/**
+ * Creates an iterator starting from the last element.
+ *
+ * @param map Map to create iterator for
+ * @return Iterator starting from the last element
+ */
+btree_map_iterator_t btree_map_end (btree_map_t *map);
+
+/**
+ * Moves the iterator to the next element.
+ *
+ * @param it Iterator to move
+ * @return true if successful, false if end of map
+ */
+bool btree_map_iterator_next (btree_map_iterator_t *it);
+
+/**
+ * Moves the iterator to the previous element.
+ *
+ * @param it Iterator to move
+ * @return true if successful, false if beginning of map
+ */
+bool btree_map_iterator_prev (btree_map_iterator_t *it);
+
+/**
+ * Gets the current key-value pair.
+ *
+ * @param it Iterator to get from
+ * @param out_key Output parameter to store the key (optional)
+ * @param out_value Output parameter to store the value (optional)
+ * @return true if successful, false if end of map
+ */
+bool btree_map_iterator_get (const btree_map_iterator_t *it, void *out_key,
+                             void *out_value);
+
+/**
+ * Sets the current value.
+ *
+ * @param it Iterator to set for
+ * @param value Value to set
+ * @return true if successful, false if end of map
+ */
+bool btree_map_iterator_set (btree_map_iterator_t *it, const void *value);
+
+/**
+ * Checks if the iterator is valid.
+ *
+ * @param it Iterator to check
+ * @return true if valid, false if end of map
+ */
+bool btree_map_iterator_is_valid (const btree_map_iterator_t *it);
+
+#endif // CUTILS_BTREE_MAP_H
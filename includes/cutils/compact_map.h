@@ -0,0 +1,289 @@
+#ifndef CUTILS_COMPACT_MAP_H
+#define CUTILS_COMPACT_MAP_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Ordered map stored as a red-black tree whose nodes live in one contiguous
+ * pool and refer to each other by 32-bit index instead of by pointer. The
+ * color is the low bit of the parent link, so a node's links take 12 bytes,
+ * followed by its key and value. Removed slots go on a free list and are
+ * reused before the pool grows.
+ *
+ * Index 0 means "no node"; slot i lives at pool + (i - 1) * slot_size. The
+ * pool doubles when full, which moves every entry, so pointers into it are
+ * invalidated by inserts. Indices and iterators stay valid until their entry
+ * is removed. The map holds at most COMPACT_MAP_MAX_SIZE entries.
+ */
+#define COMPACT_MAP_MAX_SIZE 0x7FFFFFFFu
+
+typedef struct
+{
+  uint32_t left;
+  uint32_t right;
+  uint32_t parent_color; // parent index << 1 | red
+} compact_map_link_t;
+
+typedef struct
+{
+  unsigned char *pool;
+  uint32_t root;
+  uint32_t free_head;
+  uint32_t capacity;
+  uint32_t used;
+  size_t size;
+  size_t key_size;
+  size_t value_size;
+  size_t key_offset;
+  size_t value_offset;
+  size_t slot_size;
+  cutils_allocator_t *allocator;
+  int (*compare) (const void *a, const void *b);
+} compact_map_t;
+
+typedef enum
+{
+  COMPACT_MAP_OK = 0,
+  COMPACT_MAP_NULL_PTR = 1,
+  COMPACT_MAP_NO_MEMORY = 2,
+  COMPACT_MAP_INVALID_ARG = 3,
+  COMPACT_MAP_KEY_EXISTS = 4,
+  COMPACT_MAP_KEY_NOT_FOUND = 5,
+  COMPACT_MAP_TIMEOUT = 6,
+  COMPACT_MAP_OVERFLOW = 7
+} compact_map_result_t;
+
+/**
+ * Creates a new compact map with the specified allocator.
+ *
+ * @param key_size Size of key in bytes
+ * @param value_size Size of value in bytes
+ * @param compare Key comparison function
+ * @param allocator Allocator to use
+ * @return Newly allocated map or NULL on error
+ * @note The pool is allocated on the first insert
+ * @note Sets error to COMPACT_MAP_INVALID_ARG if a size is 0 or compare or
+ *       allocator is NULL
+ * @note Sets error to COMPACT_MAP_OVERFLOW if the sizes are too large
+ */
+[[nodiscard]] compact_map_t *
+compact_map_create_with_allocator (size_t key_size, size_t value_size,
+                                   int (*compare) (const void *a,
+                                                   const void *b),
+                                   cutils_allocator_t *allocator);
+
+/**
+ * Creates a new compact map using the default allocator.
+ *
+ * @param key_size Size of key in bytes
+ * @param value_size Size of value in bytes
+ * @param compare Key comparison function
+ * @return Newly allocated map or NULL on error
+ */
+[[nodiscard]] compact_map_t *
+compact_map_create (size_t key_size, size_t value_size,
+                    int (*compare) (const void *a, const void *b));
+
+/**
+ * Destroys a map and frees all allocated memory.
+ *
+ * @param map Map to destroy
+ */
+void compact_map_destroy (compact_map_t *map);
+
+/**
+ * Inserts a key-value pair with timeout.
+ *
+ * @param map Map to insert into
+ * @param key Key to insert
+ * @param value Value to insert
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to COMPACT_MAP_NULL_PTR if any parameter is NULL
+ * @note Sets error to COMPACT_MAP_KEY_EXISTS if the key is already present
+ * @note Sets error to COMPACT_MAP_OVERFLOW if the map is full
+ * @note Sets error to COMPACT_MAP_NO_MEMORY if growing the pool fails
+ * @note Sets error to COMPACT_MAP_TIMEOUT if growing takes too long
+ */
+bool compact_map_insert_timeout (compact_map_t *map, const void *key,
+                                 const void *value, uint32_t timeout_ms);
+
+/**
+ * Inserts a key-value pair.
+ *
+ * @param map Map to insert into
+ * @param key Key to insert
+ * @param value Value to insert
+ * @return true if successful, false otherwise
+ */
+bool compact_map_insert (compact_map_t *map, const void *key,
+                         const void *value);
+
+/**
+ * Removes a key-value pair. The slot is kept for reuse.
+ *
+ * @param map Map to remove from
+ * @param key Key to remove
+ * @param out_value Output parameter to store the removed value (optional)
+ * @return true if successful, false otherwise
+ * @note Sets error to COMPACT_MAP_NULL_PTR if map or key is NULL
+ * @note Sets error to COMPACT_MAP_KEY_NOT_FOUND if the key is absent
+ */
+bool compact_map_remove (compact_map_t *map, const void *key,
+                         void *out_value);
+
+/**
+ * Gets a value from the map.
+ *
+ * @param map Map to get from
+ * @param key Key to get
+ * @param out_value Output parameter to store the value
+ * @return true if successful, false otherwise
+ * @note Sets error to COMPACT_MAP_NULL_PTR if any parameter is NULL
+ * @note Sets error to COMPACT_MAP_KEY_NOT_FOUND if the key is absent
+ */
+bool compact_map_get (const compact_map_t *map, const void *key,
+                      void *out_value);
+
+/**
+ * Checks if a key exists in the map.
+ *
+ * @param map Map to check
+ * @param key Key to check
+ * @return true if key exists, false otherwise
+ */
+bool compact_map_contains (const compact_map_t *map, const void *key);
+
+/**
+ * Grows the pool so it can hold count entries without reallocating.
+ *
+ * @param map Map to grow
+ * @param count Number of entries to make room for
+ * @return true if successful, false otherwise
+ * @note Sets error to COMPACT_MAP_NULL_PTR if map is NULL
+ * @note Sets error to COMPACT_MAP_OVERFLOW if count exceeds
+ *       COMPACT_MAP_MAX_SIZE
+ * @note Sets error to COMPACT_MAP_NO_MEMORY if allocation fails
+ */
+bool compact_map_reserve (compact_map_t *map, size_t count);
+
+/**
+ * Gets the number of key-value pairs in the map.
+ *
+ * @param map Map to get size from
+ * @return Number of key-value pairs
+ */
+size_t compact_map_size (const compact_map_t *map);
+
+/**
+ * Checks if the map is empty.
+ *
+ * @param map Map to check
+ * @return true if empty, false otherwise
+ */
+bool compact_map_is_empty (const compact_map_t *map);
+
+/**
+ * Removes all key-value pairs, keeping the pool allocated.
+ *
+ * @param map Map to clear
+ * @return true if successful, false otherwise
+ */
+bool compact_map_clear (compact_map_t *map);
+
+/**
+ * Gets the memory usage of the map.
+ *
+ * @param map Map to get memory usage from
+ * @return Memory usage in bytes
+ */
+size_t compact_map_memory_usage (const compact_map_t *map);
+
+/**
+ * Checks the key order, links and red-black properties of the tree.
+ *
+ * @param map Map to check
+ * @return true if the tree is a valid red-black tree, false otherwise
+ * @note O(n); intended for diagnostics and tests
+ * @note Sets error to COMPACT_MAP_NULL_PTR if map is NULL
+ */
+bool compact_map_validate (const compact_map_t *map);
+
+/**
+ * Gets the last compact map operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] compact_map_result_t compact_map_get_error (void);
+
+typedef struct
+{
+  compact_map_t *map;
+  uint32_t index;
+} compact_map_iterator_t;
+
+/**
+ * Creates an iterator starting from the first element.
+ *
+ * @param map Map to create iterator for
+ * @return Iterator starting from the first element
+ */
+compact_map_iterator_t compact_map_begin (compact_map_t *map);
+
+/**
+ * Creates an iterator starting from the last element.
+ *
+ * @param map Map to create iterator for
+ * @return Iterator starting from the last element
+ */
+compact_map_iterator_t compact_map_end (compact_map_t *map);
+
+/**
+ * Moves the iterator to the next element.
+ *
+ * @param it Iterator to move
+ * @return true if successful, false if end of map
+ */
+bool compact_map_iterator_next (compact_map_iterator_t *it);
+
+/**
+ * Moves the iterator to the previous element.
+ *
+ * @param it Iterator to move
+ * @return true if successful, false if beginning of map
+ */
+bool compact_map_iterator_prev (compact_map_iterator_t *it);
+
+/**
+ * Gets the current key-value pair.
+ *
+ * @param it Iterator to get from
+ * @param out_key Output parameter to store the key (optional)
+ * @param out_value Output parameter to store the value (optional)
+ * @return true if successful, false if end of map
+ */
+bool compact_map_iterator_get (const compact_map_iterator_t *it,
+                               void *out_key, void *out_value);
+
+/**
+ * Sets the current value.
+ *
+ * @param it Iterator to set for
+ * @param value Value to set
+ * @return true if successful, false if end of map
+ */
+bool compact_map_iterator_set (compact_map_iterator_t *it, const void *value);
+
+/**
+ * Checks if the iterator is valid.
+ *
+ * @param it Iterator to check
+ * @return true if valid, false if end of map
+ */
+bool compact_map_iterator_is_valid (const compact_map_iterator_t *it);
+
+#endif // CUTILS_COMPACT_MAP_H
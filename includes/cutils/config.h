@@ -6,6 +6,7 @@
 #define CUTILS_USE_DYNAMIC_ALLOCATION 0
 #define CUTILS_MAX_STATIC_MEMORY (64 * 1024) // 64KB
 #define CUTILS_ALIGNMENT 8
+#define CUTILS_CACHE_LINE_SIZE 64
 
 /* Real-Time Configuration */
 #define CUTILS_MAX_OPERATION_TIME_MS 1
@@ -27,6 +28,8 @@
 #define CUTILS_ENABLE_THREAD_SAFETY 0
 #define CUTILS_ENABLE_EXCEPTIONS 0
 #define CUTILS_ENABLE_LOGGING 1
+#define CUTILS_ENABLE_SIMD 1
+#define CUTILS_ENABLE_MMAP 1 // file-backed mmap_vector on POSIX hosts
 
 /* Error Handling */
 #define CUTILS_USE_ERROR_CODES 1
@@ -36,6 +39,35 @@
 #define CUTILS_VECTOR_INIT_CAPACITY 16
 #define CUTILS_VECTOR_MAX_CAPACITY 1024
 #define CUTILS_VECTOR_GROWTH_FACTOR 2
+#define CUTILS_VECTOR_SORT_INSERTION_THRESHOLD 24
+#define CUTILS_VECTOR_SORT_RADIX_THRESHOLD 64
+
+/* Segmented Vector Configuration */
+#define CUTILS_SEG_VECTOR_BASE_SHIFT 4 // first chunk holds 16 elements
+#define CUTILS_SEG_VECTOR_MAX_CHUNKS 32
+
+/* Unrolled List Configuration */
+#define CUTILS_UNROLLED_LIST_NODE_BYTES 256 // four 64-byte cache lines
+
+/* B-Tree Map Configuration */
+#define CUTILS_BTREE_MAP_NODE_BYTES 512 // eight 64-byte cache lines
+
+/* Structure-of-Arrays Vector Configuration */
+#define CUTILS_SOA_MAX_COLUMNS 16
+#define CUTILS_SOA_COLUMN_ALIGNMENT 64
+
+/* Compressed Integer Vector Configuration */
+#define CUTILS_INT_VECTOR_BLOCK_SIZE 128 // values per delta/varint block
+
+/* Bitset Configuration */
+#define CUTILS_BITSET_RANK_BLOCK_BITS 512 // bits per rank index entry
+
+/* Hash Map Configuration */
+#define CUTILS_HASHMAP_INIT_CAPACITY 16 // slots, a power of two
+#define CUTILS_HASHMAP_MAX_LOAD_PERCENT 87
+
+/* Compact Map Configuration */
+#define CUTILS_COMPACT_MAP_INIT_CAPACITY 16 // node slots in the first pool
 
 /* Arena Configuration */
 #define CUTILS_ARENA_DEFAULT_BLOCK_SIZE 1024
@@ -0,0 +1,40 @@
+#ifndef CUTILS_CPU_H
+#define CUTILS_CPU_H
+
+#include "cutils/config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#if CUTILS_ENABLE_SIMD && (defined(__x86_64__) || defined(__i386__))
+#define CUTILS_SIMD_X86 1
+#else
+#define CUTILS_SIMD_X86 0
+#endif
+
+typedef enum
+{
+  CUTILS_CPU_SSE2 = 1 << 0,
+  CUTILS_CPU_AVX2 = 1 << 1,
+  CUTILS_CPU_POPCNT = 1 << 2,
+  CUTILS_CPU_BMI2 = 1 << 3
+} cutils_cpu_feature_t;
+
+/**
+ * @brief Get the instruction set extensions supported by the running CPU
+ *
+ * Detection runs once and the result is cached. On targets without SIMD
+ * support, or with CUTILS_ENABLE_SIMD disabled, no features are reported.
+ *
+ * @return uint32_t Bitmask of cutils_cpu_feature_t values
+ */
+uint32_t cutils_cpu_features (void);
+
+/**
+ * @brief Check whether the running CPU supports a feature
+ *
+ * @param feature Feature to check
+ * @return true if supported, false otherwise
+ */
+bool cutils_cpu_has (cutils_cpu_feature_t feature);
+
+#endif // CUTILS_CPU_H
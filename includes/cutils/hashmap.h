@@ -0,0 +1,284 @@
+#ifndef CUTILS_HASHMAP_H
+#define CUTILS_HASHMAP_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Unordered hash map using open addressing in the Swiss-table style. Keys
+ * and values are stored inline in one slot array. A parallel array holds a
+ * control byte per slot: either empty, or the low 7 bits of the key's hash.
+ * A lookup loads 16 control bytes at once and compares them against the
+ * hash tag with SSE2 (SWAR on other targets), so most probes touch a single
+ * slot.
+ *
+ * Probing is linear from the home slot. Removal shifts later entries of the
+ * run back into the hole instead of leaving a tombstone, so lookups never
+ * slow down after many deletions.
+ *
+ * The table grows by doubling when it would exceed
+ * CUTILS_HASHMAP_MAX_LOAD_PERCENT. Slot and value pointers are invalidated
+ * by any insert or remove.
+ */
+typedef uint64_t (*hashmap_hash_fn) (const void *key, size_t key_size);
+typedef bool (*hashmap_equal_fn) (const void *a, const void *b,
+                                  size_t key_size);
+
+typedef struct
+{
+  uint8_t *ctrl;
+  unsigned char *slots;
+  size_t capacity;
+  size_t size;
+  size_t growth_left;
+  size_t key_size;
+  size_t value_size;
+  size_t value_offset;
+  size_t slot_size;
+  hashmap_hash_fn hash;
+  hashmap_equal_fn equal;
+  cutils_allocator_t *allocator;
+} hashmap_t;
+
+typedef struct
+{
+  hashmap_t *map;
+  size_t index;
+} hashmap_iterator_t;
+
+typedef enum
+{
+  HASHMAP_OK = 0,
+  HASHMAP_NULL_PTR = 1,
+  HASHMAP_NO_MEMORY = 2,
+  HASHMAP_INVALID_ARG = 3,
+  HASHMAP_KEY_EXISTS = 4,
+  HASHMAP_KEY_NOT_FOUND = 5,
+  HASHMAP_TIMEOUT = 6,
+  HASHMAP_OVERFLOW = 7
+} hashmap_result_t;
+
+/**
+ * Gets the last hash map operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] hashmap_result_t hashmap_get_error (void);
+
+/**
+ * Hashes a byte string. This is the default hash function.
+ *
+ * @param key Bytes to hash
+ * @param key_size Number of bytes
+ * @return 64-bit hash
+ */
+uint64_t hashmap_hash_bytes (const void *key, size_t key_size);
+
+/**
+ * Creates a new hash map with the specified allocator.
+ *
+ * @param key_size Size of key in bytes
+ * @param value_size Size of value in bytes (may be 0 for a set)
+ * @param hash Key hash function, or NULL for hashmap_hash_bytes
+ * @param equal Key equality function, or NULL to compare bytes
+ * @param allocator Allocator to use
+ * @return Newly allocated map or NULL on error
+ * @note Sets error to HASHMAP_INVALID_ARG if key_size is 0 or allocator is
+ *       NULL
+ * @note Sets error to HASHMAP_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] hashmap_t *
+hashmap_create_with_allocator (size_t key_size, size_t value_size,
+                               hashmap_hash_fn hash, hashmap_equal_fn equal,
+                               cutils_allocator_t *allocator);
+
+/**
+ * Creates a new hash map using the default allocator.
+ *
+ * @param key_size Size of key in bytes
+ * @param value_size Size of value in bytes (may be 0 for a set)
+ * @param hash Key hash function, or NULL for hashmap_hash_bytes
+ * @param equal Key equality function, or NULL to compare bytes
+ * @return Newly allocated map or NULL on error
+ */
+[[nodiscard]] hashmap_t *hashmap_create (size_t key_size, size_t value_size,
+                                         hashmap_hash_fn hash,
+                                         hashmap_equal_fn equal);
+
+/**
+ * Destroys a map and frees all allocated memory.
+ *
+ * @param map Map to destroy
+ */
+void hashmap_destroy (hashmap_t *map);
+
+/**
+ * Inserts a key-value pair with timeout.
+ *
+ * @param map Map to insert into
+ * @param key Key to insert
+ * @param value Value to insert (may be NULL if value_size is 0)
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to HASHMAP_NULL_PTR if map, key or a needed value is
+ *       NULL
+ * @note Sets error to HASHMAP_KEY_EXISTS if the key is already present
+ * @note Sets error to HASHMAP_NO_MEMORY if growing the table fails
+ * @note Sets error to HASHMAP_TIMEOUT if growing takes too long
+ */
+bool hashmap_insert_timeout (hashmap_t *map, const void *key,
+                             const void *value, uint32_t timeout_ms);
+
+/**
+ * Inserts a key-value pair.
+ *
+ * @param map Map to insert into
+ * @param key Key to insert
+ * @param value Value to insert (may be NULL if value_size is 0)
+ * @return true if successful, false otherwise
+ */
+bool hashmap_insert (hashmap_t *map, const void *key, const void *value);
+
+/**
+ * Removes a key-value pair.
+ *
+ * @param map Map to remove from
+ * @param key Key to remove
+ * @param out_value Receives the removed value (optional)
+ * @return true if successful, false otherwise
+ * @note Sets error to HASHMAP_NULL_PTR if map or key is NULL
+ * @note Sets error to HASHMAP_KEY_NOT_FOUND if the key is absent
+ */
+bool hashmap_remove (hashmap_t *map, const void *key, void *out_value);
+
+/**
+ * Copies out the value for a key.
+ *
+ * @param map Map to search
+ * @param key Key to look up
+ * @param out_value Receives the value (optional)
+ * @return true if found, false otherwise
+ * @note Sets error to HASHMAP_NULL_PTR if map or key is NULL
+ * @note Sets error to HASHMAP_KEY_NOT_FOUND if the key is absent
+ */
+bool hashmap_get (const hashmap_t *map, const void *key, void *out_value);
+
+/**
+ * Gets a pointer to the value stored for a key.
+ *
+ * @param map Map to search
+ * @param key Key to look up
+ * @return Pointer to the value in its slot, or NULL if absent
+ * @note The pointer is invalidated by any insert or remove
+ */
+void *hashmap_get_ptr (const hashmap_t *map, const void *key);
+
+/**
+ * Checks if a key exists.
+ *
+ * @param map Map to search
+ * @param key Key to look up
+ * @return true if present, false otherwise
+ */
+bool hashmap_contains (const hashmap_t *map, const void *key);
+
+/**
+ * Grows the table so it can hold count entries without rehashing.
+ *
+ * @param map Map to grow
+ * @param count Number of entries to make room for
+ * @return true if successful, false otherwise
+ * @note Sets error to HASHMAP_NULL_PTR if map is NULL
+ * @note Sets error to HASHMAP_OVERFLOW if count is too large
+ * @note Sets error to HASHMAP_NO_MEMORY if allocation fails
+ */
+bool hashmap_reserve (hashmap_t *map, size_t count);
+
+/**
+ * Removes all entries, keeping the table allocated.
+ *
+ * @param map Map to clear
+ * @return true if successful, false otherwise
+ */
+bool hashmap_clear (hashmap_t *map);
+
+/**
+ * Gets the number of entries.
+ *
+ * @param map Map to query
+ * @return Number of entries, or 0 if map is NULL
+ */
+size_t hashmap_size (const hashmap_t *map);
+
+/**
+ * Checks if the map is empty.
+ *
+ * @param map Map to check
+ * @return true if empty or NULL, false otherwise
+ */
+bool hashmap_is_empty (const hashmap_t *map);
+
+/**
+ * Gets the number of slots in the table.
+ *
+ * @param map Map to query
+ * @return Slot count, or 0 if map is NULL
+ */
+size_t hashmap_capacity (const hashmap_t *map);
+
+/**
+ * Gets the memory usage of the map.
+ *
+ * @param map Map to query
+ * @return Memory usage in bytes, or 0 if map is NULL
+ */
+size_t hashmap_memory_usage (const hashmap_t *map);
+
+/**
+ * Creates an iterator at the first entry in table order.
+ *
+ * @param map Map to iterate
+ * @return Iterator at the first entry
+ */
+hashmap_iterator_t hashmap_begin (hashmap_t *map);
+
+/**
+ * Moves the iterator to the next entry.
+ *
+ * @param it Iterator to move
+ * @return true if successful, false if end of map
+ */
+bool hashmap_iterator_next (hashmap_iterator_t *it);
+
+/**
+ * Gets the current key-value pair.
+ *
+ * @param it Iterator to read
+ * @param out_key Receives the key (optional)
+ * @param out_value Receives the value (optional)
+ * @return true if successful, false if end of map
+ */
+bool hashmap_iterator_get (const hashmap_iterator_t *it, void *out_key,
+                           void *out_value);
+
+/**
+ * Sets the current value.
+ *
+ * @param it Iterator to modify
+ * @param value Value to set
+ * @return true if successful, false if end of map
+ */
+bool hashmap_iterator_set (hashmap_iterator_t *it, const void *value);
+
+/**
+ * Checks if the iterator is valid.
+ *
+ * @param it Iterator to check
+ * @return true if valid, false if end of map
+ */
+bool hashmap_iterator_is_valid (const hashmap_iterator_t *it);
+
+#endif // CUTILS_HASHMAP_H
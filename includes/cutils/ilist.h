@@ -0,0 +1,233 @@
+#ifndef CUTILS_ILIST_H
+#define CUTILS_ILIST_H
+
+#include "cutils/config.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Intrusive doubly-linked list. Objects embed a cutils_ilist_node_t and are
+ * linked in place, so the list never allocates or copies. An object can be
+ * in several lists at once by embedding one node per list.
+ *
+ * The list is circular around a sentinel stored in cutils_ilist_t. A node
+ * whose links are NULL, such as a zero-initialized one, is unlinked.
+ * Unlinking needs only the node.
+ */
+typedef struct cutils_ilist_node
+{
+  struct cutils_ilist_node *next;
+  struct cutils_ilist_node *prev;
+} cutils_ilist_node_t;
+
+typedef struct
+{
+  cutils_ilist_node_t head;
+} cutils_ilist_t;
+
+typedef enum
+{
+  CUTILS_ILIST_OK = 0,
+  CUTILS_ILIST_NULL_PTR = 1,
+  CUTILS_ILIST_INVALID_ARG = 2,
+  CUTILS_ILIST_EMPTY = 3
+} cutils_ilist_result_t;
+
+/**
+ * Gets the object containing a list node.
+ *
+ * @param node Pointer to the embedded cutils_ilist_node_t
+ * @param type Type of the containing object
+ * @param member Name of the node member within type
+ */
+#define CUTILS_ILIST_ENTRY(node, type, member)                                \
+  ((type *)(void *)((char *)(node) - offsetof (type, member)))
+
+/**
+ * Iterates over the nodes of a list from front to back. The current node
+ * must not be unlinked inside the loop; use CUTILS_ILIST_FOREACH_SAFE.
+ */
+#define CUTILS_ILIST_FOREACH(node, list)                                      \
+  for (cutils_ilist_node_t *node = (list)->head.next; node != &(list)->head;  \
+       node = node->next)
+
+/**
+ * Iterates over the nodes of a list from front to back, allowing the
+ * current node to be unlinked.
+ */
+#define CUTILS_ILIST_FOREACH_SAFE(node, tmp, list)                            \
+  for (cutils_ilist_node_t *node = (list)->head.next, *tmp = node->next;      \
+       node != &(list)->head; node = tmp, tmp = node->next)
+
+/**
+ * Gets the last intrusive list operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] cutils_ilist_result_t cutils_ilist_get_error (void);
+
+/**
+ * Initializes an empty list.
+ *
+ * @param list List to initialize
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if list is NULL
+ */
+void cutils_ilist_init (cutils_ilist_t *list);
+
+/**
+ * Marks a node as unlinked.
+ *
+ * @param node Node to initialize
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if node is NULL
+ */
+void cutils_ilist_node_init (cutils_ilist_node_t *node);
+
+/**
+ * Checks whether a node is currently in a list.
+ *
+ * @param node Node to check
+ * @return true if linked, false otherwise
+ */
+bool cutils_ilist_is_linked (const cutils_ilist_node_t *node);
+
+/**
+ * Checks whether a list is empty.
+ *
+ * @param list List to check
+ * @return true if empty or NULL, false otherwise
+ */
+bool cutils_ilist_is_empty (const cutils_ilist_t *list);
+
+/**
+ * Counts the nodes in a list.
+ *
+ * @param list List to count
+ * @return Number of nodes, or 0 if list is NULL
+ * @note O(n); the list keeps no length so unlinking needs no list pointer
+ */
+size_t cutils_ilist_length (const cutils_ilist_t *list);
+
+/**
+ * Links a node at the front of a list.
+ *
+ * @param list List to add to
+ * @param node Unlinked node to add
+ * @return true if successful, false otherwise
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to CUTILS_ILIST_INVALID_ARG if node is already linked
+ */
+bool cutils_ilist_push_front (cutils_ilist_t *list, cutils_ilist_node_t *node);
+
+/**
+ * Links a node at the back of a list.
+ *
+ * @param list List to add to
+ * @param node Unlinked node to add
+ * @return true if successful, false otherwise
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to CUTILS_ILIST_INVALID_ARG if node is already linked
+ */
+bool cutils_ilist_push_back (cutils_ilist_t *list, cutils_ilist_node_t *node);
+
+/**
+ * Links a node directly before another node.
+ *
+ * @param pos Linked node to insert before
+ * @param node Unlinked node to add
+ * @return true if successful, false otherwise
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to CUTILS_ILIST_INVALID_ARG if pos is unlinked or node is
+ *       linked
+ */
+bool cutils_ilist_insert_before (cutils_ilist_node_t *pos,
+                                 cutils_ilist_node_t *node);
+
+/**
+ * Links a node directly after another node.
+ *
+ * @param pos Linked node to insert after
+ * @param node Unlinked node to add
+ * @return true if successful, false otherwise
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to CUTILS_ILIST_INVALID_ARG if pos is unlinked or node is
+ *       linked
+ */
+bool cutils_ilist_insert_after (cutils_ilist_node_t *pos,
+                                cutils_ilist_node_t *node);
+
+/**
+ * Unlinks a node from whatever list holds it, in O(1).
+ *
+ * @param node Node to unlink; unlinking an unlinked node does nothing
+ * @return true if successful, false otherwise
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if node is NULL
+ */
+bool cutils_ilist_unlink (cutils_ilist_node_t *node);
+
+/**
+ * Unlinks and returns the first node.
+ *
+ * @param list List to remove from
+ * @return Removed node, or NULL if the list is empty
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if list is NULL
+ * @note Sets error to CUTILS_ILIST_EMPTY if the list is empty
+ */
+cutils_ilist_node_t *cutils_ilist_pop_front (cutils_ilist_t *list);
+
+/**
+ * Unlinks and returns the last node.
+ *
+ * @param list List to remove from
+ * @return Removed node, or NULL if the list is empty
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if list is NULL
+ * @note Sets error to CUTILS_ILIST_EMPTY if the list is empty
+ */
+cutils_ilist_node_t *cutils_ilist_pop_back (cutils_ilist_t *list);
+
+/**
+ * Gets the first node.
+ *
+ * @param list List to query
+ * @return First node, or NULL if the list is empty
+ */
+cutils_ilist_node_t *cutils_ilist_front (const cutils_ilist_t *list);
+
+/**
+ * Gets the last node.
+ *
+ * @param list List to query
+ * @return Last node, or NULL if the list is empty
+ */
+cutils_ilist_node_t *cutils_ilist_back (const cutils_ilist_t *list);
+
+/**
+ * Gets the node after another node.
+ *
+ * @param list List holding node
+ * @param node Current node
+ * @return Next node, or NULL at the end of the list
+ */
+cutils_ilist_node_t *cutils_ilist_next (const cutils_ilist_t *list,
+                                        const cutils_ilist_node_t *node);
+
+/**
+ * Gets the node before another node.
+ *
+ * @param list List holding node
+ * @param node Current node
+ * @return Previous node, or NULL at the start of the list
+ */
+cutils_ilist_node_t *cutils_ilist_prev (const cutils_ilist_t *list,
+                                        const cutils_ilist_node_t *node);
+
+/**
+ * Moves every node of src to the back of dst in O(1).
+ *
+ * @param dst List receiving the nodes
+ * @param src List giving up its nodes; left empty
+ * @return true if successful, false otherwise
+ * @note Sets error to CUTILS_ILIST_NULL_PTR if any parameter is NULL
+ */
+bool cutils_ilist_splice (cutils_ilist_t *dst, cutils_ilist_t *src);
+
+#endif // CUTILS_ILIST_H
@@ -0,0 +1,225 @@
+#ifndef CUTILS_INT_VECTOR_H
+#define CUTILS_INT_VECTOR_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include "cutils/vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compressed vector of unsigned 64-bit integers.
+ *
+ * INT_VECTOR_FIXED packs every value in the same number of bits. The width
+ *   grows (with a one-off repack) when a wider value is stored. Random access
+ *   is O(1).
+ * INT_VECTOR_DELTA splits values into blocks of CUTILS_INT_VECTOR_BLOCK_SIZE.
+ *   Each block keeps its first value and smallest delta; the remaining
+ *   deltas are stored relative to that minimum at the block's own bit
+ *   width. Sorted or near-sorted data such as timestamps shrink the most.
+ *   Random access decodes within one block.
+ * INT_VECTOR_VARINT appends LEB128 varints, with the byte offset of every
+ *   block recorded for block-local random access. It is append-only.
+ */
+typedef enum
+{
+  INT_VECTOR_FIXED = 0,
+  INT_VECTOR_DELTA = 1,
+  INT_VECTOR_VARINT = 2
+} int_vector_mode_t;
+
+typedef struct
+{
+  uint64_t first;
+  uint64_t min_delta;
+  size_t offset;
+  uint8_t width;
+} int_vector_block_t;
+
+typedef struct
+{
+  int_vector_mode_t mode;
+  uint8_t width;
+  uint8_t *data;
+  size_t data_len;
+  size_t data_capacity;
+  int_vector_block_t *blocks;
+  size_t block_count;
+  size_t block_capacity;
+  uint64_t *pending;
+  size_t len;
+  cutils_allocator_t *allocator;
+} int_vector_t;
+
+typedef enum
+{
+  INT_VECTOR_OK = 0,
+  INT_VECTOR_NULL_PTR = 1,
+  INT_VECTOR_NO_MEMORY = 2,
+  INT_VECTOR_INVALID_ARG = 3,
+  INT_VECTOR_OUT_OF_RANGE = 4,
+  INT_VECTOR_OVERFLOW = 5,
+  INT_VECTOR_TIMEOUT = 6
+} int_vector_result_t;
+
+/**
+ * Gets the last compressed integer vector operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] int_vector_result_t int_vector_get_error (void);
+
+/**
+ * Creates a new compressed integer vector with the specified allocator.
+ *
+ * @param mode Encoding to use
+ * @param bit_width Initial bits per value for INT_VECTOR_FIXED (0 to start
+ *        at 1 bit and grow on demand); ignored by the other modes
+ * @param allocator Allocator to use
+ * @return Newly allocated vector or NULL on error
+ * @note Sets error to INT_VECTOR_INVALID_ARG if mode is unknown, bit_width
+ *       exceeds 64 or allocator is NULL
+ * @note Sets error to INT_VECTOR_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] int_vector_t *
+int_vector_create_with_allocator (int_vector_mode_t mode, uint8_t bit_width,
+                                  cutils_allocator_t *allocator);
+
+/**
+ * Creates a new compressed integer vector using the default allocator.
+ *
+ * @param mode Encoding to use
+ * @param bit_width Initial bits per value for INT_VECTOR_FIXED
+ * @return Newly allocated vector or NULL on error
+ */
+[[nodiscard]] int_vector_t *int_vector_create (int_vector_mode_t mode,
+                                               uint8_t bit_width);
+
+/**
+ * Frees all memory associated with the vector.
+ *
+ * @param iv Vector to destroy
+ * @note Sets error to INT_VECTOR_NULL_PTR if iv is NULL
+ */
+void int_vector_destroy (int_vector_t *iv);
+
+/**
+ * Appends a value with timeout.
+ *
+ * @param iv Vector to append to
+ * @param value Value to append
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to INT_VECTOR_NULL_PTR if iv is NULL
+ * @note Sets error to INT_VECTOR_NO_MEMORY if growing fails
+ * @note Sets error to INT_VECTOR_TIMEOUT if growing takes too long
+ */
+bool int_vector_push_timeout (int_vector_t *iv, uint64_t value,
+                              uint32_t timeout_ms);
+
+/**
+ * Appends a value.
+ *
+ * @param iv Vector to append to
+ * @param value Value to append
+ * @return true if successful, false otherwise
+ */
+bool int_vector_push (int_vector_t *iv, uint64_t value);
+
+/**
+ * Appends every element of a vector of 4- or 8-byte unsigned integers.
+ *
+ * In INT_VECTOR_FIXED mode the width is widened once up front to fit the
+ * largest value. The append is all-or-nothing in every mode: a failed call
+ * leaves the vector holding exactly its previous values.
+ *
+ * @param iv Vector to append to
+ * @param src Vector with elem_len 4 or 8
+ * @return true if successful, false otherwise
+ * @note Sets error to INT_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to INT_VECTOR_INVALID_ARG if src's elem_len is not 4 or 8
+ * @note Sets error to INT_VECTOR_NO_MEMORY if growing fails
+ */
+bool int_vector_push_vector (int_vector_t *iv, const vector_t *src);
+
+/**
+ * Gets the value at an index.
+ *
+ * @param iv Vector to read
+ * @param index Index of the value
+ * @param out Receives the value
+ * @return true if successful, false otherwise
+ * @note O(1) for INT_VECTOR_FIXED; decodes up to one block otherwise
+ * @note Sets error to INT_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to INT_VECTOR_OUT_OF_RANGE if index is out of bounds
+ */
+bool int_vector_get (const int_vector_t *iv, size_t index, uint64_t *out);
+
+/**
+ * Overwrites the value at an index.
+ *
+ * @param iv Vector to modify
+ * @param index Index of the value
+ * @param value New value
+ * @return true if successful, false otherwise
+ * @note Only supported in INT_VECTOR_FIXED mode
+ * @note Sets error to INT_VECTOR_NULL_PTR if iv is NULL
+ * @note Sets error to INT_VECTOR_INVALID_ARG for the other modes
+ * @note Sets error to INT_VECTOR_OUT_OF_RANGE if index is out of bounds
+ * @note Sets error to INT_VECTOR_NO_MEMORY if widening fails
+ */
+bool int_vector_set (int_vector_t *iv, size_t index, uint64_t value);
+
+/**
+ * Decodes a range of values and appends them to a vector.
+ *
+ * @param iv Vector to decode
+ * @param start Index of the first value
+ * @param count Number of values to decode
+ * @param out Vector with elem_len 4 or 8 to append to
+ * @return true if successful, false otherwise
+ * @note Uses AVX2 to unpack fixed-width data up to 25 bits when available
+ * @note Sets error to INT_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to INT_VECTOR_INVALID_ARG if out's elem_len is not 4 or 8
+ * @note Sets error to INT_VECTOR_OUT_OF_RANGE if the range is out of bounds
+ * @note Sets error to INT_VECTOR_OVERFLOW if a value does not fit in 4 bytes
+ * @note Sets error to INT_VECTOR_NO_MEMORY if growing out fails
+ */
+bool int_vector_decode (const int_vector_t *iv, size_t start, size_t count,
+                        vector_t *out);
+
+/**
+ * Removes all values, keeping allocated memory.
+ *
+ * @param iv Vector to clear
+ * @return true if successful, false otherwise
+ * @note Sets error to INT_VECTOR_NULL_PTR if iv is NULL
+ */
+bool int_vector_clear (int_vector_t *iv);
+
+/**
+ * Gets the number of values.
+ *
+ * @param iv Vector to query
+ * @return Number of values, or 0 if iv is NULL
+ */
+size_t int_vector_length (const int_vector_t *iv);
+
+/**
+ * Gets the current bits per value of an INT_VECTOR_FIXED vector.
+ *
+ * @param iv Vector to query
+ * @return Bit width, or 0 for the other modes or if iv is NULL
+ */
+uint8_t int_vector_bit_width (const int_vector_t *iv);
+
+/**
+ * Calculates total memory usage of the vector.
+ *
+ * @param iv Vector to measure
+ * @return Total bytes used, or 0 if iv is NULL
+ */
+size_t int_vector_memory_usage (const int_vector_t *iv);
+
+#endif // CUTILS_INT_VECTOR_H
@@ -6,13 +6,33 @@
 #include "cutils/config.h"
 #include "cutils/allocator.h"
 
+/*
+ * Each node is a single allocation: the links followed by the element,
+ * stored inline and aligned for any type.
+ *
+ * Indexed access walks from whichever of the head, the tail or the cached
+ * cursor is closest, and leaves the cursor on the node it reached. Loops
+ * over consecutive indices therefore take O(1) per step. Because even
+ * list_get moves the cursor, concurrent reads of one list need the same
+ * external locking as writes.
+ */
 typedef struct list_node
 {
-  void *data;
   struct list_node *next;
   struct list_node *prev;
+  alignas (max_align_t) unsigned char data[];
 } list_node_t;
 
+/*
+ * Cached position of the last indexed access. It lives in the same
+ * allocation as the list, behind a pointer, so const lookups can update it.
+ */
+typedef struct
+{
+  list_node_t *node;
+  size_t index;
+} list_cursor_t;
+
 typedef struct
 {
   list_node_t *head;
@@ -20,6 +40,7 @@ typedef struct
   size_t len;
   size_t elem_len;
   cutils_allocator_t *allocator;
+  list_cursor_t *cursor;
 } list_t;
 
 typedef enum
@@ -60,6 +81,28 @@ typedef enum
  */
 [[nodiscard]] list_t *list_create (size_t elem_len);
 
+/**
+ * Creates a deep copy of a list using the source list's allocator.
+ *
+ * @param list List to copy
+ * @return Newly allocated copy or NULL on error
+ * @note Sets error to LIST_NULL_PTR if list is NULL
+ * @note Sets error to LIST_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] list_t *list_copy (const list_t *list);
+
+/**
+ * Transfers all nodes of one list to another in O(1).
+ *
+ * @param dst List receiving the nodes; its old nodes are released
+ * @param src List giving up its nodes; left empty
+ * @return true if successful, false otherwise
+ * @note Both lists must share the same allocator and element size
+ * @note Sets error to LIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to LIST_INVALID_ARG if allocators or sizes differ
+ */
+bool list_move (list_t *dst, list_t *src);
+
 /**
  * Destroys list and frees all allocated memory.
  *
@@ -185,6 +228,8 @@ bool list_clear (list_t *list);
  * @return true if successful, false otherwise
  * @note Sets error to LIST_NULL_PTR if list is NULL
  * @note Sets error to LIST_INVALID_ARG if index > size
+ * @note Moves the shared cursor, so it is not safe to call concurrently
+ *       with any other operation on the same list, including list_get
  */
 bool list_get (const list_t *list, size_t index, void *out);
 
@@ -239,6 +284,47 @@ bool list_insert (list_t *list, size_t index, const void *elem);
  */
 bool list_remove (list_t *list, size_t index, void *out);
 
+/**
+ * Moves every node of src into dst before the specified index. Nodes are
+ * relinked, not copied.
+ *
+ * @param dst List receiving the nodes
+ * @param index Position in dst to insert at (dst length = append)
+ * @param src List giving up its nodes; left empty
+ * @return true if successful, false otherwise
+ * @note Sets error to LIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to LIST_INVALID_ARG if dst and src are the same list, or
+ *       differ in element size or allocator
+ * @note Sets error to LIST_OUT_OF_RANGE if index > dst length
+ */
+bool list_splice (list_t *dst, size_t index, list_t *src);
+
+/**
+ * Merges sorted src into sorted dst by relinking nodes. Equal elements keep
+ * their order, with those from dst first.
+ *
+ * @param dst Sorted list receiving the nodes
+ * @param src Sorted list giving up its nodes; left empty
+ * @param compare Element comparison function
+ * @return true if successful, false otherwise
+ * @note Sets error to LIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to LIST_INVALID_ARG if dst and src are the same list, or
+ *       differ in element size or allocator
+ */
+bool list_merge (list_t *dst, list_t *src,
+                 int (*compare) (const void *a, const void *b));
+
+/**
+ * Sorts the list with a stable bottom-up merge sort. Only the links are
+ * rewritten: no element is copied and nothing is allocated.
+ *
+ * @param list List to sort
+ * @param compare Element comparison function
+ * @return true if successful, false otherwise
+ * @note Sets error to LIST_NULL_PTR if any parameter is NULL
+ */
+bool list_sort (list_t *list, int (*compare) (const void *a, const void *b));
+
 /**
  * Gets the current length of the list.
  *
@@ -344,4 +430,41 @@ bool list_iterator_set (list_iterator_t *it, const void *elem);
  */
 bool list_iterator_is_valid (const list_iterator_t *it);
 
+/**
+ * Inserts a value before the iterator's element with timeout.
+ *
+ * @param it Iterator giving the position; an iterator past the end appends
+ * @param elem Element to insert
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note On success the iterator points at the inserted element
+ * @note Sets error to LIST_NULL_PTR if any parameter or it->list is NULL
+ * @note Sets error to LIST_NO_MEMORY if allocation fails
+ */
+bool list_insert_at_timeout (list_iterator_t *it, const void *elem,
+                             uint32_t timeout_ms);
+
+/**
+ * Inserts a value before the iterator's element in O(1).
+ *
+ * @param it Iterator giving the position; an iterator past the end appends
+ * @param elem Element to insert
+ * @return true if successful, false otherwise
+ * @note On success the iterator points at the inserted element
+ */
+bool list_insert_at (list_iterator_t *it, const void *elem);
+
+/**
+ * Removes the iterator's element in O(1).
+ *
+ * @param it Iterator at the element to remove
+ * @param out Output parameter to store the removed value (optional)
+ * @return true if successful, false otherwise
+ * @note On success the iterator points at the following element, or past
+ *       the end if the last element was removed
+ * @note Sets error to LIST_NULL_PTR if it or it->list is NULL
+ * @note Sets error to LIST_OUT_OF_RANGE if the iterator is past the end
+ */
+bool list_remove_at (list_iterator_t *it, void *out);
+
 #endif // CUTILS_LIST_H
@@ -3,17 +3,45 @@
 
 #include "cutils/allocator.h"
 #include "cutils/config.h"
+#include <stdalign.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
+/*
+ * Built-in key kinds. With any kind but MAP_KEY_CUSTOM the comparison is
+ * inlined into the tree descent instead of called through map_t.compare.
+ *
+ * MAP_KEY_BYTES orders keys with memcmp over key_size bytes. A
+ * MAP_KEY_STRING key starts with a uint32_t length followed by that many
+ * bytes, at most key_size - sizeof (uint32_t); bytes past the length are
+ * ignored. Strings order by their bytes, then by length.
+ */
+typedef enum
+{
+  MAP_KEY_CUSTOM = 0,
+  MAP_KEY_I32,
+  MAP_KEY_U32,
+  MAP_KEY_I64,
+  MAP_KEY_U64,
+  MAP_KEY_BYTES,
+  MAP_KEY_STRING
+} map_key_kind_t;
+
+/*
+ * Each node is a single allocation: the links followed by the key, then the
+ * value at map_t.value_offset. The key is aligned for any type and the value
+ * for its size. subtree_size fills padding after is_red and is only kept up
+ * to date once map_enable_order_statistics has been called.
+ */
 typedef struct map_node
 {
-  void *key;
-  void *value;
   struct map_node *left;
   struct map_node *right;
   struct map_node *parent;
   bool is_red;
+  uint32_t subtree_size;
+  alignas (max_align_t) unsigned char data[];
 } map_node_t;
 
 typedef struct
@@ -22,7 +50,10 @@ typedef struct
   size_t size;
   size_t key_size;
   size_t value_size;
+  size_t value_offset;
   cutils_allocator_t *allocator;
+  map_key_kind_t key_kind;
+  bool order_statistics;
   int (*compare) (const void *a, const void *b);
 } map_t;
 
@@ -63,6 +94,36 @@ map_t *map_create_with_allocator (size_t key_size, size_t value_size,
 map_t *map_create (size_t key_size, size_t value_size,
                    int (*compare) (const void *a, const void *b));
 
+/**
+ * Creates a new map for a built-in key kind with the specified allocator.
+ *
+ * @param kind Key kind, other than MAP_KEY_CUSTOM
+ * @param key_size Size of key in bytes; must match the kind for integers
+ * @param value_size Size of value in bytes
+ * @param allocator Allocator to use
+ * @return Newly allocated map or NULL on error
+ * @note map_t.compare is set to the kind's comparison, or NULL for
+ *       MAP_KEY_BYTES
+ * @note Sets error to MAP_INVALID_ARG if kind is MAP_KEY_CUSTOM or unknown,
+ *       or if key_size does not suit the kind
+ * @note Inserting a MAP_KEY_STRING key whose length does not fit in
+ *       key_size fails with MAP_INVALID_ARG
+ */
+map_t *map_create_keyed_with_allocator (map_key_kind_t kind, size_t key_size,
+                                        size_t value_size,
+                                        cutils_allocator_t *allocator);
+
+/**
+ * Creates a new map for a built-in key kind using the default allocator.
+ *
+ * @param kind Key kind, other than MAP_KEY_CUSTOM
+ * @param key_size Size of key in bytes; must match the kind for integers
+ * @param value_size Size of value in bytes
+ * @return Newly allocated map or NULL on error
+ */
+map_t *map_create_keyed (map_key_kind_t kind, size_t key_size,
+                         size_t value_size);
+
 /**
  * Destroys map and frees all allocated memory.
  *
@@ -92,6 +153,143 @@ bool map_insert_timeout (map_t *map, const void *key, const void *value,
  */
 bool map_insert (map_t *map, const void *key, const void *value);
 
+/**
+ * Finds a key, inserting it if absent, with timeout. Takes one descent.
+ *
+ * @param map Map to search
+ * @param key Key to find or insert
+ * @param value Value for a new entry, or NULL to zero-initialize it
+ * @param inserted Set to true if the key was inserted (optional)
+ * @param timeout_ms Timeout in milliseconds
+ * @return Pointer to the value stored for the key, or NULL on error
+ * @note The pointer stays valid until the key is removed
+ * @note Sets error to MAP_NULL_PTR if map or key is NULL
+ * @note Sets error to MAP_NO_MEMORY if allocation fails
+ * @note Sets error to MAP_TIMEOUT if allocation takes too long
+ */
+void *map_get_or_insert_timeout (map_t *map, const void *key,
+                                 const void *value, bool *inserted,
+                                 uint32_t timeout_ms);
+
+/**
+ * Finds a key, inserting it if absent. Takes one descent.
+ *
+ * @param map Map to search
+ * @param key Key to find or insert
+ * @param value Value for a new entry, or NULL to zero-initialize it
+ * @param inserted Set to true if the key was inserted (optional)
+ * @return Pointer to the value stored for the key, or NULL on error
+ */
+void *map_get_or_insert (map_t *map, const void *key, const void *value,
+                         bool *inserted);
+
+/**
+ * Inserts a key-value pair, or overwrites the value if the key exists, with
+ * timeout. Takes one descent.
+ *
+ * @param map Map to modify
+ * @param key Key to insert or update
+ * @param value Value to store
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to MAP_NULL_PTR if any parameter is NULL
+ * @note Sets error to MAP_NO_MEMORY if allocation fails
+ */
+bool map_insert_or_assign_timeout (map_t *map, const void *key,
+                                   const void *value, uint32_t timeout_ms);
+
+/**
+ * Inserts a key-value pair, or overwrites the value if the key exists.
+ *
+ * @param map Map to modify
+ * @param key Key to insert or update
+ * @param value Value to store
+ * @return true if successful, false otherwise
+ */
+bool map_insert_or_assign (map_t *map, const void *key, const void *value);
+
+/**
+ * Replaces the contents of the map with n pairs sorted by key, with
+ * timeout.
+ *
+ * The pairs are linked into a perfectly balanced tree in O(n) without any
+ * rebalancing, instead of n separate inserts.
+ *
+ * @param map Map to fill
+ * @param keys Array of n keys in strictly increasing order
+ * @param values Array of n values matching keys
+ * @param n Number of pairs
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note On failure the previous contents are left unchanged
+ * @note Sets error to MAP_NULL_PTR if map is NULL, or keys or values is
+ *       NULL with n > 0
+ * @note Sets error to MAP_INVALID_ARG if keys are not strictly increasing
+ * @note Sets error to MAP_NO_MEMORY if allocation fails
+ * @note Sets error to MAP_TIMEOUT if allocation takes too long
+ */
+bool map_build_from_sorted_timeout (map_t *map, const void *keys,
+                                    const void *values, size_t n,
+                                    uint32_t timeout_ms);
+
+/**
+ * Replaces the contents of the map with n pairs sorted by key.
+ *
+ * @param map Map to fill
+ * @param keys Array of n keys in strictly increasing order
+ * @param values Array of n values matching keys
+ * @param n Number of pairs
+ * @return true if successful, false otherwise
+ */
+bool map_build_from_sorted (map_t *map, const void *keys, const void *values,
+                            size_t n);
+
+/**
+ * Merges n pairs sorted by key into the map, with timeout.
+ *
+ * Existing and new entries are merged in one ordered pass and relinked into
+ * a balanced tree, in O(size + n). Keys already present take the new value.
+ *
+ * @param map Map to merge into
+ * @param keys Array of n keys in strictly increasing order
+ * @param values Array of n values matching keys
+ * @param n Number of pairs
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note On failure the map is left unchanged
+ * @note Sets error to MAP_NULL_PTR if map is NULL, or keys or values is
+ *       NULL with n > 0
+ * @note Sets error to MAP_INVALID_ARG if keys are not strictly increasing
+ * @note Sets error to MAP_NO_MEMORY if allocation fails
+ * @note Sets error to MAP_TIMEOUT if allocation takes too long
+ */
+bool map_merge_sorted_timeout (map_t *map, const void *keys,
+                               const void *values, size_t n,
+                               uint32_t timeout_ms);
+
+/**
+ * Merges n pairs sorted by key into the map.
+ *
+ * @param map Map to merge into
+ * @param keys Array of n keys in strictly increasing order
+ * @param values Array of n values matching keys
+ * @param n Number of pairs
+ * @return true if successful, false otherwise
+ */
+bool map_merge_sorted (map_t *map, const void *keys, const void *values,
+                       size_t n);
+
+/**
+ * Gets a pointer to the value stored for a key.
+ *
+ * @param map Map to search
+ * @param key Key to look up
+ * @return Pointer to the value, or NULL if the key is absent
+ * @note The pointer stays valid until the key is removed
+ * @note Sets error to MAP_KEY_NOT_FOUND if the key is absent
+ */
+void *map_find_ptr (const map_t *map, const void *key);
+
 /**
  * Removes a key-value pair from the map.
  *
@@ -162,6 +360,26 @@ size_t map_memory_usage (const map_t *map);
  */
 bool map_can_perform_operation (const map_t *map, size_t required_capacity);
 
+/**
+ * Gets the height of the tree.
+ *
+ * @param map Map to measure
+ * @return Number of nodes on the longest root-to-leaf path, at most
+ *         2 * log2(size + 1)
+ * @note O(n); intended for diagnostics
+ */
+size_t map_height (const map_t *map);
+
+/**
+ * Checks the key order, parent links and red-black properties of the tree.
+ *
+ * @param map Map to check
+ * @return true if the tree is a valid red-black tree, false otherwise
+ * @note O(n); intended for diagnostics and tests
+ * @note Sets error to MAP_NULL_PTR if map is NULL
+ */
+bool map_validate (const map_t *map);
+
 /**
  * Gets the last map operation error.
  *
@@ -175,6 +393,7 @@ typedef struct
   map_t *map;
   map_node_t *current;
   bool is_valid;
+  const void *upper; // exclusive bound for map_iterator_next, or NULL
 } map_iterator_t;
 
 /**
@@ -193,6 +412,104 @@ map_iterator_t map_begin (map_t *map);
  */
 map_iterator_t map_end (map_t *map);
 
+/**
+ * Creates an iterator at the first element whose key is not less than key.
+ *
+ * @param map Map to search
+ * @param key Key to search for
+ * @return Iterator at the element, invalid if every key is less than key
+ * @note O(log n)
+ */
+map_iterator_t map_lower_bound (map_t *map, const void *key);
+
+/**
+ * Creates an iterator at the first element whose key is greater than key.
+ *
+ * @param map Map to search
+ * @param key Key to search for
+ * @return Iterator at the element, invalid if no key is greater than key
+ * @note O(log n)
+ */
+map_iterator_t map_upper_bound (map_t *map, const void *key);
+
+/**
+ * Creates an iterator at the element with the greatest key not greater
+ * than key.
+ *
+ * @param map Map to search
+ * @param key Key to search for
+ * @return Iterator at the element, invalid if every key is greater than key
+ * @note O(log n)
+ */
+map_iterator_t map_floor (map_t *map, const void *key);
+
+/**
+ * Creates an iterator at the element with the smallest key not less than
+ * key. Same as map_lower_bound.
+ *
+ * @param map Map to search
+ * @param key Key to search for
+ * @return Iterator at the element, invalid if every key is less than key
+ * @note O(log n)
+ */
+map_iterator_t map_ceiling (map_t *map, const void *key);
+
+/**
+ * Creates an iterator over the keys in [low, high).
+ *
+ * The iterator starts at map_lower_bound (low), and map_iterator_next
+ * becomes invalid on reaching a key not less than high, so a scan costs
+ * O(log n + k) for k elements.
+ *
+ * @param map Map to iterate
+ * @param low Inclusive lower key, or NULL to start at the first element
+ * @param high Exclusive upper key, or NULL for no upper bound
+ * @return Iterator at the first element in range, invalid if none
+ * @note high is referenced, not copied, and must outlive the iterator
+ */
+map_iterator_t map_range (map_t *map, const void *low, const void *high);
+
+/**
+ * Starts maintaining subtree sizes so that map_select and map_rank run in
+ * O(log n).
+ *
+ * Sizes are computed for the current contents in O(n), then updated by every
+ * insert, remove and rotation at O(1) per level touched.
+ *
+ * @param map Map to augment
+ * @return true if successful, false otherwise
+ * @note Limits the map to UINT32_MAX entries; inserts past that fail with
+ *       MAP_OVERFLOW
+ * @note Sets error to MAP_NULL_PTR if map is NULL
+ * @note Sets error to MAP_OVERFLOW if the map already holds more entries
+ */
+bool map_enable_order_statistics (map_t *map);
+
+/**
+ * Creates an iterator at the element with the given rank in key order.
+ *
+ * @param map Map with order statistics enabled
+ * @param rank Zero-based rank; 0 is the smallest key
+ * @return Iterator at the element, invalid if rank >= size
+ * @note O(log n)
+ * @note Sets error to MAP_NULL_PTR if map is NULL
+ * @note Sets error to MAP_INVALID_ARG if order statistics are not enabled
+ * @note Sets error to MAP_KEY_NOT_FOUND if rank >= size
+ */
+map_iterator_t map_select (map_t *map, size_t rank);
+
+/**
+ * Counts the keys less than key. key need not be present.
+ *
+ * @param map Map with order statistics enabled
+ * @param key Key to rank
+ * @return Number of keys less than key, or 0 on error
+ * @note O(log n)
+ * @note Sets error to MAP_NULL_PTR if map or key is NULL
+ * @note Sets error to MAP_INVALID_ARG if order statistics are not enabled
+ */
+size_t map_rank (const map_t *map, const void *key);
+
 /**
  * Moves the iterator to the next element.
  *
@@ -0,0 +1,280 @@
+#ifndef CUTILS_MMAP_VECTOR_H
+#define CUTILS_MMAP_VECTOR_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include "cutils/vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * File-backed vector. The file starts with a 64-byte header followed by
+ * capacity elements, and the whole file is mapped shared. Opening an
+ * existing file maps it in place without reading or copying the elements.
+ *
+ * The header's checksum covers the first len elements. It is brought up to
+ * date by mmap_vector_sync and mmap_vector_close; in between, the header is
+ * marked dirty.
+ *
+ * Only available on POSIX hosts with CUTILS_ENABLE_MMAP set; elsewhere,
+ * opening fails with MMAP_VECTOR_UNSUPPORTED.
+ */
+typedef struct
+{
+  uint64_t magic;
+  uint32_t version;
+  uint32_t dirty;
+  uint64_t elem_len;
+  uint64_t len;
+  uint64_t capacity;
+  uint64_t checksum;
+  uint64_t reserved[2];
+} mmap_vector_header_t;
+
+typedef struct
+{
+  mmap_vector_header_t *header;
+  void *data;
+  size_t map_size;
+  size_t elem_len;
+  int fd;
+  uint32_t flags;
+  cutils_allocator_t *allocator;
+} mmap_vector_t;
+
+typedef enum
+{
+  MMAP_VECTOR_READ_WRITE = 0,
+  MMAP_VECTOR_READ_ONLY = 1 << 0,
+  MMAP_VECTOR_CREATE = 1 << 1,
+  MMAP_VECTOR_VERIFY = 1 << 2
+} mmap_vector_flags_t;
+
+typedef enum
+{
+  MMAP_VECTOR_OK = 0,
+  MMAP_VECTOR_NULL_PTR = 1,
+  MMAP_VECTOR_NO_MEMORY = 2,
+  MMAP_VECTOR_INVALID_ARG = 3,
+  MMAP_VECTOR_OUT_OF_RANGE = 4,
+  MMAP_VECTOR_OVERFLOW = 5,
+  MMAP_VECTOR_TIMEOUT = 6,
+  MMAP_VECTOR_IO_ERROR = 7,
+  MMAP_VECTOR_CORRUPT = 8,
+  MMAP_VECTOR_NOT_WRITABLE = 9,
+  MMAP_VECTOR_UNSUPPORTED = 10
+} mmap_vector_result_t;
+
+/**
+ * Gets the last mapped vector operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] mmap_vector_result_t mmap_vector_get_error (void);
+
+/**
+ * Opens a file-backed vector, allocating the handle with the specified
+ * allocator.
+ *
+ * @param path File to map
+ * @param elem_len Size of each element in bytes, or 0 to accept the size
+ *        stored in an existing file
+ * @param flags Combination of mmap_vector_flags_t values.
+ *        MMAP_VECTOR_CREATE creates the file if it does not exist.
+ *        MMAP_VECTOR_READ_ONLY maps the file read-only.
+ *        MMAP_VECTOR_VERIFY checks the stored checksum while opening.
+ * @param allocator Allocator for the handle
+ * @return Newly opened vector or NULL on error
+ * @note Sets error to MMAP_VECTOR_INVALID_ARG if elem_len does not match the
+ *       file or is 0 for a new file
+ * @note Sets error to MMAP_VECTOR_IO_ERROR if the file cannot be opened,
+ *       sized or mapped
+ * @note Sets error to MMAP_VECTOR_CORRUPT if the header is invalid, or with
+ *       MMAP_VECTOR_VERIFY if the file is dirty or the checksum differs
+ * @note Sets error to MMAP_VECTOR_UNSUPPORTED on platforms without mmap
+ */
+[[nodiscard]] mmap_vector_t *
+mmap_vector_open_with_allocator (const char *path, size_t elem_len,
+                                 uint32_t flags,
+                                 cutils_allocator_t *allocator);
+
+/**
+ * Opens a file-backed vector using the default allocator for the handle.
+ *
+ * @param path File to map
+ * @param elem_len Size of each element in bytes, or 0 for an existing file
+ * @param flags Combination of mmap_vector_flags_t values
+ * @return Newly opened vector or NULL on error
+ */
+[[nodiscard]] mmap_vector_t *mmap_vector_open (const char *path,
+                                               size_t elem_len,
+                                               uint32_t flags);
+
+/**
+ * Syncs a writable vector, unmaps it and closes the file.
+ *
+ * @param vec Vector to close
+ * @return true if the final sync succeeded, false otherwise
+ * @note The handle is released even if syncing fails
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to MMAP_VECTOR_IO_ERROR if syncing fails
+ */
+bool mmap_vector_close (mmap_vector_t *vec);
+
+/**
+ * Updates the checksum and flushes the mapping to disk.
+ *
+ * @param vec Vector to sync
+ * @return true if successful, false otherwise
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to MMAP_VECTOR_NOT_WRITABLE if vec is read-only
+ * @note Sets error to MMAP_VECTOR_IO_ERROR if msync fails
+ */
+bool mmap_vector_sync (mmap_vector_t *vec);
+
+/**
+ * Recomputes the checksum and compares it with the stored one.
+ *
+ * @param vec Vector to check
+ * @return true if the vector is clean and the checksum matches
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to MMAP_VECTOR_CORRUPT if the vector is dirty or the
+ *       checksum differs
+ */
+bool mmap_vector_verify (const mmap_vector_t *vec);
+
+/**
+ * Appends an element with timeout.
+ *
+ * @param vec Vector to append to
+ * @param elem Element to append
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ * @note Growing the file uses ftruncate and remaps it
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to MMAP_VECTOR_NOT_WRITABLE if vec is read-only
+ * @note Sets error to MMAP_VECTOR_IO_ERROR if growing the file fails
+ * @note Sets error to MMAP_VECTOR_TIMEOUT if growing takes too long
+ */
+bool mmap_vector_push_timeout (mmap_vector_t *vec, const void *elem,
+                               uint32_t timeout_ms);
+
+/**
+ * Appends an element.
+ *
+ * @param vec Vector to append to
+ * @param elem Element to append
+ * @return true if successful, false otherwise
+ */
+bool mmap_vector_push (mmap_vector_t *vec, const void *elem);
+
+/**
+ * Removes the last element.
+ *
+ * @param vec Vector to remove from
+ * @param out Receives the removed element (optional)
+ * @return true if successful, false otherwise
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to MMAP_VECTOR_NOT_WRITABLE if vec is read-only
+ * @note Sets error to MMAP_VECTOR_OUT_OF_RANGE if vec is empty
+ */
+bool mmap_vector_pop (mmap_vector_t *vec, void *out);
+
+/**
+ * Copies out the element at an index.
+ *
+ * @param vec Vector to read
+ * @param index Index of the element
+ * @param out Receives the element
+ * @return true if successful, false otherwise
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to MMAP_VECTOR_OUT_OF_RANGE if index is out of bounds
+ */
+bool mmap_vector_get (const mmap_vector_t *vec, size_t index, void *out);
+
+/**
+ * Overwrites the element at an index.
+ *
+ * @param vec Vector to modify
+ * @param index Index of the element
+ * @param elem New element
+ * @return true if successful, false otherwise
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to MMAP_VECTOR_NOT_WRITABLE if vec is read-only
+ * @note Sets error to MMAP_VECTOR_OUT_OF_RANGE if index is out of bounds
+ */
+bool mmap_vector_set (mmap_vector_t *vec, size_t index, const void *elem);
+
+/**
+ * Gets a pointer to the mapped elements.
+ *
+ * @param vec Vector to query
+ * @return Pointer to the first element, or NULL if vec is NULL
+ * @note Invalidated when the vector grows or is closed
+ */
+const void *mmap_vector_data (const mmap_vector_t *vec);
+
+/**
+ * Describes the mapped elements as a non-owning vector_t.
+ *
+ * The view lets read-only vector functions such as vector_find and
+ * vector_lower_bound run directly on the mapping. It has no allocator, so
+ * it cannot grow, and it must not be passed to vector_destroy.
+ *
+ * @param vec Vector to view
+ * @param out Receives the view
+ * @return true if successful, false otherwise
+ * @note The view is invalidated when the vector grows or is closed
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if any parameter is NULL
+ */
+bool mmap_vector_view (const mmap_vector_t *vec, vector_t *out);
+
+/**
+ * Grows the file so it holds at least capacity elements.
+ *
+ * @param vec Vector to grow
+ * @param capacity Minimum capacity
+ * @return true if successful, false otherwise
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to MMAP_VECTOR_NOT_WRITABLE if vec is read-only
+ * @note Sets error to MMAP_VECTOR_OVERFLOW if the file size would overflow
+ * @note Sets error to MMAP_VECTOR_IO_ERROR if resizing the file fails
+ */
+bool mmap_vector_reserve (mmap_vector_t *vec, size_t capacity);
+
+/**
+ * Removes all elements without shrinking the file.
+ *
+ * @param vec Vector to clear
+ * @return true if successful, false otherwise
+ * @note Sets error to MMAP_VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to MMAP_VECTOR_NOT_WRITABLE if vec is read-only
+ */
+bool mmap_vector_clear (mmap_vector_t *vec);
+
+/**
+ * Gets the number of elements.
+ *
+ * @param vec Vector to query
+ * @return Number of elements, or 0 if vec is NULL
+ */
+size_t mmap_vector_length (const mmap_vector_t *vec);
+
+/**
+ * Gets the number of elements the file can hold without growing.
+ *
+ * @param vec Vector to query
+ * @return Capacity, or 0 if vec is NULL
+ */
+size_t mmap_vector_capacity (const mmap_vector_t *vec);
+
+/**
+ * Gets the size of each element.
+ *
+ * @param vec Vector to query
+ * @return Element size in bytes, or 0 if vec is NULL
+ */
+size_t mmap_vector_element_size (const mmap_vector_t *vec);
+
+#endif // CUTILS_MMAP_VECTOR_H
@@ -0,0 +1,125 @@
+#ifndef CUTILS_MPSC_QUEUE_H
+#define CUTILS_MPSC_QUEUE_H
+
+#include "cutils/config.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Lock-free intrusive multi-producer/single-consumer FIFO (Vyukov). Items
+ * embed an mpsc_queue_node_t, so pushing never allocates. Any number of
+ * threads may push concurrently; push is wait-free, a single atomic
+ * exchange followed by a store. Only one thread at a time may pop.
+ *
+ * A producer that has swapped itself in but not yet linked its node leaves
+ * the queue briefly unable to reach later items. Pop then returns NULL with
+ * MPSC_QUEUE_RETRY instead of blocking.
+ *
+ * The queue holds a stub node and must not be moved or copied after
+ * mpsc_queue_init.
+ */
+typedef struct mpsc_queue_node
+{
+  _Atomic (struct mpsc_queue_node *) next;
+} mpsc_queue_node_t;
+
+typedef struct
+{
+  alignas (CUTILS_CACHE_LINE_SIZE) _Atomic (mpsc_queue_node_t *) head;
+  alignas (CUTILS_CACHE_LINE_SIZE) mpsc_queue_node_t *tail;
+  mpsc_queue_node_t stub;
+} mpsc_queue_t;
+
+typedef enum
+{
+  MPSC_QUEUE_OK = 0,
+  MPSC_QUEUE_NULL_PTR = 1,
+  MPSC_QUEUE_EMPTY = 2,
+  MPSC_QUEUE_RETRY = 3
+} mpsc_queue_result_t;
+
+/**
+ * Gets the object containing a queue node.
+ *
+ * @param node Pointer to the embedded mpsc_queue_node_t
+ * @param type Type of the containing object
+ * @param member Name of the node member within type
+ */
+#define MPSC_QUEUE_ENTRY(node, type, member)                                  \
+  ((type *)(void *)((char *)(node) - offsetof (type, member)))
+
+/**
+ * Gets the last MPSC queue operation error for the calling thread.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] mpsc_queue_result_t mpsc_queue_get_error (void);
+
+/**
+ * Initializes an empty queue.
+ *
+ * @param queue Queue to initialize
+ * @note Must complete before any thread pushes or pops
+ * @note Sets error to MPSC_QUEUE_NULL_PTR if queue is NULL
+ */
+void mpsc_queue_init (mpsc_queue_t *queue);
+
+/**
+ * Pushes a node. Safe to call from any number of threads at once.
+ *
+ * @param queue Queue to push to
+ * @param node Node to push; must not already be in a queue
+ * @return true if successful, false otherwise
+ * @note Wait-free
+ * @note Sets error to MPSC_QUEUE_NULL_PTR if any parameter is NULL
+ */
+bool mpsc_queue_push (mpsc_queue_t *queue, mpsc_queue_node_t *node);
+
+/**
+ * Pops the oldest node. Consumer thread only.
+ *
+ * @param queue Queue to pop from
+ * @return Popped node, or NULL if none is available
+ * @note Sets error to MPSC_QUEUE_NULL_PTR if queue is NULL
+ * @note Sets error to MPSC_QUEUE_EMPTY if the queue is empty
+ * @note Sets error to MPSC_QUEUE_RETRY if a push is in progress; calling
+ *       again shortly will make progress
+ */
+mpsc_queue_node_t *mpsc_queue_pop (mpsc_queue_t *queue);
+
+/**
+ * Pops every node that is currently reachable. Consumer thread only.
+ *
+ * The popped nodes are returned as a chain in FIFO order; walk it with
+ * mpsc_queue_next. Nodes may be pushed again once read.
+ *
+ * @param queue Queue to pop from
+ * @param count Receives the number of nodes popped (optional)
+ * @return First popped node, or NULL if none was available
+ * @note Stops early, setting MPSC_QUEUE_RETRY, at a push in progress
+ * @note Sets error to MPSC_QUEUE_NULL_PTR if queue is NULL
+ * @note Sets error to MPSC_QUEUE_EMPTY if nothing was popped and the queue
+ *       is empty
+ */
+mpsc_queue_node_t *mpsc_queue_pop_all (mpsc_queue_t *queue, size_t *count);
+
+/**
+ * Gets the next node in a chain returned by mpsc_queue_pop_all.
+ *
+ * @param node Current node
+ * @return Next node, or NULL at the end of the chain
+ */
+mpsc_queue_node_t *mpsc_queue_next (const mpsc_queue_node_t *node);
+
+/**
+ * Checks whether the queue is empty. Consumer thread only.
+ *
+ * @param queue Queue to check
+ * @return true if no node is queued or queue is NULL
+ * @note A push in progress may make this return false while pop still
+ *       returns NULL
+ */
+bool mpsc_queue_is_empty (mpsc_queue_t *queue);
+
+#endif // CUTILS_MPSC_QUEUE_H
@@ -58,6 +58,27 @@ queue_t *queue_create (size_t elem_size, size_t initial_capacity);
  */
 void queue_destroy (queue_t *queue);
 
+/**
+ * Copies the contents of one queue into another, reusing the destination's
+ * buffer and allocator.
+ *
+ * @param dst Queue to overwrite
+ * @param src Queue to copy from
+ * @return true if successful, false otherwise
+ * @note Only allocates when dst's capacity is smaller than src's size
+ */
+bool queue_copy_into (queue_t *dst, const queue_t *src);
+
+/**
+ * Transfers the buffer of one queue to another in O(1).
+ *
+ * @param dst Queue receiving the buffer; its old buffer is released
+ * @param src Queue giving up its buffer; left empty with zero capacity
+ * @return true if successful, false otherwise
+ * @note Both queues must share the same allocator and element size
+ */
+bool queue_move (queue_t *dst, queue_t *src);
+
 /**
  * Enqueues an element with timeout.
  *
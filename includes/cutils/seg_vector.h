@@ -0,0 +1,236 @@
+#ifndef CUTILS_SEG_VECTOR_H
+#define CUTILS_SEG_VECTOR_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Segmented vector. Elements live in chunks whose sizes double, chunk k
+ * holding (1 << CUTILS_SEG_VECTOR_BASE_SHIFT) << k elements. The chunk
+ * directory has a fixed size, so growth allocates one new chunk and never
+ * moves existing elements: element addresses stay valid until the element
+ * is popped or the vector is cleared, shrunk or destroyed.
+ */
+typedef struct
+{
+  void *chunks[CUTILS_SEG_VECTOR_MAX_CHUNKS];
+  size_t chunk_count;
+  size_t len;
+  size_t capacity;
+  size_t elem_len;
+  cutils_allocator_t *allocator;
+} seg_vector_t;
+
+typedef struct
+{
+  void *data;
+  size_t len;
+  size_t elem_len;
+  size_t first_index;
+} seg_vector_span_t;
+
+typedef enum
+{
+  SEG_VECTOR_OK = 0,
+  SEG_VECTOR_NULL_PTR = 1,
+  SEG_VECTOR_NO_MEMORY = 2,
+  SEG_VECTOR_INVALID_ARG = 3,
+  SEG_VECTOR_OUT_OF_RANGE = 4,
+  SEG_VECTOR_OVERFLOW = 5,
+  SEG_VECTOR_TIMEOUT = 6
+} seg_vector_result_t;
+
+/**
+ * Gets the last segmented vector operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] seg_vector_result_t seg_vector_get_error (void);
+
+/**
+ * Creates a new segmented vector with the specified allocator.
+ *
+ * No chunk is allocated until the first push or reserve.
+ *
+ * @param elem_len Size of each element in bytes
+ * @param allocator Allocator to use
+ * @return Newly allocated segmented vector or NULL on error
+ * @note Sets error to SEG_VECTOR_INVALID_ARG if elem_len is 0
+ * @note Sets error to SEG_VECTOR_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] seg_vector_t *
+seg_vector_create_with_allocator (size_t elem_len,
+                                  cutils_allocator_t *allocator);
+
+/**
+ * Creates a new segmented vector using the default allocator.
+ *
+ * @param elem_len Size of each element in bytes
+ * @return Newly allocated segmented vector or NULL on error
+ */
+[[nodiscard]] seg_vector_t *seg_vector_create (size_t elem_len);
+
+/**
+ * Frees all memory associated with the segmented vector.
+ *
+ * @param seg Segmented vector to destroy
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+void seg_vector_destroy (seg_vector_t *seg);
+
+/**
+ * Appends an element with timeout.
+ *
+ * @param seg Segmented vector to append to
+ * @param elem Element to append
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SEG_VECTOR_OVERFLOW if all chunks are in use
+ * @note Sets error to SEG_VECTOR_NO_MEMORY if the new chunk cannot be
+ *       allocated
+ */
+bool seg_vector_push_timeout (seg_vector_t *seg, const void *elem,
+                              uint32_t timeout_ms);
+
+/**
+ * Appends an element.
+ *
+ * @param seg Segmented vector to append to
+ * @param elem Element to append
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SEG_VECTOR_NO_MEMORY if the new chunk cannot be
+ *       allocated
+ */
+bool seg_vector_push (seg_vector_t *seg, const void *elem);
+
+/**
+ * Removes the last element.
+ *
+ * @param seg Segmented vector to pop from
+ * @param out Optional buffer to store the popped element
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ * @note Sets error to SEG_VECTOR_OUT_OF_RANGE if empty
+ */
+bool seg_vector_pop (seg_vector_t *seg, void *out);
+
+/**
+ * Gets the element at the specified index.
+ *
+ * @param seg Segmented vector to get from
+ * @param index Index of the element
+ * @param out Buffer to store the element
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SEG_VECTOR_OUT_OF_RANGE if index invalid
+ */
+bool seg_vector_get (const seg_vector_t *seg, size_t index, void *out);
+
+/**
+ * Sets the element at the specified index.
+ *
+ * @param seg Segmented vector to modify
+ * @param index Index of the element
+ * @param elem New element value
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SEG_VECTOR_OUT_OF_RANGE if index invalid
+ */
+bool seg_vector_set (seg_vector_t *seg, size_t index, const void *elem);
+
+/**
+ * Gets the stable address of the element at the specified index.
+ *
+ * @param seg Segmented vector to get from
+ * @param index Index of the element
+ * @return Pointer to the element or NULL on error
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ * @note Sets error to SEG_VECTOR_OUT_OF_RANGE if index invalid
+ */
+void *seg_vector_at (const seg_vector_t *seg, size_t index);
+
+/**
+ * Ensures capacity is at least the specified number of elements.
+ *
+ * @param seg Segmented vector to reserve capacity for
+ * @param capacity Minimum capacity to ensure
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ * @note Sets error to SEG_VECTOR_OVERFLOW if capacity too large
+ * @note Sets error to SEG_VECTOR_NO_MEMORY if allocation fails
+ */
+bool seg_vector_reserve (seg_vector_t *seg, size_t capacity);
+
+/**
+ * Releases chunks that hold no elements.
+ *
+ * @param seg Segmented vector to shrink
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+bool seg_vector_shrink (seg_vector_t *seg);
+
+/**
+ * Removes all elements, keeping the allocated chunks.
+ *
+ * @param seg Segmented vector to clear
+ * @return true if successful, false otherwise
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+bool seg_vector_clear (seg_vector_t *seg);
+
+/**
+ * Gets the number of chunks that currently hold elements.
+ *
+ * Chunks are disjoint, so they can be processed in parallel.
+ *
+ * @param seg Segmented vector to inspect
+ * @return Number of non-empty chunks
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+size_t seg_vector_chunk_count (const seg_vector_t *seg);
+
+/**
+ * Gets a contiguous view of the elements stored in one chunk.
+ *
+ * @param seg Segmented vector to view
+ * @param chunk Chunk index, below seg_vector_chunk_count
+ * @return Span over the chunk, with NULL data on error
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ * @note Sets error to SEG_VECTOR_OUT_OF_RANGE if chunk invalid
+ */
+seg_vector_span_t seg_vector_chunk (const seg_vector_t *seg, size_t chunk);
+
+/**
+ * Gets the number of elements.
+ *
+ * @param seg Segmented vector to get length from
+ * @return Number of elements
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+size_t seg_vector_length (const seg_vector_t *seg);
+
+/**
+ * Gets the capacity of the allocated chunks.
+ *
+ * @param seg Segmented vector to get capacity from
+ * @return Capacity in elements
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+size_t seg_vector_capacity (const seg_vector_t *seg);
+
+/**
+ * Gets memory usage statistics of the segmented vector.
+ *
+ * @param seg Segmented vector to get memory usage from
+ * @return Memory usage in bytes
+ * @note Sets error to SEG_VECTOR_NULL_PTR if seg is NULL
+ */
+size_t seg_vector_memory_usage (const seg_vector_t *seg);
+
+#endif // CUTILS_SEG_VECTOR_H
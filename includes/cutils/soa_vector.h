@@ -0,0 +1,297 @@
+#ifndef CUTILS_SOA_VECTOR_H
+#define CUTILS_SOA_VECTOR_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include "cutils/vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Structure-of-arrays vector. Each field of a record lives in its own
+ * contiguous column, so a pass over one field only touches that column.
+ * All columns share a single allocation and grow together.
+ */
+typedef struct
+{
+  void *data;
+  void *columns[CUTILS_SOA_MAX_COLUMNS];
+  size_t column_sizes[CUTILS_SOA_MAX_COLUMNS];
+  size_t column_count;
+  size_t len;
+  size_t capacity;
+  cutils_allocator_t *allocator;
+} soa_vector_t;
+
+typedef struct
+{
+  void *data;
+  size_t len;
+  size_t elem_len;
+} soa_vector_span_t;
+
+typedef enum
+{
+  SOA_VECTOR_OK = 0,
+  SOA_VECTOR_NULL_PTR = 1,
+  SOA_VECTOR_NO_MEMORY = 2,
+  SOA_VECTOR_INVALID_ARG = 3,
+  SOA_VECTOR_OUT_OF_RANGE = 4,
+  SOA_VECTOR_OVERFLOW = 5,
+  SOA_VECTOR_TIMEOUT = 6
+} soa_vector_result_t;
+
+/**
+ * Gets the last soa vector operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] soa_vector_result_t soa_vector_get_error (void);
+
+/**
+ * Creates a new soa vector with the specified allocator.
+ *
+ * @param column_sizes Size of each column element in bytes
+ * @param column_count Number of columns
+ * @param init_capacity Initial capacity (0 for default)
+ * @param allocator Allocator to use
+ * @return Newly allocated soa vector or NULL on error
+ * @note Sets error to SOA_VECTOR_INVALID_ARG if a column size is 0 or there
+ *       are more than CUTILS_SOA_MAX_COLUMNS columns
+ * @note Sets error to SOA_VECTOR_OVERFLOW if capacity too large
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] soa_vector_t *
+soa_vector_create_with_allocator (const size_t *column_sizes,
+                                  size_t column_count, size_t init_capacity,
+                                  cutils_allocator_t *allocator);
+
+/**
+ * Creates a new soa vector using the default allocator.
+ *
+ * @param column_sizes Size of each column element in bytes
+ * @param column_count Number of columns
+ * @param init_capacity Initial capacity (0 for default)
+ * @return Newly allocated soa vector or NULL on error
+ */
+[[nodiscard]] soa_vector_t *soa_vector_create (const size_t *column_sizes,
+                                               size_t column_count,
+                                               size_t init_capacity);
+
+/**
+ * Frees all memory associated with the soa vector.
+ *
+ * @param soa Soa vector to destroy
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ */
+void soa_vector_destroy (soa_vector_t *soa);
+
+/**
+ * Appends a record with timeout.
+ *
+ * @param soa Soa vector to append to
+ * @param fields One pointer per column to the field value
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if reallocation fails
+ */
+bool soa_vector_push_timeout (soa_vector_t *soa, const void *const *fields,
+                              uint32_t timeout_ms);
+
+/**
+ * Appends a record.
+ *
+ * @param soa Soa vector to append to
+ * @param fields One pointer per column to the field value
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if reallocation fails
+ */
+bool soa_vector_push (soa_vector_t *soa, const void *const *fields);
+
+/**
+ * Removes the last record.
+ *
+ * @param soa Soa vector to pop from
+ * @param out Optional, one buffer per column (entries may be NULL)
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if soa vector is empty
+ */
+bool soa_vector_pop (soa_vector_t *soa, void *const *out);
+
+/**
+ * Gets the record at the specified index.
+ *
+ * @param soa Soa vector to get from
+ * @param index Index of the record
+ * @param out One buffer per column (entries may be NULL to skip a field)
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if index invalid
+ */
+bool soa_vector_get (const soa_vector_t *soa, size_t index, void *const *out);
+
+/**
+ * Sets the record at the specified index.
+ *
+ * @param soa Soa vector to modify
+ * @param index Index of the record
+ * @param fields One pointer per column to the field value
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if index invalid
+ */
+bool soa_vector_set (soa_vector_t *soa, size_t index,
+                     const void *const *fields);
+
+/**
+ * Gets a single field of the record at the specified index.
+ *
+ * @param soa Soa vector to get from
+ * @param index Index of the record
+ * @param column Column of the field
+ * @param out Buffer to store the field
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if index or column invalid
+ */
+bool soa_vector_get_field (const soa_vector_t *soa, size_t index,
+                           size_t column, void *out);
+
+/**
+ * Sets a single field of the record at the specified index.
+ *
+ * @param soa Soa vector to modify
+ * @param index Index of the record
+ * @param column Column of the field
+ * @param value New field value
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if index or column invalid
+ */
+bool soa_vector_set_field (soa_vector_t *soa, size_t index, size_t column,
+                           const void *value);
+
+/**
+ * Gets a contiguous view of one column.
+ *
+ * Every column starts on a CUTILS_SOA_COLUMN_ALIGNMENT boundary. The span
+ * is invalidated by any operation that grows or reorders the soa vector.
+ *
+ * @param soa Soa vector to view
+ * @param column Column to view
+ * @return Span over the column, with NULL data on error
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if column invalid
+ */
+soa_vector_span_t soa_vector_column (const soa_vector_t *soa, size_t column);
+
+/**
+ * Ensures capacity is at least the specified number of records.
+ *
+ * @param soa Soa vector to reserve capacity for
+ * @param capacity Minimum capacity to ensure
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ * @note Sets error to SOA_VECTOR_OVERFLOW if capacity too large
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if reallocation fails
+ */
+bool soa_vector_reserve (soa_vector_t *soa, size_t capacity);
+
+/**
+ * Reorders all columns so that record i becomes old record perm[i].
+ *
+ * @param soa Soa vector to reorder
+ * @param perm Permutation of [0, length)
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if perm has an invalid index
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if allocation fails
+ */
+bool soa_vector_permute (soa_vector_t *soa, const size_t *perm);
+
+/**
+ * Sorts records by one column using a comparison function.
+ *
+ * The sort permutation is computed on the key column alone and then
+ * applied to every column.
+ *
+ * @param soa Soa vector to sort
+ * @param column Column to sort by
+ * @param compare Comparison function for column elements
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if column invalid
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if allocation fails
+ */
+bool soa_vector_sort_by_column (soa_vector_t *soa, size_t column,
+                                int (*compare) (const void *a,
+                                                const void *b));
+
+/**
+ * Sorts records by a fixed-width key column.
+ *
+ * Uses a stable radix sort when scratch memory is available.
+ *
+ * @param soa Soa vector to sort
+ * @param column Column to sort by
+ * @param key_type Type of the key stored in the column
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ * @note Sets error to SOA_VECTOR_OUT_OF_RANGE if column invalid
+ * @note Sets error to SOA_VECTOR_INVALID_ARG if the key size does not match
+ *       the column size
+ * @note Sets error to SOA_VECTOR_NO_MEMORY if allocation fails
+ */
+bool soa_vector_sort_by_key (soa_vector_t *soa, size_t column,
+                             vector_key_type_t key_type);
+
+/**
+ * Removes all records.
+ *
+ * @param soa Soa vector to clear
+ * @return true if successful, false otherwise
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ */
+bool soa_vector_clear (soa_vector_t *soa);
+
+/**
+ * Gets the number of records.
+ *
+ * @param soa Soa vector to get length from
+ * @return Number of records
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ */
+size_t soa_vector_length (const soa_vector_t *soa);
+
+/**
+ * Gets the record capacity.
+ *
+ * @param soa Soa vector to get capacity from
+ * @return Capacity in records
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ */
+size_t soa_vector_capacity (const soa_vector_t *soa);
+
+/**
+ * Gets the number of columns.
+ *
+ * @param soa Soa vector to get column count from
+ * @return Number of columns
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ */
+size_t soa_vector_column_count (const soa_vector_t *soa);
+
+/**
+ * Gets memory usage statistics of the soa vector.
+ *
+ * @param soa Soa vector to get memory usage from
+ * @return Memory usage in bytes
+ * @note Sets error to SOA_VECTOR_NULL_PTR if soa is NULL
+ */
+size_t soa_vector_memory_usage (const soa_vector_t *soa);
+
+#endif // CUTILS_SOA_VECTOR_H
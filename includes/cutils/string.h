@@ -69,6 +69,39 @@ string_t *string_from_cstr (const char *str);
  */
 void string_destroy (string_t *str);
 
+/**
+ * Copies the contents of one string into another, reusing the destination's
+ * buffer and allocator.
+ *
+ * @param dst String to overwrite
+ * @param src String to copy from
+ * @return true if successful, false otherwise
+ * @note Only allocates when dst's capacity is too small
+ * @note On failure dst is left unchanged
+ */
+bool string_copy_into (string_t *dst, const string_t *src);
+
+/**
+ * Transfers the buffer of one string to another without copying.
+ *
+ * @param dst String receiving the buffer; its old buffer is released
+ * @param src String giving up its buffer; left empty with zero capacity
+ * @return true if successful, false otherwise
+ * @note Both strings must share the same allocator
+ */
+bool string_move (string_t *dst, string_t *src);
+
+/**
+ * Detaches the character buffer from a string.
+ *
+ * @param str String to take the buffer from; left empty with zero capacity
+ * @param out_length Receives the string length (optional)
+ * @return NUL-terminated buffer, or NULL if the string had none
+ * @note Caller owns the buffer and must release it with the string's
+ *       allocator
+ */
+char *string_take (string_t *str, size_t *out_length);
+
 /**
  * Appends a C string to the string with timeout.
  *
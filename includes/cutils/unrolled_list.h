@@ -0,0 +1,312 @@
+#ifndef CUTILS_UNROLLED_LIST_H
+#define CUTILS_UNROLLED_LIST_H
+
+#include "cutils/allocator.h"
+#include "cutils/config.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Unrolled linked list. Each node stores a small array of elements sized so
+ * that a node spans about CUTILS_UNROLLED_LIST_NODE_BYTES. Sequential access
+ * walks contiguous memory, and indexed access hops node by node from the
+ * closer end, so it costs O(n / B) for B elements per node.
+ *
+ * A full node is split in half on insert. When a removal leaves a node less
+ * than half full, it is merged with a neighbour if the two fit in one node.
+ * Element addresses are not stable across insert and remove.
+ */
+typedef struct unrolled_list_node
+{
+  struct unrolled_list_node *next;
+  struct unrolled_list_node *prev;
+  size_t count;
+  alignas (max_align_t) unsigned char data[];
+} unrolled_list_node_t;
+
+typedef struct
+{
+  unrolled_list_node_t *head;
+  unrolled_list_node_t *tail;
+  size_t len;
+  size_t node_count;
+  size_t node_capacity;
+  size_t elem_len;
+  cutils_allocator_t *allocator;
+} unrolled_list_t;
+
+typedef struct
+{
+  unrolled_list_t *list;
+  unrolled_list_node_t *node;
+  size_t offset;
+  size_t index;
+} unrolled_list_iterator_t;
+
+typedef enum
+{
+  UNROLLED_LIST_OK = 0,
+  UNROLLED_LIST_NULL_PTR = 1,
+  UNROLLED_LIST_NO_MEMORY = 2,
+  UNROLLED_LIST_INVALID_ARG = 3,
+  UNROLLED_LIST_OUT_OF_RANGE = 4,
+  UNROLLED_LIST_OVERFLOW = 5,
+  UNROLLED_LIST_TIMEOUT = 6
+} unrolled_list_result_t;
+
+/**
+ * Gets the last unrolled list operation error.
+ *
+ * @return Last error code
+ */
+[[nodiscard]] unrolled_list_result_t unrolled_list_get_error (void);
+
+/**
+ * Creates a new unrolled list with the specified allocator.
+ *
+ * @param elem_len Size of each element in bytes
+ * @param allocator Allocator to use
+ * @return Newly allocated list or NULL on error
+ * @note Sets error to UNROLLED_LIST_INVALID_ARG if elem_len is 0 or
+ *       allocator is NULL
+ * @note Sets error to UNROLLED_LIST_OVERFLOW if elem_len is too large
+ * @note Sets error to UNROLLED_LIST_NO_MEMORY if allocation fails
+ */
+[[nodiscard]] unrolled_list_t *
+unrolled_list_create_with_allocator (size_t elem_len,
+                                     cutils_allocator_t *allocator);
+
+/**
+ * Creates a new unrolled list using the default allocator.
+ *
+ * @param elem_len Size of each element in bytes
+ * @return Newly allocated list or NULL on error
+ */
+[[nodiscard]] unrolled_list_t *unrolled_list_create (size_t elem_len);
+
+/**
+ * Destroys a list and frees all nodes.
+ *
+ * @param list List to destroy
+ */
+void unrolled_list_destroy (unrolled_list_t *list);
+
+/**
+ * Inserts an element at an index with timeout.
+ *
+ * @param list List to insert into
+ * @param index Position of the new element, at most the current length
+ * @param elem Element to insert
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ * @note Sets error to UNROLLED_LIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to UNROLLED_LIST_OUT_OF_RANGE if index is out of bounds
+ * @note Sets error to UNROLLED_LIST_NO_MEMORY if a node cannot be allocated
+ * @note Sets error to UNROLLED_LIST_TIMEOUT if allocation takes too long
+ */
+bool unrolled_list_insert_timeout (unrolled_list_t *list, size_t index,
+                                   const void *elem, uint32_t timeout_ms);
+
+/**
+ * Inserts an element at an index.
+ *
+ * @param list List to insert into
+ * @param index Position of the new element, at most the current length
+ * @param elem Element to insert
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_insert (unrolled_list_t *list, size_t index,
+                           const void *elem);
+
+/**
+ * Adds an element to the front with timeout.
+ *
+ * @param list List to add to
+ * @param elem Element to add
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_push_front_timeout (unrolled_list_t *list,
+                                       const void *elem, uint32_t timeout_ms);
+
+/**
+ * Adds an element to the front.
+ *
+ * @param list List to add to
+ * @param elem Element to add
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_push_front (unrolled_list_t *list, const void *elem);
+
+/**
+ * Adds an element to the back with timeout.
+ *
+ * @param list List to add to
+ * @param elem Element to add
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return true if successful, false otherwise
+ * @note Appending fills the tail node before starting a new one, so a list
+ *       built by appending keeps its nodes full
+ */
+bool unrolled_list_push_back_timeout (unrolled_list_t *list,
+                                      const void *elem, uint32_t timeout_ms);
+
+/**
+ * Adds an element to the back.
+ *
+ * @param list List to add to
+ * @param elem Element to add
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_push_back (unrolled_list_t *list, const void *elem);
+
+/**
+ * Removes the element at an index.
+ *
+ * @param list List to remove from
+ * @param index Index of the element
+ * @param out Receives the removed element (optional)
+ * @return true if successful, false otherwise
+ * @note Sets error to UNROLLED_LIST_NULL_PTR if list is NULL
+ * @note Sets error to UNROLLED_LIST_OUT_OF_RANGE if index is out of bounds
+ */
+bool unrolled_list_remove (unrolled_list_t *list, size_t index, void *out);
+
+/**
+ * Removes the first element.
+ *
+ * @param list List to remove from
+ * @param out Receives the removed element (optional)
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_pop_front (unrolled_list_t *list, void *out);
+
+/**
+ * Removes the last element.
+ *
+ * @param list List to remove from
+ * @param out Receives the removed element (optional)
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_pop_back (unrolled_list_t *list, void *out);
+
+/**
+ * Copies out the element at an index.
+ *
+ * @param list List to read
+ * @param index Index of the element
+ * @param out Receives the element
+ * @return true if successful, false otherwise
+ * @note Sets error to UNROLLED_LIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to UNROLLED_LIST_OUT_OF_RANGE if index is out of bounds
+ */
+bool unrolled_list_get (const unrolled_list_t *list, size_t index, void *out);
+
+/**
+ * Overwrites the element at an index.
+ *
+ * @param list List to modify
+ * @param index Index of the element
+ * @param elem New element
+ * @return true if successful, false otherwise
+ * @note Sets error to UNROLLED_LIST_NULL_PTR if any parameter is NULL
+ * @note Sets error to UNROLLED_LIST_OUT_OF_RANGE if index is out of bounds
+ */
+bool unrolled_list_set (unrolled_list_t *list, size_t index,
+                        const void *elem);
+
+/**
+ * Gets a pointer to the element at an index.
+ *
+ * @param list List to query
+ * @param index Index of the element
+ * @return Pointer to the element, or NULL on error
+ * @note The pointer is invalidated by any insert or remove
+ */
+void *unrolled_list_at (const unrolled_list_t *list, size_t index);
+
+/**
+ * Removes all elements and frees all nodes.
+ *
+ * @param list List to clear
+ * @return true if successful, false otherwise
+ */
+bool unrolled_list_clear (unrolled_list_t *list);
+
+/**
+ * Gets the number of elements.
+ *
+ * @param list List to query
+ * @return Number of elements, or 0 if list is NULL
+ */
+size_t unrolled_list_length (const unrolled_list_t *list);
+
+/**
+ * Gets the number of allocated nodes.
+ *
+ * @param list List to query
+ * @return Number of nodes, or 0 if list is NULL
+ */
+size_t unrolled_list_node_count (const unrolled_list_t *list);
+
+/**
+ * Gets the number of elements each node can hold.
+ *
+ * @param list List to query
+ * @return Elements per node, or 0 if list is NULL
+ */
+size_t unrolled_list_node_capacity (const unrolled_list_t *list);
+
+/**
+ * Gets the total memory used by the list and its nodes.
+ *
+ * @param list List to query
+ * @return Memory usage in bytes, or 0 if list is NULL
+ */
+size_t unrolled_list_memory_usage (const unrolled_list_t *list);
+
+/**
+ * Creates an iterator at the first element.
+ *
+ * @param list List to iterate
+ * @return Iterator at the first element
+ */
+unrolled_list_iterator_t unrolled_list_begin (unrolled_list_t *list);
+
+/**
+ * Moves the iterator to the next element.
+ *
+ * @param it Iterator to move
+ * @return true if successful, false if end of list
+ */
+bool unrolled_list_iterator_next (unrolled_list_iterator_t *it);
+
+/**
+ * Gets a pointer to the current element.
+ *
+ * @param it Iterator to query
+ * @return Pointer to the element, or NULL if the iterator is invalid
+ */
+void *unrolled_list_iterator_at (const unrolled_list_iterator_t *it);
+
+/**
+ * Gets the current element.
+ *
+ * @param it Iterator to get element from
+ * @param out Receives the element
+ * @return true if successful, false if end of list
+ */
+bool unrolled_list_iterator_get (const unrolled_list_iterator_t *it,
+                                 void *out);
+
+/**
+ * Checks if the iterator is valid.
+ *
+ * @param it Iterator to check
+ * @return true if valid, false if end of list
+ */
+bool unrolled_list_iterator_is_valid (const unrolled_list_iterator_t *it);
+
+#endif // CUTILS_UNROLLED_LIST_H
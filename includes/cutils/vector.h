@@ -24,9 +24,20 @@ typedef enum
   VECTOR_OUT_OF_RANGE = 4,
   VECTOR_OVERFLOW = 5,
   VECTOR_TIMEOUT = 6,
-  VECTOR_PRIORITY_ERROR = 7
+  VECTOR_PRIORITY_ERROR = 7,
+  VECTOR_NOT_FOUND = 8
 } vector_result_t;
 
+typedef enum
+{
+  VECTOR_KEY_U32 = 0,
+  VECTOR_KEY_I32 = 1,
+  VECTOR_KEY_F32 = 2,
+  VECTOR_KEY_U64 = 3,
+  VECTOR_KEY_I64 = 4,
+  VECTOR_KEY_F64 = 5
+} vector_key_type_t;
+
 /**
  * Gets the last vector operation error.
  *
@@ -67,6 +78,45 @@ vector_t *vector_create_with_allocator (size_t init_capacity, size_t elem_len,
  */
 [[nodiscard]] vector_t *vector_copy (const vector_t *vec);
 
+/**
+ * Copies the contents of one vector into another, reusing the destination's
+ * buffer and allocator.
+ *
+ * @param dst Vector to overwrite
+ * @param src Vector to copy from
+ * @return true if successful, false otherwise
+ * @note Only allocates when dst's capacity is smaller than src's length
+ * @note On failure dst is left unchanged
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to VECTOR_INVALID_ARG if element sizes differ
+ * @note Sets error to VECTOR_NO_MEMORY if allocation fails
+ */
+bool vector_copy_into (vector_t *dst, const vector_t *src);
+
+/**
+ * Transfers the buffer of one vector to another in O(1).
+ *
+ * @param dst Vector receiving the buffer; its old buffer is released
+ * @param src Vector giving up its buffer; left empty with zero capacity
+ * @return true if successful, false otherwise
+ * @note Both vectors must share the same allocator and element size
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to VECTOR_INVALID_ARG if allocators or sizes differ
+ */
+bool vector_move (vector_t *dst, vector_t *src);
+
+/**
+ * Detaches the element buffer from a vector.
+ *
+ * @param vec Vector to take the buffer from; left empty with zero capacity
+ * @param out_len Receives the number of elements in the buffer (optional)
+ * @return Element buffer, or NULL if the vector had none
+ * @note Caller owns the buffer and must release it with the vector's
+ *       allocator
+ * @note Sets error to VECTOR_NULL_PTR if vec is NULL
+ */
+[[nodiscard]] void *vector_take (vector_t *vec, size_t *out_len);
+
 /**
  * Frees all memory associated with vector.
  *
@@ -146,6 +196,63 @@ bool vector_insert (vector_t *vec, size_t index, const void *elem);
  */
 bool vector_remove (vector_t *vec, size_t index, void *out);
 
+/**
+ * Removes element at specified index by moving the last element into it.
+ *
+ * Runs in O(1) but does not preserve the order of the remaining elements.
+ *
+ * @param vec Vector to remove from
+ * @param index Index to remove
+ * @param out Optional buffer to store removed element
+ * @return true if successful, false otherwise
+ * @note Sets error to VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to VECTOR_OUT_OF_RANGE if index invalid
+ */
+bool vector_swap_remove (vector_t *vec, size_t index, void *out);
+
+/**
+ * Keeps only the elements for which keep returns true.
+ *
+ * Compacts the vector in a single pass, moving runs of kept elements at
+ * once and preserving their order. keep is called exactly once per element,
+ * in index order, and must not modify the vector.
+ *
+ * @param vec Vector to filter
+ * @param keep Predicate called with each element and ctx
+ * @param ctx User context passed to keep
+ * @return Number of removed elements
+ * @note Sets error to VECTOR_NULL_PTR if vec or keep is NULL
+ */
+size_t vector_retain (vector_t *vec, bool (*keep) (const void *elem, void *ctx),
+                      void *ctx);
+
+/**
+ * Removes the elements for which pred returns true.
+ *
+ * Same single pass compaction as vector_retain with the predicate inverted.
+ *
+ * @param vec Vector to filter
+ * @param pred Predicate called with each element and ctx
+ * @param ctx User context passed to pred
+ * @return Number of removed elements
+ * @note Sets error to VECTOR_NULL_PTR if vec or pred is NULL
+ */
+size_t vector_erase_if (vector_t *vec,
+                        bool (*pred) (const void *elem, void *ctx), void *ctx);
+
+/**
+ * Removes every element equal to the given one, preserving order.
+ *
+ * Elements are compared bytewise. 4 and 8 byte elements are compared and
+ * compacted with AVX2 when the CPU supports it.
+ *
+ * @param vec Vector to filter
+ * @param elem Element to remove
+ * @return Number of removed elements
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ */
+size_t vector_erase_value (vector_t *vec, const void *elem);
+
 /**
  * Ensures vector capacity is at least specified size.
  *
@@ -244,4 +351,143 @@ size_t vector_memory_usage (const vector_t *vec);
 bool vector_can_perform_operation (const vector_t *vec,
                                    size_t required_capacity);
 
+/**
+ * Sorts the vector in place using a comparison function.
+ *
+ * Uses a pattern-defeating introsort: median-of-three/ninther pivots,
+ * bounded insertion sort on already partitioned ranges and a heapsort
+ * fallback, so the worst case stays O(n log n). The sort is not stable.
+ *
+ * @param vec Vector to sort
+ * @param compare Element comparison function
+ * @return true if successful, false otherwise
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ */
+bool vector_sort (vector_t *vec, int (*compare) (const void *a, const void *b));
+
+/**
+ * Sorts the vector in place by a fixed-width key stored in each element.
+ *
+ * Same algorithm as vector_sort, but the key comparison is inlined instead
+ * of going through a callback. Needs no extra memory. Not stable.
+ *
+ * @param vec Vector to sort
+ * @param key_type Type of the key
+ * @param key_offset Byte offset of the key within each element
+ * @return true if successful, false otherwise
+ * @note Sets error to VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to VECTOR_INVALID_ARG if the key does not fit the element
+ */
+bool vector_sort_by_key (vector_t *vec, vector_key_type_t key_type,
+                         size_t key_offset);
+
+/**
+ * Sorts the vector by a fixed-width key using LSD radix sort.
+ *
+ * Runs in O(n) passes over the data, one per key byte, skipping bytes that
+ * are equal across all keys. The sort is stable. Floats are ordered by
+ * their IEEE 754 total order (-0.0 before +0.0, NaNs at the ends).
+ *
+ * @param vec Vector to sort
+ * @param key_type Type of the key
+ * @param key_offset Byte offset of the key within each element
+ * @return true if successful, false otherwise
+ * @note Sets error to VECTOR_NULL_PTR if vec is NULL
+ * @note Sets error to VECTOR_INVALID_ARG if the key does not fit the element
+ * @note Sets error to VECTOR_NO_MEMORY if the scratch buffer cannot be
+ *       allocated
+ */
+bool vector_radix_sort (vector_t *vec, vector_key_type_t key_type,
+                        size_t key_offset);
+
+/**
+ * Finds the first element equal to the given one.
+ *
+ * Elements are compared bytewise. For 1, 2, 4 and 8 byte elements the scan
+ * uses SSE2/AVX2 compares when the CPU supports them.
+ *
+ * @param vec Vector to search
+ * @param elem Element to find
+ * @return Index of the element or SIZE_MAX if not found
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to VECTOR_NOT_FOUND if no element matches
+ */
+size_t vector_find (const vector_t *vec, const void *elem);
+
+/**
+ * Counts the elements equal to the given one.
+ *
+ * @param vec Vector to search
+ * @param elem Element to count
+ * @return Number of matching elements
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ */
+size_t vector_count (const vector_t *vec, const void *elem);
+
+/**
+ * Checks if the vector contains an element equal to the given one.
+ *
+ * @param vec Vector to search
+ * @param elem Element to look for
+ * @return true if found, false otherwise
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ */
+bool vector_contains (const vector_t *vec, const void *elem);
+
+/**
+ * Finds the first element not less than the given one in a sorted vector.
+ *
+ * @param vec Vector sorted by compare
+ * @param elem Element to search for
+ * @param compare Element comparison function
+ * @return Index of the element, or the vector length if there is none
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ */
+size_t vector_lower_bound (const vector_t *vec, const void *elem,
+                           int (*compare) (const void *a, const void *b));
+
+/**
+ * Finds the first element greater than the given one in a sorted vector.
+ *
+ * @param vec Vector sorted by compare
+ * @param elem Element to search for
+ * @param compare Element comparison function
+ * @return Index of the element, or the vector length if there is none
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ */
+size_t vector_upper_bound (const vector_t *vec, const void *elem,
+                           int (*compare) (const void *a, const void *b));
+
+/**
+ * Finds the first element whose key is not less than the given key.
+ *
+ * Branchless binary search with the key comparison inlined.
+ *
+ * @param vec Vector sorted by the key
+ * @param key_type Type of the key
+ * @param key_offset Byte offset of the key within each element
+ * @param key Key to search for
+ * @return Index of the element, or the vector length if there is none
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to VECTOR_INVALID_ARG if the key does not fit the element
+ */
+size_t vector_lower_bound_by_key (const vector_t *vec,
+                                  vector_key_type_t key_type,
+                                  size_t key_offset, const void *key);
+
+/**
+ * Finds the first element whose key is greater than the given key.
+ *
+ * @param vec Vector sorted by the key
+ * @param key_type Type of the key
+ * @param key_offset Byte offset of the key within each element
+ * @param key Key to search for
+ * @return Index of the element, or the vector length if there is none
+ * @note Sets error to VECTOR_NULL_PTR if any parameter is NULL
+ * @note Sets error to VECTOR_INVALID_ARG if the key does not fit the element
+ */
+size_t vector_upper_bound_by_key (const vector_t *vec,
+                                  vector_key_type_t key_type,
+                                  size_t key_offset, const void *key);
+
 #endif // CUTILS_VECTOR_H
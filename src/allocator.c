@@ -92,6 +92,37 @@ cutils_create_default_allocator (void)
   return allocator;
 }
 
+cutils_allocator_t *
+cutils_get_default_allocator (void)
+{
+  static cutils_allocator_t g_default_allocator;
+
+  if (g_default_allocator.allocate == NULL)
+    {
+      g_default_allocator = cutils_create_default_allocator ();
+    }
+
+  return &g_default_allocator;
+}
+
+bool
+cutils_allocator_equal (const cutils_allocator_t *a,
+                        const cutils_allocator_t *b)
+{
+  if (a == b)
+    {
+      return true;
+    }
+
+  if (a == NULL || b == NULL)
+    {
+      return false;
+    }
+
+  return a->allocate == b->allocate && a->deallocate == b->deallocate
+         && a->context == b->context;
+}
+
 void *
 cutils_allocate_aligned (cutils_allocator_t *allocator, size_t size,
                          size_t alignment)
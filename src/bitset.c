@@ -0,0 +1,789 @@
+#include "cutils/bitset.h"
+#include "cutils/config.h"
+#include "cutils/cpu.h"
+#include "cutils/time.h"
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#if CUTILS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define WORD_BITS 64
+#define RANK_BLOCK_WORDS ((size_t)CUTILS_BITSET_RANK_BLOCK_BITS / WORD_BITS)
+
+static thread_local bitset_result_t g_last_error = BITSET_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+[[gnu::always_inline]] static inline size_t
+word_count (size_t bits)
+{
+  return (bits / WORD_BITS) + ((bits % WORD_BITS) != 0);
+}
+
+[[gnu::always_inline]] static inline size_t
+popcount64 (uint64_t word)
+{
+  return (size_t)__builtin_popcountll (word);
+}
+
+/*
+ * Population count over word arrays. With and_words set the count is taken
+ * over a[i] & b[i]; the flag is a compile-time constant after inlining, so
+ * each variant gets its own loop.
+ */
+
+[[gnu::always_inline]] static inline size_t
+popcount_loop (const uint64_t *a, const uint64_t *b, size_t n, bool and_words)
+{
+  size_t total = 0;
+
+  for (size_t i = 0; i < n; i++)
+    {
+      total += popcount64 (and_words ? a[i] & b[i] : a[i]);
+    }
+
+  return total;
+}
+
+static size_t
+popcount_generic (const uint64_t *a, const uint64_t *b, size_t n)
+{
+  return b == NULL ? popcount_loop (a, NULL, n, false)
+                   : popcount_loop (a, b, n, true);
+}
+
+#if CUTILS_SIMD_X86
+[[gnu::target ("popcnt")]] static size_t
+popcount_popcnt (const uint64_t *a, const uint64_t *b, size_t n)
+{
+  return b == NULL ? popcount_loop (a, NULL, n, false)
+                   : popcount_loop (a, b, n, true);
+}
+
+/*
+ * Nibble lookup popcount: pshufb maps each nibble to its bit count and
+ * psadbw folds the byte counts into four 64-bit lanes.
+ */
+[[gnu::target ("avx2"), gnu::always_inline]] static inline size_t
+popcount_avx2_impl (const uint64_t *a, const uint64_t *b, size_t n,
+                    bool and_words)
+{
+  const __m256i lookup
+      = _mm256_setr_epi8 (0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0,
+                          1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8 (0x0F);
+  __m256i acc = _mm256_setzero_si256 ();
+  size_t i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *)(a + i));
+      if (and_words)
+        {
+          v = _mm256_and_si256 (
+              v, _mm256_loadu_si256 ((const __m256i *)(b + i)));
+        }
+
+      __m256i lo = _mm256_and_si256 (v, low_mask);
+      __m256i hi = _mm256_and_si256 (_mm256_srli_epi16 (v, 4), low_mask);
+      __m256i counts = _mm256_add_epi8 (_mm256_shuffle_epi8 (lookup, lo),
+                                        _mm256_shuffle_epi8 (lookup, hi));
+      acc = _mm256_add_epi64 (
+          acc, _mm256_sad_epu8 (counts, _mm256_setzero_si256 ()));
+    }
+
+  size_t total = (size_t)_mm256_extract_epi64 (acc, 0)
+                 + (size_t)_mm256_extract_epi64 (acc, 1)
+                 + (size_t)_mm256_extract_epi64 (acc, 2)
+                 + (size_t)_mm256_extract_epi64 (acc, 3);
+
+  return total
+         + popcount_loop (a + i, and_words ? b + i : NULL, n - i, and_words);
+}
+
+[[gnu::target ("avx2")]] static size_t
+popcount_avx2 (const uint64_t *a, const uint64_t *b, size_t n)
+{
+  return b == NULL ? popcount_avx2_impl (a, NULL, n, false)
+                   : popcount_avx2_impl (a, b, n, true);
+}
+#endif
+
+static size_t
+popcount_words (const uint64_t *a, const uint64_t *b, size_t n)
+{
+#if CUTILS_SIMD_X86
+  if (n >= 16 && cutils_cpu_has (CUTILS_CPU_AVX2))
+    {
+      return popcount_avx2 (a, b, n);
+    }
+  if (cutils_cpu_has (CUTILS_CPU_POPCNT))
+    {
+      return popcount_popcnt (a, b, n);
+    }
+#endif
+
+  return popcount_generic (a, b, n);
+}
+
+#if CUTILS_SIMD_X86
+[[gnu::target ("bmi2")]] static unsigned
+select_in_word_bmi2 (uint64_t word, size_t k)
+{
+  return (unsigned)__builtin_ctzll (_pdep_u64 ((uint64_t)1 << k, word));
+}
+#endif
+
+/* Position of the k-th set bit of word; word must have more than k bits */
+static unsigned
+select_in_word (uint64_t word, size_t k)
+{
+#if CUTILS_SIMD_X86
+  if (cutils_cpu_has (CUTILS_CPU_BMI2))
+    {
+      return select_in_word_bmi2 (word, k);
+    }
+#endif
+
+  for (; k > 0; k--)
+    {
+      word &= word - 1;
+    }
+  return (unsigned)__builtin_ctzll (word);
+}
+
+static bool
+reserve_words (bitset_t *bs, size_t words)
+{
+  if (words <= bs->word_capacity)
+    {
+      return true;
+    }
+
+  if (SIZE_MAX / sizeof (uint64_t) < words)
+    {
+      g_last_error = BITSET_OVERFLOW;
+      return false;
+    }
+
+  uint64_t *data = cutils_allocate_aligned (
+      bs->allocator, words * sizeof (uint64_t), CUTILS_ALIGNMENT);
+  if (data == NULL)
+    {
+      g_last_error = BITSET_NO_MEMORY;
+      return false;
+    }
+
+  size_t used = word_count (bs->len);
+  if (used > 0)
+    {
+      memcpy (data, bs->words, used * sizeof (uint64_t));
+    }
+
+  cutils_deallocate (bs->allocator, bs->words);
+  bs->words = data;
+  bs->word_capacity = words;
+
+  return true;
+}
+
+/* Clears the bits of the last word that lie past the length */
+static void
+clear_tail (bitset_t *bs)
+{
+  size_t tail = bs->len % WORD_BITS;
+  if (tail != 0)
+    {
+      bs->words[bs->len / WORD_BITS] &= ((uint64_t)1 << tail) - 1;
+    }
+}
+
+bitset_t *
+bitset_create_with_allocator (size_t len, cutils_allocator_t *allocator)
+{
+  g_last_error = BITSET_OK;
+
+  if (allocator == NULL)
+    {
+      g_last_error = BITSET_INVALID_ARG;
+      return NULL;
+    }
+
+  bitset_t *bs = cutils_allocate_aligned (allocator, sizeof (bitset_t),
+                                          CUTILS_ALIGNMENT);
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NO_MEMORY;
+      return NULL;
+    }
+
+  bs->words = NULL;
+  bs->len = 0;
+  bs->word_capacity = 0;
+  bs->rank = NULL;
+  bs->rank_capacity = 0;
+  bs->rank_valid = false;
+  bs->allocator = allocator;
+
+  if (!bitset_resize (bs, len))
+    {
+      cutils_deallocate (allocator, bs);
+      return NULL;
+    }
+
+  return bs;
+}
+
+bitset_t *
+bitset_create (size_t len)
+{
+  return bitset_create_with_allocator (len, cutils_get_default_allocator ());
+}
+
+void
+bitset_destroy (bitset_t *bs)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return;
+    }
+
+  cutils_deallocate (bs->allocator, bs->words);
+  cutils_deallocate (bs->allocator, bs->rank);
+  cutils_deallocate (bs->allocator, bs);
+}
+
+bool
+bitset_resize (bitset_t *bs, size_t len)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  size_t old_words = word_count (bs->len);
+  size_t new_words = word_count (len);
+
+  if (!reserve_words (bs, new_words))
+    {
+      return false;
+    }
+
+  if (new_words > old_words)
+    {
+      memset (bs->words + old_words, 0,
+              (new_words - old_words) * sizeof (uint64_t));
+    }
+
+  bs->len = len;
+  clear_tail (bs);
+  bs->rank_valid = false;
+
+  return true;
+}
+
+bool
+bitset_push_timeout (bitset_t *bs, bool value, uint32_t timeout_ms)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+  size_t word = bs->len / WORD_BITS;
+
+  if (bs->len % WORD_BITS == 0)
+    {
+      if (word >= bs->word_capacity)
+        {
+          if (!check_timeout ((uint32_t)start_time, timeout_ms))
+            {
+              g_last_error = BITSET_TIMEOUT;
+              return false;
+            }
+
+          size_t capacity
+              = bs->word_capacity > 0 ? bs->word_capacity * 2 : 4;
+          if (!reserve_words (bs, capacity))
+            {
+              return false;
+            }
+        }
+      bs->words[word] = 0;
+    }
+
+  bs->words[word] |= (uint64_t)value << (bs->len % WORD_BITS);
+  bs->len++;
+  bs->rank_valid = false;
+
+  return true;
+}
+
+bool
+bitset_push (bitset_t *bs, bool value)
+{
+  return bitset_push_timeout (bs, value, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+bitset_set (bitset_t *bs, size_t index)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  if (index >= bs->len)
+    {
+      g_last_error = BITSET_OUT_OF_RANGE;
+      return false;
+    }
+
+  bs->words[index / WORD_BITS] |= (uint64_t)1 << (index % WORD_BITS);
+  bs->rank_valid = false;
+  return true;
+}
+
+bool
+bitset_reset (bitset_t *bs, size_t index)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  if (index >= bs->len)
+    {
+      g_last_error = BITSET_OUT_OF_RANGE;
+      return false;
+    }
+
+  bs->words[index / WORD_BITS] &= ~((uint64_t)1 << (index % WORD_BITS));
+  bs->rank_valid = false;
+  return true;
+}
+
+bool
+bitset_flip (bitset_t *bs, size_t index)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  if (index >= bs->len)
+    {
+      g_last_error = BITSET_OUT_OF_RANGE;
+      return false;
+    }
+
+  bs->words[index / WORD_BITS] ^= (uint64_t)1 << (index % WORD_BITS);
+  bs->rank_valid = false;
+  return true;
+}
+
+bool
+bitset_test (const bitset_t *bs, size_t index)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  if (index >= bs->len)
+    {
+      g_last_error = BITSET_OUT_OF_RANGE;
+      return false;
+    }
+
+  return (bs->words[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+bool
+bitset_fill (bitset_t *bs, bool value)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  size_t words = word_count (bs->len);
+  if (words > 0)
+    {
+      memset (bs->words, value ? 0xFF : 0, words * sizeof (uint64_t));
+      clear_tail (bs);
+    }
+  bs->rank_valid = false;
+
+  return true;
+}
+
+typedef enum
+{
+  OP_AND,
+  OP_OR,
+  OP_XOR,
+  OP_ANDNOT
+} bitset_op_t;
+
+/*
+ * Word-parallel combine. The operation is hoisted out of the loop so each
+ * case is a straight loop the compiler can vectorize. None of the
+ * operations can set bits past the length when both inputs keep them clear.
+ */
+static bool
+combine (bitset_t *dst, const bitset_t *src, bitset_op_t op)
+{
+  g_last_error = BITSET_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  if (dst->len != src->len)
+    {
+      g_last_error = BITSET_INVALID_ARG;
+      return false;
+    }
+
+  uint64_t *d = dst->words;
+  const uint64_t *s = src->words;
+  size_t n = word_count (dst->len);
+
+  switch (op)
+    {
+    case OP_AND:
+      for (size_t i = 0; i < n; i++)
+        {
+          d[i] &= s[i];
+        }
+      break;
+    case OP_OR:
+      for (size_t i = 0; i < n; i++)
+        {
+          d[i] |= s[i];
+        }
+      break;
+    case OP_XOR:
+      for (size_t i = 0; i < n; i++)
+        {
+          d[i] ^= s[i];
+        }
+      break;
+    case OP_ANDNOT:
+      for (size_t i = 0; i < n; i++)
+        {
+          d[i] &= ~s[i];
+        }
+      break;
+    }
+
+  dst->rank_valid = false;
+  return true;
+}
+
+bool
+bitset_and (bitset_t *dst, const bitset_t *src)
+{
+  return combine (dst, src, OP_AND);
+}
+
+bool
+bitset_or (bitset_t *dst, const bitset_t *src)
+{
+  return combine (dst, src, OP_OR);
+}
+
+bool
+bitset_xor (bitset_t *dst, const bitset_t *src)
+{
+  return combine (dst, src, OP_XOR);
+}
+
+bool
+bitset_andnot (bitset_t *dst, const bitset_t *src)
+{
+  return combine (dst, src, OP_ANDNOT);
+}
+
+size_t
+bitset_count (const bitset_t *bs)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return 0;
+    }
+
+  return popcount_words (bs->words, NULL, word_count (bs->len));
+}
+
+size_t
+bitset_count_and (const bitset_t *a, const bitset_t *b)
+{
+  g_last_error = BITSET_OK;
+
+  if (a == NULL || b == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return 0;
+    }
+
+  if (a->len != b->len)
+    {
+      g_last_error = BITSET_INVALID_ARG;
+      return 0;
+    }
+
+  return popcount_words (a->words, b->words, word_count (a->len));
+}
+
+size_t
+bitset_find_next (const bitset_t *bs, size_t from)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return SIZE_MAX;
+    }
+
+  if (from >= bs->len)
+    {
+      g_last_error = BITSET_NOT_FOUND;
+      return SIZE_MAX;
+    }
+
+  size_t words = word_count (bs->len);
+  size_t w = from / WORD_BITS;
+  uint64_t word = bs->words[w] & (UINT64_MAX << (from % WORD_BITS));
+
+  while (word == 0)
+    {
+      if (++w == words)
+        {
+          g_last_error = BITSET_NOT_FOUND;
+          return SIZE_MAX;
+        }
+      word = bs->words[w];
+    }
+
+  return (w * WORD_BITS) + (size_t)__builtin_ctzll (word);
+}
+
+bool
+bitset_build_rank_index (bitset_t *bs)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return false;
+    }
+
+  size_t words = word_count (bs->len);
+  size_t blocks = (words + RANK_BLOCK_WORDS - 1) / RANK_BLOCK_WORDS;
+  size_t entries = blocks + 1;
+
+  if (entries > bs->rank_capacity)
+    {
+      uint64_t *rank = cutils_allocate_aligned (
+          bs->allocator, entries * sizeof (uint64_t), CUTILS_ALIGNMENT);
+      if (rank == NULL)
+        {
+          g_last_error = BITSET_NO_MEMORY;
+          return false;
+        }
+
+      cutils_deallocate (bs->allocator, bs->rank);
+      bs->rank = rank;
+      bs->rank_capacity = entries;
+    }
+
+  // rank[j] holds the number of set bits in the words before block j
+  uint64_t total = 0;
+  for (size_t j = 0; j < blocks; j++)
+    {
+      size_t first = j * RANK_BLOCK_WORDS;
+      size_t n = words - first < RANK_BLOCK_WORDS ? words - first
+                                                  : RANK_BLOCK_WORDS;
+      bs->rank[j] = total;
+      total += popcount_loop (bs->words + first, NULL, n, false);
+    }
+  bs->rank[blocks] = total;
+  bs->rank_valid = true;
+
+  return true;
+}
+
+size_t
+bitset_rank (const bitset_t *bs, size_t index)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return 0;
+    }
+
+  if (index > bs->len)
+    {
+      g_last_error = BITSET_OUT_OF_RANGE;
+      return 0;
+    }
+
+  size_t w = index / WORD_BITS;
+  size_t first = 0;
+  size_t count = 0;
+
+  if (bs->rank_valid)
+    {
+      first = (w / RANK_BLOCK_WORDS) * RANK_BLOCK_WORDS;
+      count = (size_t)bs->rank[w / RANK_BLOCK_WORDS];
+      count += popcount_loop (bs->words + first, NULL, w - first, false);
+    }
+  else
+    {
+      count = popcount_words (bs->words, NULL, w);
+    }
+
+  if (index % WORD_BITS != 0)
+    {
+      count += popcount64 (bs->words[w]
+                           & (((uint64_t)1 << (index % WORD_BITS)) - 1));
+    }
+
+  return count;
+}
+
+size_t
+bitset_select (const bitset_t *bs, size_t k)
+{
+  g_last_error = BITSET_OK;
+
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return SIZE_MAX;
+    }
+
+  size_t words = word_count (bs->len);
+  size_t w = 0;
+
+  if (bs->rank_valid)
+    {
+      size_t blocks = (words + RANK_BLOCK_WORDS - 1) / RANK_BLOCK_WORDS;
+      if (k >= bs->rank[blocks])
+        {
+          g_last_error = BITSET_NOT_FOUND;
+          return SIZE_MAX;
+        }
+
+      // Last block whose preceding count is <= k
+      size_t lo = 0;
+      size_t hi = blocks;
+      while (hi - lo > 1)
+        {
+          size_t mid = lo + ((hi - lo) / 2);
+          if (bs->rank[mid] <= k)
+            {
+              lo = mid;
+            }
+          else
+            {
+              hi = mid;
+            }
+        }
+
+      k -= (size_t)bs->rank[lo];
+      w = lo * RANK_BLOCK_WORDS;
+    }
+
+  for (; w < words; w++)
+    {
+      size_t bits = popcount64 (bs->words[w]);
+      if (k < bits)
+        {
+          return (w * WORD_BITS) + select_in_word (bs->words[w], k);
+        }
+      k -= bits;
+    }
+
+  g_last_error = BITSET_NOT_FOUND;
+  return SIZE_MAX;
+}
+
+size_t
+bitset_length (const bitset_t *bs)
+{
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return 0;
+    }
+  return bs->len;
+}
+
+size_t
+bitset_memory_usage (const bitset_t *bs)
+{
+  if (bs == NULL)
+    {
+      g_last_error = BITSET_NULL_PTR;
+      return 0;
+    }
+  return sizeof (bitset_t) + (bs->word_capacity * sizeof (uint64_t))
+         + (bs->rank_capacity * sizeof (uint64_t));
+}
+
+bitset_result_t
+bitset_get_error (void)
+{
+  return g_last_error;
+}
@@ -0,0 +1,963 @@
+#include "cutils/btree_map.h"
+#include "cutils/config.h"
+#include "cutils/time.h"
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+// Enough for 2^64 entries at the minimum fan-out of two
+#define BTREE_MAP_MAX_DEPTH 64
+#define BTREE_MAP_MIN_CAPACITY 4
+
+static thread_local btree_map_result_t g_last_error = BTREE_MAP_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+static inline void *
+key_at (const btree_map_t *map, btree_map_node_t *node, size_t index)
+{
+  return node->data + index * map->key_size;
+}
+
+static inline void *
+value_at (const btree_map_t *map, btree_map_node_t *node, size_t index)
+{
+  return node->data + map->value_offset + index * map->value_size;
+}
+
+static inline btree_map_node_t **
+children (const btree_map_t *map, btree_map_node_t *node)
+{
+  return (btree_map_node_t **)(void *)(node->data + map->child_offset);
+}
+
+static inline size_t
+leaf_bytes (const btree_map_t *map)
+{
+  return sizeof (btree_map_node_t) + map->value_offset
+         + map->leaf_capacity * map->value_size;
+}
+
+static inline size_t
+internal_bytes (const btree_map_t *map)
+{
+  return sizeof (btree_map_node_t) + map->child_offset
+         + (map->internal_capacity + 1) * sizeof (btree_map_node_t *);
+}
+
+static inline size_t
+min_count (const btree_map_t *map, const btree_map_node_t *node)
+{
+  return node->is_leaf ? map->leaf_capacity / 2
+                       : (map->internal_capacity - 1) / 2;
+}
+
+/*
+ * Binary search within one node. Returns the index of the first key not
+ * less than key, and whether that key is equal.
+ */
+static size_t
+node_search (const btree_map_t *map, btree_map_node_t *node, const void *key,
+             bool *found)
+{
+  size_t low = 0;
+  size_t high = node->count;
+
+  while (low < high)
+    {
+      size_t mid = low + (high - low) / 2;
+      int cmp = map->compare (key_at (map, node, mid), key);
+      if (cmp == 0)
+        {
+          *found = true;
+          return mid;
+        }
+      if (cmp < 0)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+
+  *found = false;
+  return low;
+}
+
+// Separator i is the smallest key of child i + 1, so equal keys go right
+static inline size_t
+child_slot (const btree_map_t *map, btree_map_node_t *node, const void *key)
+{
+  bool found;
+  size_t index = node_search (map, node, key, &found);
+  return found ? index + 1 : index;
+}
+
+/*
+ * Walks from the root to the leaf that holds or would hold key, recording
+ * each internal node and the child slot taken. Returns the leaf, or NULL
+ * for an empty map.
+ */
+static btree_map_node_t *
+descend (const btree_map_t *map, const void *key, btree_map_node_t **path,
+         size_t *slots)
+{
+  btree_map_node_t *node = map->root;
+  size_t depth = 0;
+
+  while (node != NULL && !node->is_leaf)
+    {
+      size_t slot = child_slot (map, node, key);
+      if (path != NULL)
+        {
+          path[depth] = node;
+          slots[depth] = slot;
+        }
+      depth++;
+      node = children (map, node)[slot];
+    }
+
+  return node;
+}
+
+static btree_map_node_t *
+find_value (const btree_map_t *map, const void *key, size_t *index)
+{
+  btree_map_node_t *leaf = descend (map, key, NULL, NULL);
+  if (leaf == NULL)
+    {
+      return NULL;
+    }
+
+  bool found;
+  *index = node_search (map, leaf, key, &found);
+  return found ? leaf : NULL;
+}
+
+static btree_map_node_t *
+node_allocate (btree_map_t *map, bool is_leaf)
+{
+  btree_map_node_t *node = cutils_allocate_aligned (
+      map->allocator, is_leaf ? leaf_bytes (map) : internal_bytes (map),
+      alignof (btree_map_node_t));
+  if (node == NULL)
+    {
+      return NULL;
+    }
+
+  node->next = NULL;
+  node->prev = NULL;
+  node->count = 0;
+  node->is_leaf = is_leaf;
+
+  return node;
+}
+
+static void
+node_free (btree_map_t *map, btree_map_node_t *node)
+{
+  if (node->is_leaf)
+    {
+      map->leaf_count--;
+    }
+  else
+    {
+      map->internal_count--;
+    }
+  cutils_deallocate (map->allocator, node);
+}
+
+static void
+leaf_insert_at (const btree_map_t *map, btree_map_node_t *leaf, size_t index,
+                const void *key, const void *value)
+{
+  size_t tail = leaf->count - index;
+  memmove (key_at (map, leaf, index + 1), key_at (map, leaf, index),
+           tail * map->key_size);
+  memmove (value_at (map, leaf, index + 1), value_at (map, leaf, index),
+           tail * map->value_size);
+  memcpy (key_at (map, leaf, index), key, map->key_size);
+  memcpy (value_at (map, leaf, index), value, map->value_size);
+  leaf->count++;
+}
+
+static void
+leaf_remove_at (const btree_map_t *map, btree_map_node_t *leaf, size_t index)
+{
+  size_t tail = leaf->count - index - 1;
+  memmove (key_at (map, leaf, index), key_at (map, leaf, index + 1),
+           tail * map->key_size);
+  memmove (value_at (map, leaf, index), value_at (map, leaf, index + 1),
+           tail * map->value_size);
+  leaf->count--;
+}
+
+// Inserts key at index and child to its right, at slot index + 1
+static void
+internal_insert_at (const btree_map_t *map, btree_map_node_t *node,
+                    size_t index, const void *key, btree_map_node_t *child)
+{
+  btree_map_node_t **kids = children (map, node);
+  size_t tail = node->count - index;
+  memmove (key_at (map, node, index + 1), key_at (map, node, index),
+           tail * map->key_size);
+  memmove (&kids[index + 2], &kids[index + 1],
+           tail * sizeof (btree_map_node_t *));
+  memcpy (key_at (map, node, index), key, map->key_size);
+  kids[index + 1] = child;
+  node->count++;
+}
+
+// Removes key at index and the child to its right
+static void
+internal_remove_at (const btree_map_t *map, btree_map_node_t *node,
+                    size_t index)
+{
+  btree_map_node_t **kids = children (map, node);
+  size_t tail = node->count - index - 1;
+  memmove (key_at (map, node, index), key_at (map, node, index + 1),
+           tail * map->key_size);
+  memmove (&kids[index + 1], &kids[index + 2],
+           tail * sizeof (btree_map_node_t *));
+  node->count--;
+}
+
+/*
+ * Moves the upper half of a full leaf into right, links right after it and
+ * inserts the new entry into whichever half it belongs to.
+ */
+static void
+split_leaf (btree_map_t *map, btree_map_node_t *leaf, btree_map_node_t *right,
+            size_t index, const void *key, const void *value)
+{
+  size_t keep = map->leaf_capacity - map->leaf_capacity / 2;
+  right->count = leaf->count - keep;
+  memcpy (key_at (map, right, 0), key_at (map, leaf, keep),
+          right->count * map->key_size);
+  memcpy (value_at (map, right, 0), value_at (map, leaf, keep),
+          right->count * map->value_size);
+  leaf->count = keep;
+
+  right->prev = leaf;
+  right->next = leaf->next;
+  if (leaf->next != NULL)
+    {
+      leaf->next->prev = right;
+    }
+  else
+    {
+      map->last = right;
+    }
+  leaf->next = right;
+
+  if (index <= keep)
+    {
+      leaf_insert_at (map, leaf, index, key, value);
+    }
+  else
+    {
+      leaf_insert_at (map, right, index - keep, key, value);
+    }
+}
+
+/*
+ * Splits a full internal node around its middle key and inserts the new
+ * separator and child. The middle key moves up; it is parked in the last
+ * key slot of right, which the split leaves unused, and returned.
+ */
+static const void *
+split_internal (const btree_map_t *map, btree_map_node_t *node,
+                btree_map_node_t *right, size_t index, const void *key,
+                btree_map_node_t *child)
+{
+  size_t capacity = map->internal_capacity;
+  size_t mid = capacity / 2;
+  void *up = key_at (map, right, capacity - 1);
+
+  memcpy (up, key_at (map, node, mid), map->key_size);
+  right->count = node->count - mid - 1;
+  memcpy (key_at (map, right, 0), key_at (map, node, mid + 1),
+          right->count * map->key_size);
+  memcpy (children (map, right), &children (map, node)[mid + 1],
+          (right->count + 1) * sizeof (btree_map_node_t *));
+  node->count = mid;
+
+  if (index <= mid)
+    {
+      internal_insert_at (map, node, index, key, child);
+    }
+  else
+    {
+      internal_insert_at (map, right, index - mid - 1, key, child);
+    }
+
+  return up;
+}
+
+static void
+destroy_subtree (btree_map_t *map, btree_map_node_t *node)
+{
+  if (!node->is_leaf)
+    {
+      btree_map_node_t **kids = children (map, node);
+      for (size_t i = 0; i <= node->count; i++)
+        {
+          destroy_subtree (map, kids[i]);
+        }
+    }
+  cutils_deallocate (map->allocator, node);
+}
+
+static void
+reset (btree_map_t *map)
+{
+  if (map->root != NULL)
+    {
+      destroy_subtree (map, map->root);
+    }
+  map->root = NULL;
+  map->first = NULL;
+  map->last = NULL;
+  map->size = 0;
+  map->height = 0;
+  map->leaf_count = 0;
+  map->internal_count = 0;
+}
+
+btree_map_t *
+btree_map_create_with_allocator (size_t key_size, size_t value_size,
+                                 int (*compare) (const void *a,
+                                                 const void *b),
+                                 cutils_allocator_t *allocator)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (key_size == 0 || value_size == 0 || compare == NULL || allocator == NULL)
+    {
+      g_last_error = BTREE_MAP_INVALID_ARG;
+      return NULL;
+    }
+
+  if (key_size > SIZE_MAX / (4 * BTREE_MAP_MIN_CAPACITY) - value_size
+      || key_size > SIZE_MAX / (4 * BTREE_MAP_MIN_CAPACITY)
+                        - sizeof (btree_map_node_t *))
+    {
+      g_last_error = BTREE_MAP_OVERFLOW;
+      return NULL;
+    }
+
+  // Values are aligned to the largest power of two dividing into their size
+  size_t value_align = alignof (max_align_t);
+  while (value_align > value_size)
+    {
+      value_align /= 2;
+    }
+
+  size_t payload = CUTILS_BTREE_MAP_NODE_BYTES > sizeof (btree_map_node_t)
+                       ? CUTILS_BTREE_MAP_NODE_BYTES
+                             - sizeof (btree_map_node_t)
+                       : 0;
+
+  size_t leaf_capacity = payload / (key_size + value_size);
+  if (leaf_capacity < BTREE_MAP_MIN_CAPACITY)
+    {
+      leaf_capacity = BTREE_MAP_MIN_CAPACITY;
+    }
+
+  size_t internal_capacity
+      = payload > sizeof (btree_map_node_t *)
+            ? (payload - sizeof (btree_map_node_t *))
+                  / (key_size + sizeof (btree_map_node_t *))
+            : 0;
+  if (internal_capacity < BTREE_MAP_MIN_CAPACITY)
+    {
+      internal_capacity = BTREE_MAP_MIN_CAPACITY;
+    }
+
+  btree_map_t *map = cutils_allocate_aligned (allocator, sizeof (btree_map_t),
+                                              CUTILS_ALIGNMENT);
+  if (map == NULL)
+    {
+      g_last_error = BTREE_MAP_NO_MEMORY;
+      return NULL;
+    }
+
+  map->root = NULL;
+  map->first = NULL;
+  map->last = NULL;
+  map->size = 0;
+  map->height = 0;
+  map->leaf_count = 0;
+  map->internal_count = 0;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->leaf_capacity = leaf_capacity;
+  map->internal_capacity = internal_capacity;
+  map->value_offset = (leaf_capacity * key_size + value_align - 1)
+                      & ~(value_align - 1);
+  map->child_offset
+      = (internal_capacity * key_size + alignof (btree_map_node_t *) - 1)
+        & ~(alignof (btree_map_node_t *) - 1);
+  map->allocator = allocator;
+  map->compare = compare;
+
+  return map;
+}
+
+btree_map_t *
+btree_map_create (size_t key_size, size_t value_size,
+                  int (*compare) (const void *a, const void *b))
+{
+  return btree_map_create_with_allocator (key_size, value_size, compare,
+                                          cutils_get_default_allocator ());
+}
+
+void
+btree_map_destroy (btree_map_t *map)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return;
+    }
+
+  reset (map);
+  cutils_deallocate (map->allocator, map);
+}
+
+bool
+btree_map_insert_timeout (btree_map_t *map, const void *key,
+                          const void *value, uint32_t timeout_ms)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (map == NULL || key == NULL || value == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return false;
+    }
+
+  btree_map_node_t *path[BTREE_MAP_MAX_DEPTH];
+  size_t slots[BTREE_MAP_MAX_DEPTH];
+  btree_map_node_t *leaf = descend (map, key, path, slots);
+
+  bool found = false;
+  size_t index = leaf != NULL ? node_search (map, leaf, key, &found) : 0;
+  if (found)
+    {
+      g_last_error = BTREE_MAP_KEY_EXISTS;
+      return false;
+    }
+
+  // Count the splits up front so allocation failure leaves the tree intact
+  size_t needed = leaf == NULL ? 1 : 0;
+  size_t depth = map->height > 0 ? map->height - 1 : 0;
+  if (leaf != NULL && leaf->count == map->leaf_capacity)
+    {
+      size_t level = depth;
+      while (level > 0 && path[level - 1]->count == map->internal_capacity)
+        {
+          level--;
+        }
+      // One leaf, one node per full ancestor, and a new root if all are full
+      needed = 1 + (depth - level) + (level == 0 ? 1 : 0);
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  btree_map_node_t *fresh[BTREE_MAP_MAX_DEPTH + 1];
+  size_t allocated = 0;
+  while (allocated < needed)
+    {
+      fresh[allocated] = node_allocate (map, allocated == 0);
+      if (fresh[allocated] == NULL)
+        {
+          break;
+        }
+      allocated++;
+    }
+
+  if (allocated < needed || !check_timeout ((uint32_t)start_time, timeout_ms))
+    {
+      g_last_error
+          = allocated < needed ? BTREE_MAP_NO_MEMORY : BTREE_MAP_TIMEOUT;
+      for (size_t i = 0; i < allocated; i++)
+        {
+          cutils_deallocate (map->allocator, fresh[i]);
+        }
+      return false;
+    }
+
+  map->size++;
+
+  if (leaf == NULL)
+    {
+      leaf_insert_at (map, fresh[0], 0, key, value);
+      map->root = fresh[0];
+      map->first = fresh[0];
+      map->last = fresh[0];
+      map->height = 1;
+      map->leaf_count = 1;
+      return true;
+    }
+
+  if (leaf->count < map->leaf_capacity)
+    {
+      leaf_insert_at (map, leaf, index, key, value);
+      return true;
+    }
+
+  btree_map_node_t *right = fresh[0];
+  split_leaf (map, leaf, right, index, key, value);
+  map->leaf_count++;
+
+  const void *separator = key_at (map, right, 0);
+  size_t used = 1;
+  for (size_t level = depth; level > 0; level--)
+    {
+      btree_map_node_t *parent = path[level - 1];
+      size_t slot = slots[level - 1];
+
+      if (parent->count < map->internal_capacity)
+        {
+          internal_insert_at (map, parent, slot, separator, right);
+          return true;
+        }
+
+      btree_map_node_t *sibling = fresh[used++];
+      separator
+          = split_internal (map, parent, sibling, slot, separator, right);
+      map->internal_count++;
+      right = sibling;
+    }
+
+  btree_map_node_t *root = fresh[used];
+  memcpy (key_at (map, root, 0), separator, map->key_size);
+  children (map, root)[0] = map->root;
+  children (map, root)[1] = right;
+  root->count = 1;
+  map->root = root;
+  map->height++;
+  map->internal_count++;
+
+  return true;
+}
+
+bool
+btree_map_insert (btree_map_t *map, const void *key, const void *value)
+{
+  return btree_map_insert_timeout (map, key, value,
+                                   CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+// Moves the last entry of left into the front of node
+static void
+borrow_from_left (btree_map_t *map, btree_map_node_t *parent, size_t slot,
+                  btree_map_node_t *left, btree_map_node_t *node)
+{
+  void *separator = key_at (map, parent, slot - 1);
+
+  if (node->is_leaf)
+    {
+      leaf_insert_at (map, node, 0, key_at (map, left, left->count - 1),
+                      value_at (map, left, left->count - 1));
+      left->count--;
+      memcpy (separator, key_at (map, node, 0), map->key_size);
+      return;
+    }
+
+  btree_map_node_t **kids = children (map, node);
+  memmove (key_at (map, node, 1), key_at (map, node, 0),
+           node->count * map->key_size);
+  memmove (&kids[1], &kids[0],
+           (node->count + 1) * sizeof (btree_map_node_t *));
+  memcpy (key_at (map, node, 0), separator, map->key_size);
+  kids[0] = children (map, left)[left->count];
+  node->count++;
+
+  memcpy (separator, key_at (map, left, left->count - 1), map->key_size);
+  left->count--;
+}
+
+// Moves the first entry of right onto the end of node
+static void
+borrow_from_right (btree_map_t *map, btree_map_node_t *parent, size_t slot,
+                   btree_map_node_t *node, btree_map_node_t *right)
+{
+  void *separator = key_at (map, parent, slot);
+
+  if (node->is_leaf)
+    {
+      memcpy (key_at (map, node, node->count), key_at (map, right, 0),
+              map->key_size);
+      memcpy (value_at (map, node, node->count), value_at (map, right, 0),
+              map->value_size);
+      node->count++;
+      leaf_remove_at (map, right, 0);
+      memcpy (separator, key_at (map, right, 0), map->key_size);
+      return;
+    }
+
+  btree_map_node_t **right_kids = children (map, right);
+  memcpy (key_at (map, node, node->count), separator, map->key_size);
+  children (map, node)[node->count + 1] = right_kids[0];
+  node->count++;
+
+  memcpy (separator, key_at (map, right, 0), map->key_size);
+  memmove (key_at (map, right, 0), key_at (map, right, 1),
+           (right->count - 1) * map->key_size);
+  memmove (&right_kids[0], &right_kids[1],
+           right->count * sizeof (btree_map_node_t *));
+  right->count--;
+}
+
+// Appends right and the separator between them to left, then frees right
+static void
+merge_nodes (btree_map_t *map, btree_map_node_t *parent, size_t slot,
+             btree_map_node_t *left, btree_map_node_t *right)
+{
+  if (left->is_leaf)
+    {
+      memcpy (key_at (map, left, left->count), key_at (map, right, 0),
+              right->count * map->key_size);
+      memcpy (value_at (map, left, left->count), value_at (map, right, 0),
+              right->count * map->value_size);
+      left->count += right->count;
+
+      left->next = right->next;
+      if (right->next != NULL)
+        {
+          right->next->prev = left;
+        }
+      else
+        {
+          map->last = left;
+        }
+    }
+  else
+    {
+      memcpy (key_at (map, left, left->count), key_at (map, parent, slot),
+              map->key_size);
+      memcpy (key_at (map, left, left->count + 1), key_at (map, right, 0),
+              right->count * map->key_size);
+      memcpy (&children (map, left)[left->count + 1], children (map, right),
+              (right->count + 1) * sizeof (btree_map_node_t *));
+      left->count += right->count + 1;
+    }
+
+  internal_remove_at (map, parent, slot);
+  node_free (map, right);
+}
+
+/*
+ * Restores minimum occupancy after a removal from the leaf at the end of
+ * path, borrowing from a sibling when one can spare an entry and merging
+ * otherwise. Merges can cascade up to the root, which shrinks the tree when
+ * it is left with a single child.
+ */
+static void
+rebalance (btree_map_t *map, btree_map_node_t **path, size_t *slots,
+           size_t depth, btree_map_node_t *node)
+{
+  while (depth > 0 && node->count < min_count (map, node))
+    {
+      btree_map_node_t *parent = path[depth - 1];
+      size_t slot = slots[depth - 1];
+      btree_map_node_t **kids = children (map, parent);
+      btree_map_node_t *left = slot > 0 ? kids[slot - 1] : NULL;
+      btree_map_node_t *right = slot < parent->count ? kids[slot + 1] : NULL;
+
+      if (left != NULL && left->count > min_count (map, left))
+        {
+          borrow_from_left (map, parent, slot, left, node);
+          return;
+        }
+      if (right != NULL && right->count > min_count (map, right))
+        {
+          borrow_from_right (map, parent, slot, node, right);
+          return;
+        }
+
+      if (left != NULL)
+        {
+          merge_nodes (map, parent, slot - 1, left, node);
+        }
+      else
+        {
+          merge_nodes (map, parent, slot, node, right);
+        }
+
+      node = parent;
+      depth--;
+    }
+
+  btree_map_node_t *root = map->root;
+  if (root->is_leaf && root->count == 0)
+    {
+      node_free (map, root);
+      map->root = NULL;
+      map->first = NULL;
+      map->last = NULL;
+      map->height = 0;
+    }
+  else if (!root->is_leaf && root->count == 0)
+    {
+      map->root = children (map, root)[0];
+      node_free (map, root);
+      map->height--;
+    }
+}
+
+bool
+btree_map_remove (btree_map_t *map, const void *key, void *out_value)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return false;
+    }
+
+  btree_map_node_t *path[BTREE_MAP_MAX_DEPTH];
+  size_t slots[BTREE_MAP_MAX_DEPTH];
+  btree_map_node_t *leaf = descend (map, key, path, slots);
+
+  bool found = false;
+  size_t index = leaf != NULL ? node_search (map, leaf, key, &found) : 0;
+  if (!found)
+    {
+      g_last_error = BTREE_MAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  if (out_value != NULL)
+    {
+      memcpy (out_value, value_at (map, leaf, index), map->value_size);
+    }
+
+  leaf_remove_at (map, leaf, index);
+  map->size--;
+  rebalance (map, path, slots, map->height - 1, leaf);
+
+  return true;
+}
+
+bool
+btree_map_get (const btree_map_t *map, const void *key, void *out_value)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (map == NULL || key == NULL || out_value == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return false;
+    }
+
+  size_t index;
+  btree_map_node_t *leaf = find_value (map, key, &index);
+  if (leaf == NULL)
+    {
+      g_last_error = BTREE_MAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  memcpy (out_value, value_at (map, leaf, index), map->value_size);
+  return true;
+}
+
+bool
+btree_map_contains (const btree_map_t *map, const void *key)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return false;
+    }
+
+  size_t index;
+  return find_value (map, key, &index) != NULL;
+}
+
+size_t
+btree_map_size (const btree_map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return 0;
+    }
+
+  return map->size;
+}
+
+bool
+btree_map_is_empty (const btree_map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return true;
+    }
+
+  return map->size == 0;
+}
+
+bool
+btree_map_clear (btree_map_t *map)
+{
+  g_last_error = BTREE_MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return false;
+    }
+
+  reset (map);
+  return true;
+}
+
+size_t
+btree_map_memory_usage (const btree_map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = BTREE_MAP_NULL_PTR;
+      return 0;
+    }
+
+  return sizeof (btree_map_t) + map->leaf_count * leaf_bytes (map)
+         + map->internal_count * internal_bytes (map);
+}
+
+btree_map_result_t
+btree_map_get_error (void)
+{
+  return g_last_error;
+}
+
+// Iterator implementation
+btree_map_iterator_t
+btree_map_begin (btree_map_t *map)
+{
+  btree_map_iterator_t it = { map, NULL, 0 };
+
+  if (map != NULL)
+    {
+      it.node = map->first;
+    }
+
+  return it;
+}
+
+btree_map_iterator_t
+btree_map_end (btree_map_t *map)
+{
+  btree_map_iterator_t it = { map, NULL, 0 };
+
+  if (map != NULL && map->last != NULL)
+    {
+      it.node = map->last;
+      it.index = map->last->count - 1;
+    }
+
+  return it;
+}
+
+bool
+btree_map_iterator_next (btree_map_iterator_t *it)
+{
+  if (it == NULL || it->map == NULL || it->node == NULL)
+    {
+      return false;
+    }
+
+  if (++it->index == it->node->count)
+    {
+      it->node = it->node->next;
+      it->index = 0;
+    }
+
+  return it->node != NULL;
+}
+
+bool
+btree_map_iterator_prev (btree_map_iterator_t *it)
+{
+  if (it == NULL || it->map == NULL || it->node == NULL)
+    {
+      return false;
+    }
+
+  if (it->index == 0)
+    {
+      it->node = it->node->prev;
+      it->index = it->node != NULL ? it->node->count - 1 : 0;
+    }
+  else
+    {
+      it->index--;
+    }
+
+  return it->node != NULL;
+}
+
+bool
+btree_map_iterator_get (const btree_map_iterator_t *it, void *out_key,
+                        void *out_value)
+{
+  if (!btree_map_iterator_is_valid (it))
+    {
+      return false;
+    }
+
+  if (out_key != NULL)
+    {
+      memcpy (out_key, key_at (it->map, it->node, it->index),
+              it->map->key_size);
+    }
+  if (out_value != NULL)
+    {
+      memcpy (out_value, value_at (it->map, it->node, it->index),
+              it->map->value_size);
+    }
+  return true;
+}
+
+bool
+btree_map_iterator_set (btree_map_iterator_t *it, const void *value)
+{
+  if (!btree_map_iterator_is_valid (it) || value == NULL)
+    {
+      return false;
+    }
+
+  memcpy (value_at (it->map, it->node, it->index), value,
+          it->map->value_size);
+  return true;
+}
+
+bool
+btree_map_iterator_is_valid (const btree_map_iterator_t *it)
+{
+  return it != NULL && it->map != NULL && it->node != NULL
+         && it->index < it->node->count;
+}
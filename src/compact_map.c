@@ -0,0 +1,1007 @@
+#include "cutils/compact_map.h"
+#include "cutils/config.h"
+#include "cutils/time.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#define NIL 0u
+
+static thread_local compact_map_result_t g_last_error = COMPACT_MAP_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+static inline compact_map_link_t *
+link_at (const compact_map_t *map, uint32_t index)
+{
+  return (compact_map_link_t *)(void *)(map->pool
+                                        + (size_t)(index - 1)
+                                              * map->slot_size);
+}
+
+static inline void *
+key_at (const compact_map_t *map, uint32_t index)
+{
+  return map->pool + (size_t)(index - 1) * map->slot_size + map->key_offset;
+}
+
+static inline void *
+value_at (const compact_map_t *map, uint32_t index)
+{
+  return map->pool + (size_t)(index - 1) * map->slot_size
+         + map->value_offset;
+}
+
+static inline uint32_t
+left_of (const compact_map_t *map, uint32_t index)
+{
+  return link_at (map, index)->left;
+}
+
+static inline uint32_t
+right_of (const compact_map_t *map, uint32_t index)
+{
+  return link_at (map, index)->right;
+}
+
+static inline uint32_t
+parent_of (const compact_map_t *map, uint32_t index)
+{
+  return link_at (map, index)->parent_color >> 1;
+}
+
+static inline void
+set_parent (const compact_map_t *map, uint32_t index, uint32_t parent)
+{
+  compact_map_link_t *link = link_at (map, index);
+  link->parent_color = (parent << 1) | (link->parent_color & 1u);
+}
+
+static inline bool
+is_red (const compact_map_t *map, uint32_t index)
+{
+  return index != NIL && (link_at (map, index)->parent_color & 1u) != 0;
+}
+
+static inline void
+set_red (const compact_map_t *map, uint32_t index, bool red)
+{
+  compact_map_link_t *link = link_at (map, index);
+  link->parent_color = (link->parent_color & ~1u) | (red ? 1u : 0u);
+}
+
+// Red-black tree helper functions
+static void
+rotate_left (compact_map_t *map, uint32_t node)
+{
+  uint32_t right = right_of (map, node);
+  uint32_t parent = parent_of (map, node);
+  uint32_t inner = left_of (map, right);
+
+  link_at (map, node)->right = inner;
+  if (inner != NIL)
+    {
+      set_parent (map, inner, node);
+    }
+
+  set_parent (map, right, parent);
+
+  if (parent == NIL)
+    {
+      map->root = right;
+    }
+  else if (node == left_of (map, parent))
+    {
+      link_at (map, parent)->left = right;
+    }
+  else
+    {
+      link_at (map, parent)->right = right;
+    }
+
+  link_at (map, right)->left = node;
+  set_parent (map, node, right);
+}
+
+static void
+rotate_right (compact_map_t *map, uint32_t node)
+{
+  uint32_t left = left_of (map, node);
+  uint32_t parent = parent_of (map, node);
+  uint32_t inner = right_of (map, left);
+
+  link_at (map, node)->left = inner;
+  if (inner != NIL)
+    {
+      set_parent (map, inner, node);
+    }
+
+  set_parent (map, left, parent);
+
+  if (parent == NIL)
+    {
+      map->root = left;
+    }
+  else if (node == right_of (map, parent))
+    {
+      link_at (map, parent)->right = left;
+    }
+  else
+    {
+      link_at (map, parent)->left = left;
+    }
+
+  link_at (map, left)->right = node;
+  set_parent (map, node, left);
+}
+
+static void
+fix_insert (compact_map_t *map, uint32_t node)
+{
+  while (node != map->root && is_red (map, parent_of (map, node)))
+    {
+      uint32_t parent = parent_of (map, node);
+      uint32_t grandparent = parent_of (map, parent);
+
+      if (parent == left_of (map, grandparent))
+        {
+          uint32_t uncle = right_of (map, grandparent);
+
+          if (is_red (map, uncle))
+            {
+              set_red (map, parent, false);
+              set_red (map, uncle, false);
+              set_red (map, grandparent, true);
+              node = grandparent;
+            }
+          else
+            {
+              if (node == right_of (map, parent))
+                {
+                  node = parent;
+                  rotate_left (map, node);
+                  parent = parent_of (map, node);
+                }
+
+              set_red (map, parent, false);
+              set_red (map, grandparent, true);
+              rotate_right (map, grandparent);
+            }
+        }
+      else
+        {
+          uint32_t uncle = left_of (map, grandparent);
+
+          if (is_red (map, uncle))
+            {
+              set_red (map, parent, false);
+              set_red (map, uncle, false);
+              set_red (map, grandparent, true);
+              node = grandparent;
+            }
+          else
+            {
+              if (node == left_of (map, parent))
+                {
+                  node = parent;
+                  rotate_right (map, node);
+                  parent = parent_of (map, node);
+                }
+
+              set_red (map, parent, false);
+              set_red (map, grandparent, true);
+              rotate_left (map, grandparent);
+            }
+        }
+    }
+
+  set_red (map, map->root, false);
+}
+
+static uint32_t
+find_min (const compact_map_t *map, uint32_t node)
+{
+  while (left_of (map, node) != NIL)
+    {
+      node = left_of (map, node);
+    }
+  return node;
+}
+
+static uint32_t
+find_max (const compact_map_t *map, uint32_t node)
+{
+  while (right_of (map, node) != NIL)
+    {
+      node = right_of (map, node);
+    }
+  return node;
+}
+
+static void
+transplant (compact_map_t *map, uint32_t node, uint32_t child)
+{
+  uint32_t parent = parent_of (map, node);
+
+  if (parent == NIL)
+    {
+      map->root = child;
+    }
+  else if (node == left_of (map, parent))
+    {
+      link_at (map, parent)->left = child;
+    }
+  else
+    {
+      link_at (map, parent)->right = child;
+    }
+
+  if (child != NIL)
+    {
+      set_parent (map, child, parent);
+    }
+}
+
+static void
+fix_remove (compact_map_t *map, uint32_t node, uint32_t parent)
+{
+  while (node != map->root && !is_red (map, node))
+    {
+      if (node == left_of (map, parent))
+        {
+          uint32_t sibling = right_of (map, parent);
+
+          if (is_red (map, sibling))
+            {
+              set_red (map, sibling, false);
+              set_red (map, parent, true);
+              rotate_left (map, parent);
+              sibling = right_of (map, parent);
+            }
+
+          if (!is_red (map, left_of (map, sibling))
+              && !is_red (map, right_of (map, sibling)))
+            {
+              set_red (map, sibling, true);
+              node = parent;
+              parent = parent_of (map, node);
+            }
+          else
+            {
+              if (!is_red (map, right_of (map, sibling)))
+                {
+                  set_red (map, left_of (map, sibling), false);
+                  set_red (map, sibling, true);
+                  rotate_right (map, sibling);
+                  sibling = right_of (map, parent);
+                }
+
+              set_red (map, sibling, is_red (map, parent));
+              set_red (map, parent, false);
+              set_red (map, right_of (map, sibling), false);
+              rotate_left (map, parent);
+              node = map->root;
+            }
+        }
+      else
+        {
+          uint32_t sibling = left_of (map, parent);
+
+          if (is_red (map, sibling))
+            {
+              set_red (map, sibling, false);
+              set_red (map, parent, true);
+              rotate_right (map, parent);
+              sibling = left_of (map, parent);
+            }
+
+          if (!is_red (map, left_of (map, sibling))
+              && !is_red (map, right_of (map, sibling)))
+            {
+              set_red (map, sibling, true);
+              node = parent;
+              parent = parent_of (map, node);
+            }
+          else
+            {
+              if (!is_red (map, left_of (map, sibling)))
+                {
+                  set_red (map, right_of (map, sibling), false);
+                  set_red (map, sibling, true);
+                  rotate_left (map, sibling);
+                  sibling = left_of (map, parent);
+                }
+
+              set_red (map, sibling, is_red (map, parent));
+              set_red (map, parent, false);
+              set_red (map, left_of (map, sibling), false);
+              rotate_right (map, parent);
+              node = map->root;
+            }
+        }
+    }
+
+  if (node != NIL)
+    {
+      set_red (map, node, false);
+    }
+}
+
+static uint32_t
+find_node (const compact_map_t *map, const void *key)
+{
+  uint32_t current = map->root;
+
+  while (current != NIL)
+    {
+      int cmp = map->compare (key, key_at (map, current));
+
+      if (cmp == 0)
+        {
+          return current;
+        }
+      else if (cmp < 0)
+        {
+          current = left_of (map, current);
+        }
+      else
+        {
+          current = right_of (map, current);
+        }
+    }
+
+  return NIL;
+}
+
+// Moves the pool to a block of capacity slots; indices are unchanged
+static bool
+resize (compact_map_t *map, uint32_t capacity, uint32_t timeout_ms)
+{
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  unsigned char *pool = cutils_allocate_aligned (
+      map->allocator, (size_t)capacity * map->slot_size,
+      alignof (max_align_t));
+  if (pool == NULL)
+    {
+      g_last_error = COMPACT_MAP_NO_MEMORY;
+      return false;
+    }
+
+  if (!check_timeout ((uint32_t)start_time, timeout_ms))
+    {
+      cutils_deallocate (map->allocator, pool);
+      g_last_error = COMPACT_MAP_TIMEOUT;
+      return false;
+    }
+
+  if (map->pool != NULL)
+    {
+      memcpy (pool, map->pool, (size_t)map->used * map->slot_size);
+      cutils_deallocate (map->allocator, map->pool);
+    }
+
+  map->pool = pool;
+  map->capacity = capacity;
+  return true;
+}
+
+// Takes a slot from the free list, or the next unused one, growing if full
+static uint32_t
+slot_acquire (compact_map_t *map, uint32_t timeout_ms)
+{
+  if (map->free_head != NIL)
+    {
+      uint32_t index = map->free_head;
+      map->free_head = left_of (map, index);
+      return index;
+    }
+
+  if (map->used == map->capacity)
+    {
+      if (map->capacity == COMPACT_MAP_MAX_SIZE)
+        {
+          g_last_error = COMPACT_MAP_OVERFLOW;
+          return NIL;
+        }
+
+      uint32_t capacity = CUTILS_COMPACT_MAP_INIT_CAPACITY;
+      if (map->capacity > COMPACT_MAP_MAX_SIZE / 2)
+        {
+          capacity = COMPACT_MAP_MAX_SIZE;
+        }
+      else if (map->capacity > 0)
+        {
+          capacity = map->capacity * 2;
+        }
+      if (!resize (map, capacity, timeout_ms))
+        {
+          return NIL;
+        }
+    }
+
+  return ++map->used;
+}
+
+static void
+slot_release (compact_map_t *map, uint32_t index)
+{
+  link_at (map, index)->left = map->free_head;
+  map->free_head = index;
+}
+
+compact_map_t *
+compact_map_create_with_allocator (size_t key_size, size_t value_size,
+                                   int (*compare) (const void *a,
+                                                   const void *b),
+                                   cutils_allocator_t *allocator)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (key_size == 0 || value_size == 0 || compare == NULL || allocator == NULL)
+    {
+      g_last_error = COMPACT_MAP_INVALID_ARG;
+      return NULL;
+    }
+
+  if (key_size > UINT32_MAX || value_size > UINT32_MAX)
+    {
+      g_last_error = COMPACT_MAP_OVERFLOW;
+      return NULL;
+    }
+
+  // Keys and values are aligned to the largest power of two fitting in them
+  size_t key_align = alignof (max_align_t);
+  while (key_align > key_size)
+    {
+      key_align /= 2;
+    }
+  size_t value_align = alignof (max_align_t);
+  while (value_align > value_size)
+    {
+      value_align /= 2;
+    }
+
+  size_t slot_align = alignof (compact_map_link_t);
+  slot_align = key_align > slot_align ? key_align : slot_align;
+  slot_align = value_align > slot_align ? value_align : slot_align;
+
+  size_t key_offset = (sizeof (compact_map_link_t) + key_align - 1)
+                      & ~(key_align - 1);
+  size_t value_offset = (key_offset + key_size + value_align - 1)
+                        & ~(value_align - 1);
+  size_t slot_size = (value_offset + value_size + slot_align - 1)
+                     & ~(slot_align - 1);
+
+  if (slot_size > SIZE_MAX / COMPACT_MAP_MAX_SIZE)
+    {
+      g_last_error = COMPACT_MAP_OVERFLOW;
+      return NULL;
+    }
+
+  compact_map_t *map = cutils_allocate_aligned (
+      allocator, sizeof (compact_map_t), CUTILS_ALIGNMENT);
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NO_MEMORY;
+      return NULL;
+    }
+
+  map->pool = NULL;
+  map->root = NIL;
+  map->free_head = NIL;
+  map->capacity = 0;
+  map->used = 0;
+  map->size = 0;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->key_offset = key_offset;
+  map->value_offset = value_offset;
+  map->slot_size = slot_size;
+  map->allocator = allocator;
+  map->compare = compare;
+
+  return map;
+}
+
+compact_map_t *
+compact_map_create (size_t key_size, size_t value_size,
+                    int (*compare) (const void *a, const void *b))
+{
+  return compact_map_create_with_allocator (key_size, value_size, compare,
+                                            cutils_get_default_allocator ());
+}
+
+void
+compact_map_destroy (compact_map_t *map)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return;
+    }
+
+  if (map->pool != NULL)
+    {
+      cutils_deallocate (map->allocator, map->pool);
+    }
+  cutils_deallocate (map->allocator, map);
+}
+
+bool
+compact_map_insert_timeout (compact_map_t *map, const void *key,
+                            const void *value, uint32_t timeout_ms)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL || key == NULL || value == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  uint32_t parent = NIL;
+  uint32_t current = map->root;
+  int cmp = 0;
+
+  while (current != NIL)
+    {
+      cmp = map->compare (key, key_at (map, current));
+      if (cmp == 0)
+        {
+          g_last_error = COMPACT_MAP_KEY_EXISTS;
+          return false;
+        }
+
+      parent = current;
+      current = cmp < 0 ? left_of (map, current) : right_of (map, current);
+    }
+
+  // May move the pool; the descent above only kept indices
+  uint32_t node = slot_acquire (map, timeout_ms);
+  if (node == NIL)
+    {
+      return false;
+    }
+
+  compact_map_link_t *link = link_at (map, node);
+  link->left = NIL;
+  link->right = NIL;
+  link->parent_color = (parent << 1) | 1u;
+  memcpy (key_at (map, node), key, map->key_size);
+  memcpy (value_at (map, node), value, map->value_size);
+
+  if (parent == NIL)
+    {
+      map->root = node;
+    }
+  else if (cmp < 0)
+    {
+      link_at (map, parent)->left = node;
+    }
+  else
+    {
+      link_at (map, parent)->right = node;
+    }
+
+  fix_insert (map, node);
+  map->size++;
+
+  return true;
+}
+
+bool
+compact_map_insert (compact_map_t *map, const void *key, const void *value)
+{
+  return compact_map_insert_timeout (map, key, value,
+                                     CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+compact_map_remove (compact_map_t *map, const void *key, void *out_value)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  uint32_t node = find_node (map, key);
+  if (node == NIL)
+    {
+      g_last_error = COMPACT_MAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  if (out_value != NULL)
+    {
+      memcpy (out_value, value_at (map, node), map->value_size);
+    }
+
+  uint32_t child;
+  uint32_t child_parent;
+  bool removed_red = is_red (map, node);
+
+  if (left_of (map, node) == NIL)
+    {
+      child = right_of (map, node);
+      child_parent = parent_of (map, node);
+      transplant (map, node, child);
+    }
+  else if (right_of (map, node) == NIL)
+    {
+      child = left_of (map, node);
+      child_parent = parent_of (map, node);
+      transplant (map, node, child);
+    }
+  else
+    {
+      // Relink the in-order successor in place of the node, so that other
+      // entries keep their indices
+      uint32_t successor = find_min (map, right_of (map, node));
+      removed_red = is_red (map, successor);
+      child = right_of (map, successor);
+
+      if (parent_of (map, successor) == node)
+        {
+          child_parent = successor;
+        }
+      else
+        {
+          child_parent = parent_of (map, successor);
+          transplant (map, successor, child);
+          link_at (map, successor)->right = right_of (map, node);
+          set_parent (map, right_of (map, successor), successor);
+        }
+
+      transplant (map, node, successor);
+      link_at (map, successor)->left = left_of (map, node);
+      set_parent (map, left_of (map, successor), successor);
+      set_red (map, successor, is_red (map, node));
+    }
+
+  if (!removed_red)
+    {
+      fix_remove (map, child, child_parent);
+    }
+
+  slot_release (map, node);
+  map->size--;
+
+  return true;
+}
+
+bool
+compact_map_get (const compact_map_t *map, const void *key, void *out_value)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL || key == NULL || out_value == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  uint32_t node = find_node (map, key);
+  if (node == NIL)
+    {
+      g_last_error = COMPACT_MAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  memcpy (out_value, value_at (map, node), map->value_size);
+  return true;
+}
+
+bool
+compact_map_contains (const compact_map_t *map, const void *key)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  return find_node (map, key) != NIL;
+}
+
+bool
+compact_map_reserve (compact_map_t *map, size_t count)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  if (count > COMPACT_MAP_MAX_SIZE)
+    {
+      g_last_error = COMPACT_MAP_OVERFLOW;
+      return false;
+    }
+
+  // Freed slots count too, so the pool just needs count slots in total
+  if (count <= map->capacity)
+    {
+      return true;
+    }
+
+  return resize (map, (uint32_t)count, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+size_t
+compact_map_size (const compact_map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return 0;
+    }
+
+  return map->size;
+}
+
+bool
+compact_map_is_empty (const compact_map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return true;
+    }
+
+  return map->size == 0;
+}
+
+bool
+compact_map_clear (compact_map_t *map)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  map->root = NIL;
+  map->free_head = NIL;
+  map->used = 0;
+  map->size = 0;
+
+  return true;
+}
+
+size_t
+compact_map_memory_usage (const compact_map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return 0;
+    }
+
+  return sizeof (compact_map_t) + (size_t)map->capacity * map->slot_size;
+}
+
+/*
+ * Returns the black height of the subtree, or SIZE_MAX if it breaks an
+ * invariant. Keys must lie strictly between those of lower and upper.
+ */
+static size_t
+validate_subtree (const compact_map_t *map, uint32_t node, uint32_t lower,
+                  uint32_t upper, size_t *count)
+{
+  if (node == NIL)
+    {
+      return 1;
+    }
+
+  if (node > map->used || ++*count > map->size)
+    {
+      return SIZE_MAX;
+    }
+
+  if ((lower != NIL
+       && map->compare (key_at (map, node), key_at (map, lower)) <= 0)
+      || (upper != NIL
+          && map->compare (key_at (map, node), key_at (map, upper)) >= 0))
+    {
+      return SIZE_MAX;
+    }
+
+  uint32_t left = left_of (map, node);
+  uint32_t right = right_of (map, node);
+  if ((left != NIL && parent_of (map, left) != node)
+      || (right != NIL && parent_of (map, right) != node))
+    {
+      return SIZE_MAX;
+    }
+
+  if (is_red (map, node) && (is_red (map, left) || is_red (map, right)))
+    {
+      return SIZE_MAX;
+    }
+
+  size_t left_black = validate_subtree (map, left, lower, node, count);
+  size_t right_black = validate_subtree (map, right, node, upper, count);
+  if (left_black == SIZE_MAX || left_black != right_black)
+    {
+      return SIZE_MAX;
+    }
+
+  return left_black + (is_red (map, node) ? 0 : 1);
+}
+
+bool
+compact_map_validate (const compact_map_t *map)
+{
+  g_last_error = COMPACT_MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = COMPACT_MAP_NULL_PTR;
+      return false;
+    }
+
+  if (map->root == NIL)
+    {
+      return map->size == 0;
+    }
+
+  if (parent_of (map, map->root) != NIL || is_red (map, map->root))
+    {
+      return false;
+    }
+
+  size_t count = 0;
+  return validate_subtree (map, map->root, NIL, NIL, &count) != SIZE_MAX
+         && count == map->size;
+}
+
+compact_map_result_t
+compact_map_get_error (void)
+{
+  return g_last_error;
+}
+
+// Iterator implementation
+compact_map_iterator_t
+compact_map_begin (compact_map_t *map)
+{
+  compact_map_iterator_t it = { map, NIL };
+
+  if (map != NULL && map->root != NIL)
+    {
+      it.index = find_min (map, map->root);
+    }
+
+  return it;
+}
+
+compact_map_iterator_t
+compact_map_end (compact_map_t *map)
+{
+  compact_map_iterator_t it = { map, NIL };
+
+  if (map != NULL && map->root != NIL)
+    {
+      it.index = find_max (map, map->root);
+    }
+
+  return it;
+}
+
+bool
+compact_map_iterator_next (compact_map_iterator_t *it)
+{
+  if (it == NULL || it->map == NULL || it->index == NIL)
+    {
+      return false;
+    }
+
+  const compact_map_t *map = it->map;
+  uint32_t node = it->index;
+
+  if (right_of (map, node) != NIL)
+    {
+      it->index = find_min (map, right_of (map, node));
+      return true;
+    }
+
+  uint32_t parent = parent_of (map, node);
+  while (parent != NIL && node == right_of (map, parent))
+    {
+      node = parent;
+      parent = parent_of (map, parent);
+    }
+  it->index = parent;
+
+  return it->index != NIL;
+}
+
+bool
+compact_map_iterator_prev (compact_map_iterator_t *it)
+{
+  if (it == NULL || it->map == NULL || it->index == NIL)
+    {
+      return false;
+    }
+
+  const compact_map_t *map = it->map;
+  uint32_t node = it->index;
+
+  if (left_of (map, node) != NIL)
+    {
+      it->index = find_max (map, left_of (map, node));
+      return true;
+    }
+
+  uint32_t parent = parent_of (map, node);
+  while (parent != NIL && node == left_of (map, parent))
+    {
+      node = parent;
+      parent = parent_of (map, parent);
+    }
+  it->index = parent;
+
+  return it->index != NIL;
+}
+
+bool
+compact_map_iterator_get (const compact_map_iterator_t *it, void *out_key,
+                          void *out_value)
+{
+  if (!compact_map_iterator_is_valid (it))
+    {
+      return false;
+    }
+
+  if (out_key != NULL)
+    {
+      memcpy (out_key, key_at (it->map, it->index), it->map->key_size);
+    }
+  if (out_value != NULL)
+    {
+      memcpy (out_value, value_at (it->map, it->index), it->map->value_size);
+    }
+  return true;
+}
+
+bool
+compact_map_iterator_set (compact_map_iterator_t *it, const void *value)
+{
+  if (!compact_map_iterator_is_valid (it) || value == NULL)
+    {
+      return false;
+    }
+
+  memcpy (value_at (it->map, it->index), value, it->map->value_size);
+  return true;
+}
+
+bool
+compact_map_iterator_is_valid (const compact_map_iterator_t *it)
+{
+  return it != NULL && it->map != NULL && it->index != NIL;
+}
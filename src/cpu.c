@@ -0,0 +1,55 @@
+#include "cutils/cpu.h"
+#include <stdatomic.h>
+
+#define CPU_FEATURES_UNKNOWN UINT32_MAX
+
+static _Atomic uint32_t g_cpu_features = CPU_FEATURES_UNKNOWN;
+
+static uint32_t
+detect_features (void)
+{
+  uint32_t features = 0;
+
+#if CUTILS_SIMD_X86
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse2"))
+    {
+      features |= CUTILS_CPU_SSE2;
+    }
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      features |= CUTILS_CPU_AVX2;
+    }
+  if (__builtin_cpu_supports ("popcnt"))
+    {
+      features |= CUTILS_CPU_POPCNT;
+    }
+  if (__builtin_cpu_supports ("bmi2"))
+    {
+      features |= CUTILS_CPU_BMI2;
+    }
+#endif
+
+  return features;
+}
+
+uint32_t
+cutils_cpu_features (void)
+{
+  // Racing threads compute the same value, so relaxed ordering is enough
+  uint32_t features
+      = atomic_load_explicit (&g_cpu_features, memory_order_relaxed);
+  if (features == CPU_FEATURES_UNKNOWN)
+    {
+      features = detect_features ();
+      atomic_store_explicit (&g_cpu_features, features, memory_order_relaxed);
+    }
+
+  return features;
+}
+
+bool
+cutils_cpu_has (cutils_cpu_feature_t feature)
+{
+  return (cutils_cpu_features () & (uint32_t)feature) != 0;
+}
@@ -0,0 +1,813 @@
+#include "cutils/hashmap.h"
+#include "cutils/config.h"
+#include "cutils/cpu.h"
+#include "cutils/time.h"
+#include <string.h>
+#include <threads.h>
+
+#if CUTILS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// SSE2 is part of the x86-64 baseline, so lookups use it without dispatch
+#if CUTILS_SIMD_X86 && defined(__SSE2__)
+#define GROUP_SSE2 1
+#else
+#define GROUP_SSE2 0
+#endif
+
+#define GROUP_WIDTH 16
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define TAG_MASK 0x7F
+
+#define LSB_BYTES 0x0101010101010101ULL
+#define MSB_BYTES 0x8080808080808080ULL
+
+static thread_local hashmap_result_t g_last_error = HASHMAP_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+static inline uint64_t
+mix64 (uint64_t x)
+{
+  x ^= x >> 32;
+  x *= 0xd6e8feb86659fd93ULL;
+  x ^= x >> 32;
+  x *= 0xd6e8feb86659fd93ULL;
+  x ^= x >> 32;
+  return x;
+}
+
+static inline uint64_t
+hash_bytes (const void *key, size_t key_size)
+{
+  const unsigned char *p = key;
+  uint64_t hash = 0x9e3779b97f4a7c15ULL ^ key_size;
+  size_t i = 0;
+
+  for (; i + 8 <= key_size; i += 8)
+    {
+      uint64_t word;
+      memcpy (&word, p + i, sizeof (word));
+      hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 32;
+    }
+
+  if (i < key_size)
+    {
+      uint64_t word = 0;
+      memcpy (&word, p + i, key_size - i);
+      hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 32;
+    }
+
+  return mix64 (hash);
+}
+
+[[gnu::always_inline]] static inline uint64_t
+hash_key (const hashmap_t *map, const void *key)
+{
+  if (map->hash != NULL)
+    {
+      return map->hash (key, map->key_size);
+    }
+  return hash_bytes (key, map->key_size);
+}
+
+[[gnu::always_inline]] static inline bool
+keys_equal (const hashmap_t *map, const void *a, const void *b)
+{
+  if (map->equal != NULL)
+    {
+      return map->equal (a, b, map->key_size);
+    }
+
+  switch (map->key_size)
+    {
+    case 4:
+      {
+        uint32_t x, y;
+        memcpy (&x, a, sizeof (x));
+        memcpy (&y, b, sizeof (y));
+        return x == y;
+      }
+    case 8:
+      {
+        uint64_t x, y;
+        memcpy (&x, a, sizeof (x));
+        memcpy (&y, b, sizeof (y));
+        return x == y;
+      }
+    default:
+      return memcmp (a, b, map->key_size) == 0;
+    }
+}
+
+#if !GROUP_SSE2
+/*
+ * Packs the top bit of each byte into an 8-bit mask, byte i to bit i.
+ */
+static inline uint32_t
+swar_pack (uint64_t msb)
+{
+  return (uint32_t)(((msb & MSB_BYTES) * 0x0002040810204081ULL) >> 56);
+}
+
+/*
+ * May report a false match next to a real one; callers compare keys anyway.
+ */
+static inline uint32_t
+swar_match (const uint8_t *ctrl, uint8_t tag)
+{
+  uint64_t word;
+  memcpy (&word, ctrl, sizeof (word));
+  uint64_t x = word ^ (LSB_BYTES * tag);
+  return swar_pack ((x - LSB_BYTES) & ~x);
+}
+
+static inline uint32_t
+swar_empty (const uint8_t *ctrl)
+{
+  uint64_t word;
+  memcpy (&word, ctrl, sizeof (word));
+  return swar_pack (word);
+}
+#endif
+
+/*
+ * Bit i of the result is set when control byte i of the group holds tag.
+ */
+[[gnu::always_inline]] static inline uint32_t
+group_match (const uint8_t *ctrl, uint8_t tag)
+{
+#if GROUP_SSE2
+  __m128i group = _mm_loadu_si128 ((const void *)ctrl);
+  return (uint32_t)_mm_movemask_epi8 (
+      _mm_cmpeq_epi8 (group, _mm_set1_epi8 ((char)tag)));
+#else
+  return swar_match (ctrl, tag) | (swar_match (ctrl + 8, tag) << 8);
+#endif
+}
+
+/*
+ * Bit i of the result is set when slot i of the group is empty. Full
+ * control bytes are below 0x80, so the top bits mark the empty slots.
+ */
+[[gnu::always_inline]] static inline uint32_t
+group_empty (const uint8_t *ctrl)
+{
+#if GROUP_SSE2
+  return (uint32_t)_mm_movemask_epi8 (
+      _mm_loadu_si128 ((const void *)ctrl));
+#else
+  return swar_empty (ctrl) | (swar_empty (ctrl + 8) << 8);
+#endif
+}
+
+#if CUTILS_SIMD_X86
+[[gnu::target ("avx2")]] static size_t
+next_full_avx2 (const uint8_t *ctrl, size_t start, size_t capacity)
+{
+  size_t i = start;
+  for (; i + 32 <= capacity; i += 32)
+    {
+      uint32_t empty = (uint32_t)_mm256_movemask_epi8 (
+          _mm256_loadu_si256 ((const void *)(ctrl + i)));
+      if (empty != UINT32_MAX)
+        {
+          return i + (size_t)__builtin_ctz (~empty);
+        }
+    }
+
+  for (; i < capacity; i++)
+    {
+      if (ctrl[i] != CTRL_EMPTY)
+        {
+          return i;
+        }
+    }
+  return capacity;
+}
+#endif
+
+/*
+ * Finds the first full slot at or after start, or returns the capacity.
+ */
+static size_t
+next_full (const hashmap_t *map, size_t start)
+{
+  const uint8_t *ctrl = map->ctrl;
+  size_t capacity = map->capacity;
+
+#if CUTILS_SIMD_X86
+  if (cutils_cpu_has (CUTILS_CPU_AVX2))
+    {
+      return next_full_avx2 (ctrl, start, capacity);
+    }
+#endif
+
+  size_t i = start;
+  for (; i + GROUP_WIDTH <= capacity; i += GROUP_WIDTH)
+    {
+      uint32_t full = ~group_empty (ctrl + i) & 0xFFFF;
+      if (full != 0)
+        {
+          return i + (size_t)__builtin_ctz (full);
+        }
+    }
+
+  for (; i < capacity; i++)
+    {
+      if (ctrl[i] != CTRL_EMPTY)
+        {
+          return i;
+        }
+    }
+  return capacity;
+}
+
+static inline unsigned char *
+slot_at (const hashmap_t *map, size_t index)
+{
+  return map->slots + (index * map->slot_size);
+}
+
+/*
+ * The first GROUP_WIDTH control bytes are mirrored past the end so a group
+ * load starting near the end of the table wraps around without a branch.
+ */
+static inline void
+set_ctrl (hashmap_t *map, size_t index, uint8_t value)
+{
+  map->ctrl[index] = value;
+  if (index < GROUP_WIDTH)
+    {
+      map->ctrl[map->capacity + index] = value;
+    }
+}
+
+static inline size_t
+home_slot (const hashmap_t *map, uint64_t hash)
+{
+  return (size_t)(hash >> 7) & (map->capacity - 1);
+}
+
+static size_t
+find_slot (const hashmap_t *map, const void *key, uint64_t hash)
+{
+  size_t mask = map->capacity - 1;
+  uint8_t tag = (uint8_t)(hash & TAG_MASK);
+  size_t pos = home_slot (map, hash);
+
+  for (;;)
+    {
+      const uint8_t *group = map->ctrl + pos;
+
+      uint32_t match = group_match (group, tag);
+      while (match != 0)
+        {
+          size_t index = (pos + (size_t)__builtin_ctz (match)) & mask;
+          if (keys_equal (map, slot_at (map, index), key))
+            {
+              return index;
+            }
+          match &= match - 1;
+        }
+
+      if (group_empty (group) != 0)
+        {
+          return SIZE_MAX;
+        }
+
+      pos = (pos + GROUP_WIDTH) & mask;
+    }
+}
+
+/*
+ * Returns the first empty slot on the probe path. The load limit
+ * guarantees there is one.
+ */
+static size_t
+find_empty (const hashmap_t *map, uint64_t hash)
+{
+  size_t mask = map->capacity - 1;
+  size_t pos = home_slot (map, hash);
+
+  for (;;)
+    {
+      uint32_t empty = group_empty (map->ctrl + pos);
+      if (empty != 0)
+        {
+          return (pos + (size_t)__builtin_ctz (empty)) & mask;
+        }
+      pos = (pos + GROUP_WIDTH) & mask;
+    }
+}
+
+static inline size_t
+max_load (size_t capacity)
+{
+  return capacity / 100 * CUTILS_HASHMAP_MAX_LOAD_PERCENT
+         + capacity % 100 * CUTILS_HASHMAP_MAX_LOAD_PERCENT / 100;
+}
+
+// Largest power of two fitting in size, capped at the strictest alignment
+static inline size_t
+natural_alignment (size_t size)
+{
+  size_t alignment = alignof (max_align_t);
+  while (alignment > 1 && alignment > size)
+    {
+      alignment /= 2;
+    }
+  return alignment;
+}
+
+static inline size_t
+round_up (size_t value, size_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/*
+ * Allocates a table of the given capacity and moves every entry into it.
+ */
+static bool
+resize (hashmap_t *map, size_t capacity, uint32_t timeout_ms)
+{
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  size_t ctrl_bytes = capacity + GROUP_WIDTH;
+  size_t slots_offset = round_up (ctrl_bytes, alignof (max_align_t));
+  if ((SIZE_MAX - slots_offset) / map->slot_size < capacity)
+    {
+      g_last_error = HASHMAP_OVERFLOW;
+      return false;
+    }
+
+  uint8_t *ctrl = cutils_allocate_aligned (
+      map->allocator, slots_offset + (capacity * map->slot_size),
+      CUTILS_CACHE_LINE_SIZE);
+  if (ctrl == NULL)
+    {
+      g_last_error = HASHMAP_NO_MEMORY;
+      return false;
+    }
+
+  if (!check_timeout ((uint32_t)start_time, timeout_ms))
+    {
+      cutils_deallocate (map->allocator, ctrl);
+      g_last_error = HASHMAP_TIMEOUT;
+      return false;
+    }
+
+  memset (ctrl, CTRL_EMPTY, ctrl_bytes);
+
+  hashmap_t old = *map;
+  map->ctrl = ctrl;
+  map->slots = ctrl + slots_offset;
+  map->capacity = capacity;
+  map->growth_left = max_load (capacity) - map->size;
+
+  if (old.ctrl != NULL)
+    {
+      for (size_t i = next_full (&old, 0); i < old.capacity;
+           i = next_full (&old, i + 1))
+        {
+          const unsigned char *slot = slot_at (&old, i);
+          uint64_t hash = hash_key (map, slot);
+          size_t index = find_empty (map, hash);
+          memcpy (slot_at (map, index), slot, map->slot_size);
+          set_ctrl (map, index, (uint8_t)(hash & TAG_MASK));
+        }
+      cutils_deallocate (map->allocator, old.ctrl);
+    }
+
+  return true;
+}
+
+/*
+ * Smallest power-of-two capacity whose load limit admits count entries.
+ */
+static size_t
+capacity_for (size_t count)
+{
+  size_t capacity = CUTILS_HASHMAP_INIT_CAPACITY;
+  if (capacity < GROUP_WIDTH)
+    {
+      capacity = GROUP_WIDTH;
+    }
+
+  while (max_load (capacity) < count)
+    {
+      if (capacity > SIZE_MAX / 2)
+        {
+          return 0;
+        }
+      capacity *= 2;
+    }
+  return capacity;
+}
+
+/*
+ * Empties a slot, then walks the rest of its probe run and moves back each
+ * entry whose home position allows it, so no tombstone is needed.
+ */
+static void
+erase_slot (hashmap_t *map, size_t hole)
+{
+  size_t mask = map->capacity - 1;
+  size_t next = (hole + 1) & mask;
+
+  while (map->ctrl[next] != CTRL_EMPTY)
+    {
+      size_t home = home_slot (map, hash_key (map, slot_at (map, next)));
+      if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+          memcpy (slot_at (map, hole), slot_at (map, next), map->slot_size);
+          set_ctrl (map, hole, map->ctrl[next]);
+          hole = next;
+        }
+      next = (next + 1) & mask;
+    }
+
+  set_ctrl (map, hole, CTRL_EMPTY);
+  map->size--;
+  map->growth_left++;
+}
+
+uint64_t
+hashmap_hash_bytes (const void *key, size_t key_size)
+{
+  if (key == NULL)
+    {
+      return 0;
+    }
+  return hash_bytes (key, key_size);
+}
+
+hashmap_t *
+hashmap_create_with_allocator (size_t key_size, size_t value_size,
+                               hashmap_hash_fn hash, hashmap_equal_fn equal,
+                               cutils_allocator_t *allocator)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (key_size == 0 || allocator == NULL)
+    {
+      g_last_error = HASHMAP_INVALID_ARG;
+      return NULL;
+    }
+
+  if (key_size > SIZE_MAX / 4 || value_size > SIZE_MAX / 4)
+    {
+      g_last_error = HASHMAP_OVERFLOW;
+      return NULL;
+    }
+
+  hashmap_t *map = cutils_allocate_aligned (allocator, sizeof (hashmap_t),
+                                            CUTILS_ALIGNMENT);
+  if (map == NULL)
+    {
+      g_last_error = HASHMAP_NO_MEMORY;
+      return NULL;
+    }
+
+  size_t key_align = natural_alignment (key_size);
+  size_t value_align = natural_alignment (value_size);
+  size_t slot_align = key_align > value_align ? key_align : value_align;
+
+  map->ctrl = NULL;
+  map->slots = NULL;
+  map->capacity = 0;
+  map->size = 0;
+  map->growth_left = 0;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->value_offset = round_up (key_size, value_align);
+  map->slot_size = round_up (map->value_offset + value_size, slot_align);
+  map->hash = hash;
+  map->equal = equal;
+  map->allocator = allocator;
+
+  if (!resize (map, capacity_for (0), CUTILS_MAX_OPERATION_TIME_MS))
+    {
+      cutils_deallocate (allocator, map);
+      return NULL;
+    }
+
+  return map;
+}
+
+hashmap_t *
+hashmap_create (size_t key_size, size_t value_size, hashmap_hash_fn hash,
+                hashmap_equal_fn equal)
+{
+  return hashmap_create_with_allocator (key_size, value_size, hash, equal,
+                                        cutils_get_default_allocator ());
+}
+
+void
+hashmap_destroy (hashmap_t *map)
+{
+  if (map == NULL)
+    {
+      return;
+    }
+
+  cutils_deallocate (map->allocator, map->ctrl);
+  cutils_deallocate (map->allocator, map);
+}
+
+bool
+hashmap_insert_timeout (hashmap_t *map, const void *key, const void *value,
+                        uint32_t timeout_ms)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (map == NULL || key == NULL || (value == NULL && map->value_size > 0))
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return false;
+    }
+
+  uint64_t hash = hash_key (map, key);
+  if (find_slot (map, key, hash) != SIZE_MAX)
+    {
+      g_last_error = HASHMAP_KEY_EXISTS;
+      return false;
+    }
+
+  if (map->growth_left == 0)
+    {
+      if (map->capacity > SIZE_MAX / 2)
+        {
+          g_last_error = HASHMAP_OVERFLOW;
+          return false;
+        }
+      if (!resize (map, map->capacity * 2, timeout_ms))
+        {
+          return false;
+        }
+    }
+
+  size_t index = find_empty (map, hash);
+  unsigned char *slot = slot_at (map, index);
+  memcpy (slot, key, map->key_size);
+  if (map->value_size > 0)
+    {
+      memcpy (slot + map->value_offset, value, map->value_size);
+    }
+  set_ctrl (map, index, (uint8_t)(hash & TAG_MASK));
+
+  map->size++;
+  map->growth_left--;
+
+  return true;
+}
+
+bool
+hashmap_insert (hashmap_t *map, const void *key, const void *value)
+{
+  return hashmap_insert_timeout (map, key, value,
+                                 CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+hashmap_remove (hashmap_t *map, const void *key, void *out_value)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return false;
+    }
+
+  size_t index = find_slot (map, key, hash_key (map, key));
+  if (index == SIZE_MAX)
+    {
+      g_last_error = HASHMAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  if (out_value != NULL && map->value_size > 0)
+    {
+      memcpy (out_value, slot_at (map, index) + map->value_offset,
+              map->value_size);
+    }
+
+  erase_slot (map, index);
+  return true;
+}
+
+bool
+hashmap_get (const hashmap_t *map, const void *key, void *out_value)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return false;
+    }
+
+  size_t index = find_slot (map, key, hash_key (map, key));
+  if (index == SIZE_MAX)
+    {
+      g_last_error = HASHMAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  if (out_value != NULL && map->value_size > 0)
+    {
+      memcpy (out_value, slot_at (map, index) + map->value_offset,
+              map->value_size);
+    }
+
+  return true;
+}
+
+void *
+hashmap_get_ptr (const hashmap_t *map, const void *key)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return NULL;
+    }
+
+  size_t index = find_slot (map, key, hash_key (map, key));
+  if (index == SIZE_MAX)
+    {
+      g_last_error = HASHMAP_KEY_NOT_FOUND;
+      return NULL;
+    }
+
+  return slot_at (map, index) + map->value_offset;
+}
+
+bool
+hashmap_contains (const hashmap_t *map, const void *key)
+{
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return false;
+    }
+
+  return find_slot (map, key, hash_key (map, key)) != SIZE_MAX;
+}
+
+bool
+hashmap_reserve (hashmap_t *map, size_t count)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return false;
+    }
+
+  if (count <= map->size + map->growth_left)
+    {
+      return true;
+    }
+
+  size_t capacity = capacity_for (count);
+  if (capacity == 0)
+    {
+      g_last_error = HASHMAP_OVERFLOW;
+      return false;
+    }
+
+  return resize (map, capacity, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+hashmap_clear (hashmap_t *map)
+{
+  g_last_error = HASHMAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = HASHMAP_NULL_PTR;
+      return false;
+    }
+
+  memset (map->ctrl, CTRL_EMPTY, map->capacity + GROUP_WIDTH);
+  map->size = 0;
+  map->growth_left = max_load (map->capacity);
+
+  return true;
+}
+
+size_t
+hashmap_size (const hashmap_t *map)
+{
+  return map ? map->size : 0;
+}
+
+bool
+hashmap_is_empty (const hashmap_t *map)
+{
+  return map == NULL || map->size == 0;
+}
+
+size_t
+hashmap_capacity (const hashmap_t *map)
+{
+  return map ? map->capacity : 0;
+}
+
+size_t
+hashmap_memory_usage (const hashmap_t *map)
+{
+  if (map == NULL)
+    {
+      return 0;
+    }
+
+  return sizeof (hashmap_t) + (size_t)(map->slots - map->ctrl)
+         + (map->capacity * map->slot_size);
+}
+
+hashmap_iterator_t
+hashmap_begin (hashmap_t *map)
+{
+  hashmap_iterator_t it = { map, map ? next_full (map, 0) : 0 };
+  return it;
+}
+
+bool
+hashmap_iterator_next (hashmap_iterator_t *it)
+{
+  if (!hashmap_iterator_is_valid (it))
+    {
+      return false;
+    }
+
+  it->index = next_full (it->map, it->index + 1);
+  return it->index < it->map->capacity;
+}
+
+bool
+hashmap_iterator_get (const hashmap_iterator_t *it, void *out_key,
+                      void *out_value)
+{
+  if (!hashmap_iterator_is_valid (it))
+    {
+      return false;
+    }
+
+  const unsigned char *slot = slot_at (it->map, it->index);
+  if (out_key != NULL)
+    {
+      memcpy (out_key, slot, it->map->key_size);
+    }
+  if (out_value != NULL && it->map->value_size > 0)
+    {
+      memcpy (out_value, slot + it->map->value_offset, it->map->value_size);
+    }
+
+  return true;
+}
+
+bool
+hashmap_iterator_set (hashmap_iterator_t *it, const void *value)
+{
+  if (!hashmap_iterator_is_valid (it) || value == NULL)
+    {
+      return false;
+    }
+
+  memcpy (slot_at (it->map, it->index) + it->map->value_offset, value,
+          it->map->value_size);
+  return true;
+}
+
+bool
+hashmap_iterator_is_valid (const hashmap_iterator_t *it)
+{
+  return it != NULL && it->map != NULL && it->index < it->map->capacity;
+}
+
+hashmap_result_t
+hashmap_get_error (void)
+{
+  return g_last_error;
+}
@@ -0,0 +1,305 @@
+#include "cutils/ilist.h"
+#include "cutils/config.h"
+#include <threads.h>
+
+static thread_local cutils_ilist_result_t g_last_error = CUTILS_ILIST_OK;
+
+[[gnu::always_inline]] static inline void
+link_between (cutils_ilist_node_t *node, cutils_ilist_node_t *prev,
+              cutils_ilist_node_t *next)
+{
+  node->prev = prev;
+  node->next = next;
+  prev->next = node;
+  next->prev = node;
+}
+
+[[gnu::always_inline]] static inline void
+unlink_node (cutils_ilist_node_t *node)
+{
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = NULL;
+  node->prev = NULL;
+}
+
+static bool
+check_insert (const cutils_ilist_node_t *pos, const cutils_ilist_node_t *node)
+{
+  if (pos == NULL || node == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return false;
+    }
+
+  if (pos->next == NULL || node->next != NULL)
+    {
+      g_last_error = CUTILS_ILIST_INVALID_ARG;
+      return false;
+    }
+
+  return true;
+}
+
+void
+cutils_ilist_init (cutils_ilist_t *list)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return;
+    }
+
+  list->head.next = &list->head;
+  list->head.prev = &list->head;
+}
+
+void
+cutils_ilist_node_init (cutils_ilist_node_t *node)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (node == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return;
+    }
+
+  node->next = NULL;
+  node->prev = NULL;
+}
+
+bool
+cutils_ilist_is_linked (const cutils_ilist_node_t *node)
+{
+  return node != NULL && node->next != NULL;
+}
+
+bool
+cutils_ilist_is_empty (const cutils_ilist_t *list)
+{
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return true;
+    }
+
+  return list->head.next == &list->head;
+}
+
+size_t
+cutils_ilist_length (const cutils_ilist_t *list)
+{
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return 0;
+    }
+
+  size_t len = 0;
+  for (const cutils_ilist_node_t *node = list->head.next;
+       node != &list->head; node = node->next)
+    {
+      len++;
+    }
+
+  return len;
+}
+
+bool
+cutils_ilist_push_front (cutils_ilist_t *list, cutils_ilist_node_t *node)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return false;
+    }
+
+  return cutils_ilist_insert_after (&list->head, node);
+}
+
+bool
+cutils_ilist_push_back (cutils_ilist_t *list, cutils_ilist_node_t *node)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return false;
+    }
+
+  return cutils_ilist_insert_before (&list->head, node);
+}
+
+bool
+cutils_ilist_insert_before (cutils_ilist_node_t *pos,
+                            cutils_ilist_node_t *node)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (!check_insert (pos, node))
+    {
+      return false;
+    }
+
+  link_between (node, pos->prev, pos);
+  return true;
+}
+
+bool
+cutils_ilist_insert_after (cutils_ilist_node_t *pos, cutils_ilist_node_t *node)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (!check_insert (pos, node))
+    {
+      return false;
+    }
+
+  link_between (node, pos, pos->next);
+  return true;
+}
+
+bool
+cutils_ilist_unlink (cutils_ilist_node_t *node)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (node == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return false;
+    }
+
+  if (node->next != NULL)
+    {
+      unlink_node (node);
+    }
+
+  return true;
+}
+
+cutils_ilist_node_t *
+cutils_ilist_pop_front (cutils_ilist_t *list)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return NULL;
+    }
+
+  if (list->head.next == &list->head)
+    {
+      g_last_error = CUTILS_ILIST_EMPTY;
+      return NULL;
+    }
+
+  cutils_ilist_node_t *node = list->head.next;
+  unlink_node (node);
+  return node;
+}
+
+cutils_ilist_node_t *
+cutils_ilist_pop_back (cutils_ilist_t *list)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return NULL;
+    }
+
+  if (list->head.prev == &list->head)
+    {
+      g_last_error = CUTILS_ILIST_EMPTY;
+      return NULL;
+    }
+
+  cutils_ilist_node_t *node = list->head.prev;
+  unlink_node (node);
+  return node;
+}
+
+cutils_ilist_node_t *
+cutils_ilist_front (const cutils_ilist_t *list)
+{
+  if (list == NULL || list->head.next == &list->head)
+    {
+      return NULL;
+    }
+  return list->head.next;
+}
+
+cutils_ilist_node_t *
+cutils_ilist_back (const cutils_ilist_t *list)
+{
+  if (list == NULL || list->head.prev == &list->head)
+    {
+      return NULL;
+    }
+  return list->head.prev;
+}
+
+cutils_ilist_node_t *
+cutils_ilist_next (const cutils_ilist_t *list, const cutils_ilist_node_t *node)
+{
+  if (list == NULL || node == NULL || node->next == &list->head)
+    {
+      return NULL;
+    }
+  return node->next;
+}
+
+cutils_ilist_node_t *
+cutils_ilist_prev (const cutils_ilist_t *list, const cutils_ilist_node_t *node)
+{
+  if (list == NULL || node == NULL || node->prev == &list->head)
+    {
+      return NULL;
+    }
+  return node->prev;
+}
+
+bool
+cutils_ilist_splice (cutils_ilist_t *dst, cutils_ilist_t *src)
+{
+  g_last_error = CUTILS_ILIST_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = CUTILS_ILIST_NULL_PTR;
+      return false;
+    }
+
+  if (dst == src || src->head.next == &src->head)
+    {
+      return true;
+    }
+
+  cutils_ilist_node_t *first = src->head.next;
+  cutils_ilist_node_t *last = src->head.prev;
+
+  first->prev = dst->head.prev;
+  dst->head.prev->next = first;
+  last->next = &dst->head;
+  dst->head.prev = last;
+
+  src->head.next = &src->head;
+  src->head.prev = &src->head;
+
+  return true;
+}
+
+cutils_ilist_result_t
+cutils_ilist_get_error (void)
+{
+  return g_last_error;
+}
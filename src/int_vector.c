@@ -0,0 +1,1012 @@
+#include "cutils/int_vector.h"
+#include "cutils/config.h"
+#include "cutils/cpu.h"
+#include "cutils/time.h"
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#if CUTILS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define BLOCK_SIZE ((size_t)CUTILS_INT_VECTOR_BLOCK_SIZE)
+
+// Slack after the payload so 64-bit loads and gathers never leave the buffer
+#define DATA_PADDING 8
+
+// Longest LEB128 encoding of a 64-bit value
+#define VARINT_MAX_BYTES 10
+
+// Widest packing the AVX2 unpacker handles: shift (<= 7) + width <= 32
+#define AVX2_MAX_WIDTH 25
+
+static thread_local int_vector_result_t g_last_error = INT_VECTOR_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+/*
+ * Bit packing. Values are stored little-endian, value i of a w-bit run
+ * starting at bit i * w. Each access is one unaligned 64-bit load plus, for
+ * widths that straddle the word, one extra byte.
+ */
+
+[[gnu::always_inline]] static inline uint64_t
+load64 (const uint8_t *p)
+{
+  uint64_t v;
+  memcpy (&v, p, sizeof (v));
+  return v;
+}
+
+[[gnu::always_inline]] static inline void
+store64 (uint8_t *p, uint64_t v)
+{
+  memcpy (p, &v, sizeof (v));
+}
+
+[[gnu::always_inline]] static inline uint64_t
+width_mask (unsigned width)
+{
+  return width >= 64 ? UINT64_MAX : (((uint64_t)1 << width) - 1);
+}
+
+[[gnu::always_inline]] static inline unsigned
+bits_needed (uint64_t value)
+{
+  return value == 0 ? 0 : 64 - (unsigned)__builtin_clzll (value);
+}
+
+[[gnu::always_inline]] static inline size_t
+packed_bytes (size_t count, unsigned width)
+{
+  return ((count * width) + 7) / 8;
+}
+
+[[gnu::always_inline]] static inline uint64_t
+read_bits (const uint8_t *data, size_t bitpos, unsigned width)
+{
+  size_t byte = bitpos >> 3;
+  unsigned shift = (unsigned)(bitpos & 7);
+  uint64_t v = load64 (data + byte) >> shift;
+
+  if (width + shift > 64)
+    {
+      v |= (uint64_t)data[byte + 8] << (64 - shift);
+    }
+
+  return v & width_mask (width);
+}
+
+[[gnu::always_inline]] static inline void
+write_bits (uint8_t *data, size_t bitpos, unsigned width, uint64_t value)
+{
+  size_t byte = bitpos >> 3;
+  unsigned shift = (unsigned)(bitpos & 7);
+  uint64_t mask = width_mask (width);
+  uint64_t word = load64 (data + byte);
+
+  word = (word & ~(mask << shift)) | (value << shift);
+  store64 (data + byte, word);
+
+  if (width + shift > 64)
+    {
+      uint8_t high_mask = (uint8_t)(mask >> (64 - shift));
+      data[byte + 8] = (uint8_t)((data[byte + 8] & ~high_mask)
+                                 | (value >> (64 - shift)));
+    }
+}
+
+/*
+ * Output helpers for bulk decode. Values are written as uint32_t or
+ * uint64_t depending on the destination vector's element size; a 32-bit
+ * destination reports any value that does not fit.
+ */
+
+[[gnu::always_inline]] static inline bool
+store_value (void *out, size_t k, size_t out_len, uint64_t value)
+{
+  if (out_len == 4)
+    {
+      ((uint32_t *)out)[k] = (uint32_t)value;
+      return (value >> 32) == 0;
+    }
+
+  ((uint64_t *)out)[k] = value;
+  return true;
+}
+
+static bool
+unpack_scalar (const uint8_t *data, size_t first, size_t count,
+               unsigned width, void *out, size_t out_len)
+{
+  bool fits = true;
+  size_t bitpos = first * width;
+
+  if (width == 0)
+    {
+      memset (out, 0, count * out_len);
+      return true;
+    }
+
+  for (size_t k = 0; k < count; k++, bitpos += width)
+    {
+      fits &= store_value (out, k, out_len, read_bits (data, bitpos, width));
+    }
+
+  return fits;
+}
+
+#if CUTILS_SIMD_X86
+/*
+ * Eight values of a w-bit run occupy exactly w bytes, so every group of
+ * eight starting at a multiple of eight has the same lane byte offsets and
+ * bit shifts. One gather, one variable shift and one mask decode the group.
+ */
+[[gnu::target ("avx2")]] static size_t
+unpack_avx2 (const uint8_t *data, size_t first, size_t count, unsigned width,
+             void *out, size_t out_len)
+{
+  int offsets[8];
+  int shifts[8];
+
+  for (unsigned j = 0; j < 8; j++)
+    {
+      offsets[j] = (int)((j * width) >> 3);
+      shifts[j] = (int)((j * width) & 7);
+    }
+
+  __m256i offset_v = _mm256_loadu_si256 ((const void *)offsets);
+  __m256i shift_v = _mm256_loadu_si256 ((const void *)shifts);
+  __m256i mask_v = _mm256_set1_epi32 ((int)width_mask (width));
+  const uint8_t *base = data + ((first / 8) * width);
+  size_t done = 0;
+
+  for (; done + 8 <= count; done += 8, base += width)
+    {
+      __m256i v = _mm256_i32gather_epi32 ((const int *)base, offset_v, 1);
+      v = _mm256_and_si256 (_mm256_srlv_epi32 (v, shift_v), mask_v);
+
+      if (out_len == 4)
+        {
+          _mm256_storeu_si256 ((__m256i *)((uint32_t *)out + done), v);
+        }
+      else
+        {
+          uint64_t *dst = (uint64_t *)out + done;
+          _mm256_storeu_si256 (
+              (__m256i *)dst,
+              _mm256_cvtepu32_epi64 (_mm256_castsi256_si128 (v)));
+          _mm256_storeu_si256 (
+              (__m256i *)(dst + 4),
+              _mm256_cvtepu32_epi64 (_mm256_extracti128_si256 (v, 1)));
+        }
+    }
+
+  return done;
+}
+#endif
+
+/*
+ * Decodes count values of a w-bit run starting at value index first. The
+ * AVX2 kernel takes the 8-aligned middle; the ends go through the scalar
+ * path.
+ */
+static bool
+unpack (const uint8_t *data, size_t first, size_t count, unsigned width,
+        void *out, size_t out_len)
+{
+#if CUTILS_SIMD_X86
+  if (width > 0 && width <= AVX2_MAX_WIDTH && count >= 16
+      && cutils_cpu_has (CUTILS_CPU_AVX2))
+    {
+      size_t head = (8 - (first & 7)) & 7;
+      unpack_scalar (data, first, head, width, out, out_len);
+
+      char *rest = (char *)out + (head * out_len);
+      size_t done = unpack_avx2 (data, first + head, count - head, width,
+                                 rest, out_len);
+
+      unpack_scalar (data, first + head + done, count - head - done, width,
+                     rest + (done * out_len), out_len);
+      return true;
+    }
+#endif
+
+  return unpack_scalar (data, first, count, width, out, out_len);
+}
+
+/*
+ * Storage management. The payload buffer always keeps DATA_PADDING zeroed
+ * bytes past its capacity.
+ */
+
+static bool
+ensure_data (int_vector_t *iv, size_t needed)
+{
+  if (needed <= iv->data_capacity)
+    {
+      return true;
+    }
+
+  size_t capacity = iv->data_capacity > 0 ? iv->data_capacity : 64;
+  while (capacity < needed)
+    {
+      if (capacity > (SIZE_MAX - DATA_PADDING) / 2)
+        {
+          g_last_error = INT_VECTOR_OVERFLOW;
+          return false;
+        }
+      capacity *= 2;
+    }
+
+  uint8_t *data = cutils_allocate_aligned (
+      iv->allocator, capacity + DATA_PADDING, CUTILS_ALIGNMENT);
+  if (data == NULL)
+    {
+      g_last_error = INT_VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  if (iv->data_len > 0)
+    {
+      memcpy (data, iv->data, iv->data_len);
+    }
+  memset (data + iv->data_len, 0, capacity + DATA_PADDING - iv->data_len);
+
+  cutils_deallocate (iv->allocator, iv->data);
+  iv->data = data;
+  iv->data_capacity = capacity;
+
+  return true;
+}
+
+static bool
+ensure_block (int_vector_t *iv)
+{
+  if (iv->block_count < iv->block_capacity)
+    {
+      return true;
+    }
+
+  size_t capacity = iv->block_capacity > 0 ? iv->block_capacity * 2 : 8;
+  if (SIZE_MAX / sizeof (int_vector_block_t) < capacity)
+    {
+      g_last_error = INT_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  int_vector_block_t *blocks = cutils_allocate_aligned (
+      iv->allocator, capacity * sizeof (int_vector_block_t),
+      CUTILS_ALIGNMENT);
+  if (blocks == NULL)
+    {
+      g_last_error = INT_VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  if (iv->block_count > 0)
+    {
+      memcpy (blocks, iv->blocks,
+              iv->block_count * sizeof (int_vector_block_t));
+    }
+
+  cutils_deallocate (iv->allocator, iv->blocks);
+  iv->blocks = blocks;
+  iv->block_capacity = capacity;
+
+  return true;
+}
+
+static bool
+fixed_reserve (int_vector_t *iv, size_t count)
+{
+  if (count > SIZE_MAX / 64)
+    {
+      g_last_error = INT_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  return ensure_data (iv, packed_bytes (count, iv->width));
+}
+
+/*
+ * Repacks every value at a larger width. Runs at most 63 times over the
+ * life of a vector.
+ */
+static bool
+fixed_widen (int_vector_t *iv, unsigned width)
+{
+  size_t bytes = packed_bytes (iv->len, width);
+  size_t capacity = bytes > iv->data_capacity ? bytes : iv->data_capacity;
+
+  uint8_t *data = cutils_allocate_aligned (
+      iv->allocator, capacity + DATA_PADDING, CUTILS_ALIGNMENT);
+  if (data == NULL)
+    {
+      g_last_error = INT_VECTOR_NO_MEMORY;
+      return false;
+    }
+  memset (data, 0, capacity + DATA_PADDING);
+
+  for (size_t i = 0; i < iv->len; i++)
+    {
+      write_bits (data, i * width, width,
+                  read_bits (iv->data, i * iv->width, iv->width));
+    }
+
+  cutils_deallocate (iv->allocator, iv->data);
+  iv->data = data;
+  iv->data_capacity = capacity;
+  iv->data_len = bytes;
+  iv->width = (uint8_t)width;
+
+  return true;
+}
+
+/*
+ * Delta blocks. A sealed block stores its first value in the header and
+ * BLOCK_SIZE - 1 deltas, each minus the block's smallest delta, packed at
+ * the width of the largest remainder. Arithmetic wraps modulo 2^64, so
+ * decreasing runs decode correctly.
+ */
+
+static bool
+delta_seal (int_vector_t *iv)
+{
+  const uint64_t *values = iv->pending;
+  int64_t min_delta = INT64_MAX;
+
+  for (size_t k = 1; k < BLOCK_SIZE; k++)
+    {
+      int64_t delta = (int64_t)(values[k] - values[k - 1]);
+      min_delta = delta < min_delta ? delta : min_delta;
+    }
+
+  uint64_t spread = 0;
+  for (size_t k = 1; k < BLOCK_SIZE; k++)
+    {
+      spread |= (values[k] - values[k - 1]) - (uint64_t)min_delta;
+    }
+
+  unsigned width = bits_needed (spread);
+  size_t bytes = packed_bytes (BLOCK_SIZE - 1, width);
+
+  if (!ensure_block (iv) || !ensure_data (iv, iv->data_len + bytes))
+    {
+      return false;
+    }
+
+  uint8_t *payload = iv->data + iv->data_len;
+  if (width > 0)
+    {
+      for (size_t k = 1; k < BLOCK_SIZE; k++)
+        {
+          write_bits (payload, (k - 1) * width, width,
+                      (values[k] - values[k - 1]) - (uint64_t)min_delta);
+        }
+    }
+
+  iv->blocks[iv->block_count++] = (int_vector_block_t){
+    .first = values[0],
+    .min_delta = (uint64_t)min_delta,
+    .offset = iv->data_len,
+    .width = (uint8_t)width,
+  };
+  iv->data_len += bytes;
+
+  return true;
+}
+
+static uint64_t
+delta_get (const int_vector_t *iv, size_t index)
+{
+  size_t block = index / BLOCK_SIZE;
+  size_t k = index % BLOCK_SIZE;
+
+  if (block == iv->block_count)
+    {
+      return iv->pending[k];
+    }
+
+  const int_vector_block_t *b = &iv->blocks[block];
+  const uint8_t *payload = iv->data + b->offset;
+  uint64_t value = b->first + (k * b->min_delta);
+
+  if (b->width > 0)
+    {
+      for (size_t j = 0; j < k; j++)
+        {
+          value += read_bits (payload, j * b->width, b->width);
+        }
+    }
+
+  return value;
+}
+
+static bool
+delta_decode (const int_vector_t *iv, size_t start, size_t count, void *out,
+              size_t out_len)
+{
+  uint64_t deltas[BLOCK_SIZE];
+  bool fits = true;
+  size_t written = 0;
+
+  while (written < count)
+    {
+      size_t index = start + written;
+      size_t block = index / BLOCK_SIZE;
+      size_t k = index % BLOCK_SIZE;
+      size_t take = BLOCK_SIZE - k;
+      take = take < count - written ? take : count - written;
+
+      if (block == iv->block_count)
+        {
+          for (size_t j = 0; j < take; j++)
+            {
+              fits &= store_value (out, written + j, out_len,
+                                   iv->pending[k + j]);
+            }
+          written += take;
+          continue;
+        }
+
+      // Decode the whole block prefix up to the last value needed
+      const int_vector_block_t *b = &iv->blocks[block];
+      unpack (iv->data + b->offset, 0, k + take - 1, b->width, deltas, 8);
+
+      uint64_t value = b->first;
+      for (size_t j = 0; j < k; j++)
+        {
+          value += b->min_delta + deltas[j];
+        }
+
+      fits &= store_value (out, written, out_len, value);
+      for (size_t j = 1; j < take; j++)
+        {
+          value += b->min_delta + deltas[k + j - 1];
+          fits &= store_value (out, written + j, out_len, value);
+        }
+
+      written += take;
+    }
+
+  return fits;
+}
+
+/*
+ * Varint stream. Values are LEB128 encoded; the block table records the
+ * byte offset of every BLOCK_SIZE-th value.
+ */
+
+[[gnu::always_inline]] static inline const uint8_t *
+varint_read (const uint8_t *p, uint64_t *value)
+{
+  uint64_t v = 0;
+  unsigned shift = 0;
+
+  while (*p & 0x80)
+    {
+      v |= (uint64_t)(*p++ & 0x7F) << shift;
+      shift += 7;
+    }
+  *value = v | ((uint64_t)*p++ << shift);
+
+  return p;
+}
+
+[[gnu::always_inline]] static inline const uint8_t *
+varint_skip (const uint8_t *p, size_t count)
+{
+  while (count > 0)
+    {
+      count -= (*p++ & 0x80) == 0;
+    }
+  return p;
+}
+
+static bool
+varint_push (int_vector_t *iv, uint64_t value)
+{
+  if (!ensure_data (iv, iv->data_len + VARINT_MAX_BYTES))
+    {
+      return false;
+    }
+
+  if (iv->len % BLOCK_SIZE == 0)
+    {
+      if (!ensure_block (iv))
+        {
+          return false;
+        }
+      iv->blocks[iv->block_count++]
+          = (int_vector_block_t){ .offset = iv->data_len };
+    }
+
+  uint8_t *p = iv->data + iv->data_len;
+  while (value >= 0x80)
+    {
+      *p++ = (uint8_t)(value | 0x80);
+      value >>= 7;
+    }
+  *p++ = (uint8_t)value;
+
+  iv->data_len = (size_t)(p - iv->data);
+  return true;
+}
+
+static const uint8_t *
+varint_seek (const int_vector_t *iv, size_t index)
+{
+  const uint8_t *p = iv->data + iv->blocks[index / BLOCK_SIZE].offset;
+  return varint_skip (p, index % BLOCK_SIZE);
+}
+
+static bool
+varint_decode (const int_vector_t *iv, size_t start, size_t count, void *out,
+               size_t out_len)
+{
+  const uint8_t *p = varint_seek (iv, start);
+  bool fits = true;
+
+  for (size_t k = 0; k < count; k++)
+    {
+      uint64_t value;
+      p = varint_read (p, &value);
+      fits &= store_value (out, k, out_len, value);
+    }
+
+  return fits;
+}
+
+static bool
+push_value (int_vector_t *iv, uint64_t value)
+{
+  switch (iv->mode)
+    {
+    case INT_VECTOR_FIXED:
+      {
+        unsigned width = bits_needed (value);
+        if (width > iv->width && !fixed_widen (iv, width))
+          {
+            return false;
+          }
+        if (!fixed_reserve (iv, iv->len + 1))
+          {
+            return false;
+          }
+        write_bits (iv->data, iv->len * iv->width, iv->width, value);
+        iv->data_len = packed_bytes (iv->len + 1, iv->width);
+        break;
+      }
+
+    case INT_VECTOR_DELTA:
+      iv->pending[iv->len % BLOCK_SIZE] = value;
+      if ((iv->len + 1) % BLOCK_SIZE == 0 && !delta_seal (iv))
+        {
+          return false;
+        }
+      break;
+
+    case INT_VECTOR_VARINT:
+      if (!varint_push (iv, value))
+        {
+          return false;
+        }
+      break;
+    }
+
+  iv->len++;
+  return true;
+}
+
+/* Whether pushing one more value may have to allocate */
+static bool
+push_may_grow (const int_vector_t *iv, uint64_t value)
+{
+  switch (iv->mode)
+    {
+    case INT_VECTOR_FIXED:
+      return bits_needed (value) > iv->width
+             || packed_bytes (iv->len + 1, iv->width) > iv->data_capacity;
+    case INT_VECTOR_DELTA:
+      return (iv->len + 1) % BLOCK_SIZE == 0;
+    default:
+      return iv->data_len + VARINT_MAX_BYTES > iv->data_capacity
+             || iv->block_count == iv->block_capacity;
+    }
+}
+
+/*
+ * Drops every value pushed since the vector held len values, given the
+ * data_len and block_count it had then. A delta block sealed since then
+ * holds the values that were pending, so they are decoded back first.
+ */
+static void
+push_rollback (int_vector_t *iv, size_t len, size_t data_len,
+               size_t block_count)
+{
+  if (iv->mode == INT_VECTOR_DELTA && iv->block_count > block_count)
+    {
+      delta_decode (iv, block_count * BLOCK_SIZE, len % BLOCK_SIZE,
+                    iv->pending, sizeof (uint64_t));
+    }
+
+  iv->len = len;
+  iv->data_len = data_len;
+  iv->block_count = block_count;
+}
+
+int_vector_t *
+int_vector_create_with_allocator (int_vector_mode_t mode, uint8_t bit_width,
+                                  cutils_allocator_t *allocator)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (allocator == NULL || bit_width > 64
+      || (mode != INT_VECTOR_FIXED && mode != INT_VECTOR_DELTA
+          && mode != INT_VECTOR_VARINT))
+    {
+      g_last_error = INT_VECTOR_INVALID_ARG;
+      return NULL;
+    }
+
+  int_vector_t *iv = cutils_allocate_aligned (allocator, sizeof (int_vector_t),
+                                              CUTILS_ALIGNMENT);
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NO_MEMORY;
+      return NULL;
+    }
+
+  iv->mode = mode;
+  iv->width = mode == INT_VECTOR_FIXED ? (bit_width > 0 ? bit_width : 1) : 0;
+  iv->data = NULL;
+  iv->data_len = 0;
+  iv->data_capacity = 0;
+  iv->blocks = NULL;
+  iv->block_count = 0;
+  iv->block_capacity = 0;
+  iv->pending = NULL;
+  iv->len = 0;
+  iv->allocator = allocator;
+
+  if (mode == INT_VECTOR_DELTA)
+    {
+      iv->pending = cutils_allocate_aligned (
+          allocator, BLOCK_SIZE * sizeof (uint64_t), CUTILS_ALIGNMENT);
+      if (iv->pending == NULL)
+        {
+          cutils_deallocate (allocator, iv);
+          g_last_error = INT_VECTOR_NO_MEMORY;
+          return NULL;
+        }
+    }
+
+  return iv;
+}
+
+int_vector_t *
+int_vector_create (int_vector_mode_t mode, uint8_t bit_width)
+{
+  return int_vector_create_with_allocator (mode, bit_width,
+                                           cutils_get_default_allocator ());
+}
+
+void
+int_vector_destroy (int_vector_t *iv)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return;
+    }
+
+  cutils_deallocate (iv->allocator, iv->data);
+  cutils_deallocate (iv->allocator, iv->blocks);
+  cutils_deallocate (iv->allocator, iv->pending);
+  cutils_deallocate (iv->allocator, iv);
+}
+
+bool
+int_vector_push_timeout (int_vector_t *iv, uint64_t value,
+                         uint32_t timeout_ms)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  if (push_may_grow (iv, value)
+      && !check_timeout ((uint32_t)start_time, timeout_ms))
+    {
+      g_last_error = INT_VECTOR_TIMEOUT;
+      return false;
+    }
+
+  return push_value (iv, value);
+}
+
+bool
+int_vector_push (int_vector_t *iv, uint64_t value)
+{
+  return int_vector_push_timeout (iv, value, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+int_vector_push_vector (int_vector_t *iv, const vector_t *src)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL || src == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (src->elem_len != 4 && src->elem_len != 8)
+    {
+      g_last_error = INT_VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  const uint32_t *src32 = src->data;
+  const uint64_t *src64 = src->data;
+
+  if (iv->mode == INT_VECTOR_FIXED)
+    {
+      // OR of all values has the same top bit as the maximum
+      uint64_t all = 0;
+      for (size_t i = 0; i < src->len; i++)
+        {
+          all |= src->elem_len == 4 ? src32[i] : src64[i];
+        }
+
+      unsigned width = bits_needed (all);
+      if (width > iv->width && !fixed_widen (iv, width))
+        {
+          return false;
+        }
+      if (!fixed_reserve (iv, iv->len + src->len))
+        {
+          return false;
+        }
+
+      for (size_t i = 0; i < src->len; i++)
+        {
+          write_bits (iv->data, (iv->len + i) * iv->width, iv->width,
+                      src->elem_len == 4 ? src32[i] : src64[i]);
+        }
+      iv->len += src->len;
+      iv->data_len = packed_bytes (iv->len, iv->width);
+
+      return true;
+    }
+
+  size_t len = iv->len;
+  size_t data_len = iv->data_len;
+  size_t block_count = iv->block_count;
+
+  for (size_t i = 0; i < src->len; i++)
+    {
+      if (!push_value (iv, src->elem_len == 4 ? src32[i] : src64[i]))
+        {
+          push_rollback (iv, len, data_len, block_count);
+          return false;
+        }
+    }
+
+  return true;
+}
+
+bool
+int_vector_get (const int_vector_t *iv, size_t index, uint64_t *out)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL || out == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= iv->len)
+    {
+      g_last_error = INT_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  switch (iv->mode)
+    {
+    case INT_VECTOR_FIXED:
+      *out = read_bits (iv->data, index * iv->width, iv->width);
+      break;
+    case INT_VECTOR_DELTA:
+      *out = delta_get (iv, index);
+      break;
+    case INT_VECTOR_VARINT:
+      varint_read (varint_seek (iv, index), out);
+      break;
+    }
+
+  return true;
+}
+
+bool
+int_vector_set (int_vector_t *iv, size_t index, uint64_t value)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (iv->mode != INT_VECTOR_FIXED)
+    {
+      g_last_error = INT_VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  if (index >= iv->len)
+    {
+      g_last_error = INT_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  unsigned width = bits_needed (value);
+  if (width > iv->width && !fixed_widen (iv, width))
+    {
+      return false;
+    }
+
+  write_bits (iv->data, index * iv->width, iv->width, value);
+  return true;
+}
+
+bool
+int_vector_decode (const int_vector_t *iv, size_t start, size_t count,
+                   vector_t *out)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL || out == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (out->elem_len != 4 && out->elem_len != 8)
+    {
+      g_last_error = INT_VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  if (start > iv->len || count > iv->len - start)
+    {
+      g_last_error = INT_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  if (count == 0)
+    {
+      return true;
+    }
+
+  if (out->len > SIZE_MAX - count || !vector_reserve (out, out->len + count))
+    {
+      g_last_error = INT_VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  void *dst = (char *)out->data + (out->len * out->elem_len);
+  bool fits = false;
+
+  switch (iv->mode)
+    {
+    case INT_VECTOR_FIXED:
+      fits = unpack (iv->data, start, count, iv->width, dst, out->elem_len);
+      break;
+    case INT_VECTOR_DELTA:
+      fits = delta_decode (iv, start, count, dst, out->elem_len);
+      break;
+    case INT_VECTOR_VARINT:
+      fits = varint_decode (iv, start, count, dst, out->elem_len);
+      break;
+    }
+
+  if (!fits)
+    {
+      g_last_error = INT_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  out->len += count;
+  return true;
+}
+
+bool
+int_vector_clear (int_vector_t *iv)
+{
+  g_last_error = INT_VECTOR_OK;
+
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  iv->len = 0;
+  iv->data_len = 0;
+  iv->block_count = 0;
+  return true;
+}
+
+size_t
+int_vector_length (const int_vector_t *iv)
+{
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return iv->len;
+}
+
+uint8_t
+int_vector_bit_width (const int_vector_t *iv)
+{
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return iv->width;
+}
+
+size_t
+int_vector_memory_usage (const int_vector_t *iv)
+{
+  if (iv == NULL)
+    {
+      g_last_error = INT_VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  size_t usage = sizeof (int_vector_t)
+                 + (iv->block_capacity * sizeof (int_vector_block_t));
+  if (iv->data != NULL)
+    {
+      usage += iv->data_capacity + DATA_PADDING;
+    }
+  if (iv->pending != NULL)
+    {
+      usage += BLOCK_SIZE * sizeof (uint64_t);
+    }
+  return usage;
+}
+
+int_vector_result_t
+int_vector_get_error (void)
+{
+  return g_last_error;
+}
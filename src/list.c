@@ -5,6 +5,9 @@
 
 static thread_local list_result_t g_last_error = LIST_OK;
 
+// Position passed by iterator operations, whose index may be stale.
+#define INDEX_UNKNOWN SIZE_MAX
+
 static bool
 check_timeout ([[maybe_unused]] uint32_t start_time_ms,
                [[maybe_unused]] uint32_t timeout_ms)
@@ -18,6 +21,237 @@ check_timeout ([[maybe_unused]] uint32_t start_time_ms,
 #endif
 }
 
+/*
+ * Allocates a node with the element stored inline. Returns NULL and sets the
+ * error on allocation failure or timeout.
+ */
+static list_node_t *
+node_create (list_t *list, const void *elem, uint32_t timeout_ms)
+{
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  list_node_t *node = cutils_allocate_aligned (
+      list->allocator, sizeof (list_node_t) + list->elem_len,
+      alignof (list_node_t));
+  if (node == NULL)
+    {
+      g_last_error = LIST_NO_MEMORY;
+      return NULL;
+    }
+
+  if (!check_timeout ((uint32_t)start_time, timeout_ms))
+    {
+      cutils_deallocate (list->allocator, node);
+      g_last_error = LIST_TIMEOUT;
+      return NULL;
+    }
+
+  memcpy (node->data, elem, list->elem_len);
+  return node;
+}
+
+/*
+ * Links node before next, or at the tail when next is NULL, as the element
+ * at index. A cached cursor keeps pointing at the same node, or is dropped
+ * when index is INDEX_UNKNOWN.
+ */
+static void
+node_link (list_t *list, list_node_t *node, list_node_t *next, size_t index)
+{
+  node->next = next;
+  node->prev = next != NULL ? next->prev : list->tail;
+
+  if (node->prev != NULL)
+    {
+      node->prev->next = node;
+    }
+  else
+    {
+      list->head = node;
+    }
+
+  if (next != NULL)
+    {
+      next->prev = node;
+    }
+  else
+    {
+      list->tail = node;
+    }
+
+  if (index == INDEX_UNKNOWN)
+    {
+      list->cursor->node = NULL;
+    }
+  else if (list->cursor->node != NULL && index <= list->cursor->index)
+    {
+      list->cursor->index++;
+    }
+
+  list->len++;
+}
+
+/*
+ * Unlinks and frees the node at index, copying its element to out if given.
+ * A cursor on the node moves to a neighbour; the cursor is dropped when
+ * index is INDEX_UNKNOWN.
+ */
+static void
+node_remove (list_t *list, list_node_t *node, size_t index, void *out)
+{
+  if (out != NULL)
+    {
+      memcpy (out, node->data, list->elem_len);
+    }
+
+  if (node->prev != NULL)
+    {
+      node->prev->next = node->next;
+    }
+  else
+    {
+      list->head = node->next;
+    }
+
+  if (node->next != NULL)
+    {
+      node->next->prev = node->prev;
+    }
+  else
+    {
+      list->tail = node->prev;
+    }
+
+  if (index == INDEX_UNKNOWN)
+    {
+      list->cursor->node = NULL;
+    }
+  else if (list->cursor->node == node)
+    {
+      list->cursor->node = node->next;
+      if (list->cursor->node == NULL)
+        {
+          list->cursor->node = node->prev;
+          list->cursor->index = index - 1;
+        }
+    }
+  else if (list->cursor->node != NULL && index < list->cursor->index)
+    {
+      list->cursor->index--;
+    }
+
+  cutils_deallocate (list->allocator, node);
+  list->len--;
+}
+
+/*
+ * Finds the node at index, which must be in bounds, walking from the closest
+ * of the head, the tail and the cursor, and leaves the cursor on it.
+ */
+static list_node_t *
+locate (const list_t *list, size_t index)
+{
+  list_node_t *node = list->head;
+  size_t pos = 0;
+  size_t best = index;
+
+  if (list->len - 1 - index < best)
+    {
+      node = list->tail;
+      pos = list->len - 1;
+      best = list->len - 1 - index;
+    }
+
+  if (list->cursor->node != NULL)
+    {
+      size_t cursor = list->cursor->index;
+      size_t dist = index > cursor ? index - cursor : cursor - index;
+      if (dist < best)
+        {
+          node = list->cursor->node;
+          pos = list->cursor->index;
+        }
+    }
+
+  while (pos < index)
+    {
+      node = node->next;
+      pos++;
+    }
+
+  while (pos > index)
+    {
+      node = node->prev;
+      pos--;
+    }
+
+  list->cursor->node = node;
+  list->cursor->index = index;
+
+  return node;
+}
+
+/*
+ * Merges two chains linked through next only, taking from a on ties.
+ */
+static list_node_t *
+merge_chains (list_node_t *a, list_node_t *b,
+              int (*compare) (const void *a, const void *b))
+{
+  list_node_t head;
+  list_node_t *tail = &head;
+
+  while (a != NULL && b != NULL)
+    {
+      if (compare (a->data, b->data) <= 0)
+        {
+          tail->next = a;
+          a = a->next;
+        }
+      else
+        {
+          tail->next = b;
+          b = b->next;
+        }
+      tail = tail->next;
+    }
+
+  tail->next = a != NULL ? a : b;
+  return head.next;
+}
+
+/*
+ * Makes a next-linked chain the contents of the list, restoring the prev
+ * links and the tail. The cursor is dropped.
+ */
+static void
+adopt_chain (list_t *list, list_node_t *head)
+{
+  list_node_t *prev = NULL;
+  for (list_node_t *node = head; node != NULL; node = node->next)
+    {
+      node->prev = prev;
+      prev = node;
+    }
+
+  list->head = head;
+  list->tail = prev;
+  list->cursor->node = NULL;
+  list->cursor->index = 0;
+}
+
+static bool
+check_transfer (const list_t *dst, const list_t *src)
+{
+  if (dst == src || dst->elem_len != src->elem_len
+      || !cutils_allocator_equal (dst->allocator, src->allocator))
+    {
+      g_last_error = LIST_INVALID_ARG;
+      return false;
+    }
+  return true;
+}
+
 list_t *
 list_create_with_allocator (size_t elem_len, cutils_allocator_t *allocator)
 {
@@ -30,7 +264,9 @@ list_create_with_allocator (size_t elem_len, cutils_allocator_t *allocator)
     }
 
   list_t *list
-      = cutils_allocate_aligned (allocator, sizeof (list_t), CUTILS_ALIGNMENT);
+      = cutils_allocate_aligned (allocator,
+                                 sizeof (list_t) + sizeof (list_cursor_t),
+                                 CUTILS_ALIGNMENT);
   if (list == NULL)
     {
       g_last_error = LIST_NO_MEMORY;
@@ -42,6 +278,9 @@ list_create_with_allocator (size_t elem_len, cutils_allocator_t *allocator)
   list->len = 0;
   list->elem_len = elem_len;
   list->allocator = allocator;
+  list->cursor = (list_cursor_t *)(list + 1);
+  list->cursor->node = NULL;
+  list->cursor->index = 0;
 
   return list;
 }
@@ -49,8 +288,8 @@ list_create_with_allocator (size_t elem_len, cutils_allocator_t *allocator)
 list_t *
 list_create (size_t elem_len)
 {
-  cutils_allocator_t default_allocator = cutils_create_default_allocator ();
-  return list_create_with_allocator (elem_len, &default_allocator);
+  return list_create_with_allocator (elem_len,
+                                     cutils_get_default_allocator ());
 }
 
 list_t *
@@ -84,6 +323,44 @@ list_copy (const list_t *list)
   return copy;
 }
 
+bool
+list_move (list_t *dst, list_t *src)
+{
+  g_last_error = LIST_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = LIST_NULL_PTR;
+      return false;
+    }
+
+  if (dst->elem_len != src->elem_len
+      || !cutils_allocator_equal (dst->allocator, src->allocator))
+    {
+      g_last_error = LIST_INVALID_ARG;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  list_clear (dst);
+  dst->head = src->head;
+  dst->tail = src->tail;
+  dst->len = src->len;
+  *dst->cursor = *src->cursor;
+
+  src->head = NULL;
+  src->tail = NULL;
+  src->len = 0;
+  src->cursor->node = NULL;
+  src->cursor->index = 0;
+
+  return true;
+}
+
 void
 list_destroy (list_t *list)
 {
@@ -99,7 +376,6 @@ list_destroy (list_t *list)
   while (current != NULL)
     {
       list_node_t *next = current->next;
-      cutils_deallocate (list->allocator, current->data);
       cutils_deallocate (list->allocator, current);
       current = next;
     }
@@ -118,49 +394,13 @@ list_push_front_timeout (list_t *list, const void *elem, uint32_t timeout_ms)
       return false;
     }
 
-  uint64_t start_time = cutils_get_current_time_ms ();
-
-  list_node_t *node = cutils_allocate_aligned (
-      list->allocator, sizeof (list_node_t), CUTILS_ALIGNMENT);
+  list_node_t *node = node_create (list, elem, timeout_ms);
   if (node == NULL)
     {
-      g_last_error = LIST_NO_MEMORY;
       return false;
     }
 
-  node->data = cutils_allocate_aligned (list->allocator, list->elem_len,
-                                        CUTILS_ALIGNMENT);
-  if (node->data == NULL)
-    {
-      cutils_deallocate (list->allocator, node);
-      g_last_error = LIST_NO_MEMORY;
-      return false;
-    }
-
-  if (!check_timeout ((uint32_t)start_time, timeout_ms))
-    {
-      cutils_deallocate (list->allocator, node->data);
-      cutils_deallocate (list->allocator, node);
-      g_last_error = LIST_TIMEOUT;
-      return false;
-    }
-
-  memcpy (node->data, elem, list->elem_len);
-  node->next = list->head;
-  node->prev = NULL;
-
-  if (list->head != NULL)
-    {
-      list->head->prev = node;
-    }
-  else
-    {
-      list->tail = node;
-    }
-
-  list->head = node;
-  list->len++;
-
+  node_link (list, node, list->head, 0);
   return true;
 }
 
@@ -181,49 +421,13 @@ list_push_back_timeout (list_t *list, const void *elem, uint32_t timeout_ms)
       return false;
     }
 
-  uint64_t start_time = cutils_get_current_time_ms ();
-
-  list_node_t *node = cutils_allocate_aligned (
-      list->allocator, sizeof (list_node_t), CUTILS_ALIGNMENT);
+  list_node_t *node = node_create (list, elem, timeout_ms);
   if (node == NULL)
     {
-      g_last_error = LIST_NO_MEMORY;
-      return false;
-    }
-
-  node->data = cutils_allocate_aligned (list->allocator, list->elem_len,
-                                        CUTILS_ALIGNMENT);
-  if (node->data == NULL)
-    {
-      cutils_deallocate (list->allocator, node);
-      g_last_error = LIST_NO_MEMORY;
-      return false;
-    }
-
-  if (!check_timeout ((uint32_t)start_time, timeout_ms))
-    {
-      cutils_deallocate (list->allocator, node->data);
-      cutils_deallocate (list->allocator, node);
-      g_last_error = LIST_TIMEOUT;
       return false;
     }
 
-  memcpy (node->data, elem, list->elem_len);
-  node->next = NULL;
-  node->prev = list->tail;
-
-  if (list->tail != NULL)
-    {
-      list->tail->next = node;
-    }
-  else
-    {
-      list->head = node;
-    }
-
-  list->tail = node;
-  list->len++;
-
+  node_link (list, node, NULL, list->len);
   return true;
 }
 
@@ -250,26 +454,7 @@ list_pop_front (list_t *list, void *out)
       return false;
     }
 
-  list_node_t *node = list->head;
-  if (out != NULL)
-    {
-      memcpy (out, node->data, list->elem_len);
-    }
-
-  list->head = node->next;
-  if (list->head != NULL)
-    {
-      list->head->prev = NULL;
-    }
-  else
-    {
-      list->tail = NULL;
-    }
-
-  cutils_deallocate (list->allocator, node->data);
-  cutils_deallocate (list->allocator, node);
-  list->len--;
-
+  node_remove (list, list->head, 0, out);
   return true;
 }
 
@@ -290,26 +475,7 @@ list_pop_back (list_t *list, void *out)
       return false;
     }
 
-  list_node_t *node = list->tail;
-  if (out != NULL)
-    {
-      memcpy (out, node->data, list->elem_len);
-    }
-
-  list->tail = node->prev;
-  if (list->tail != NULL)
-    {
-      list->tail->next = NULL;
-    }
-  else
-    {
-      list->head = NULL;
-    }
-
-  cutils_deallocate (list->allocator, node->data);
-  cutils_deallocate (list->allocator, node);
-  list->len--;
-
+  node_remove (list, list->tail, list->len - 1, out);
   return true;
 }
 
@@ -330,13 +496,7 @@ list_get (const list_t *list, size_t index, void *out)
       return false;
     }
 
-  list_node_t *current = list->head;
-  for (size_t i = 0; i < index; i++)
-    {
-      current = current->next;
-    }
-
-  memcpy (out, current->data, list->elem_len);
+  memcpy (out, locate (list, index)->data, list->elem_len);
   return true;
 }
 
@@ -357,13 +517,7 @@ list_set (list_t *list, size_t index, const void *elem)
       return false;
     }
 
-  list_node_t *current = list->head;
-  for (size_t i = 0; i < index; i++)
-    {
-      current = current->next;
-    }
-
-  memcpy (current->data, elem, list->elem_len);
+  memcpy (locate (list, index)->data, elem, list->elem_len);
   return true;
 }
 
@@ -385,138 +539,226 @@ list_insert_timeout (list_t *list, size_t index, const void *elem,
       return false;
     }
 
-  if (index == 0)
-    {
-      return list_push_front_timeout (list, elem, timeout_ms);
-    }
+  list_node_t *next = index < list->len ? locate (list, index) : NULL;
 
-  if (index == list->len)
+  list_node_t *node = node_create (list, elem, timeout_ms);
+  if (node == NULL)
     {
-      return list_push_back_timeout (list, elem, timeout_ms);
+      return false;
     }
 
-  uint64_t start_time = cutils_get_current_time_ms ();
+  node_link (list, node, next, index);
+  return true;
+}
 
-  list_node_t *current = list->head;
-  for (size_t i = 0; i < index; i++)
+bool
+list_insert (list_t *list, size_t index, const void *elem)
+{
+  return list_insert_timeout (list, index, elem, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+list_remove (list_t *list, size_t index, void *out)
+{
+  g_last_error = LIST_OK;
+
+  if (list == NULL)
     {
-      current = current->next;
+      g_last_error = LIST_NULL_PTR;
+      return false;
     }
 
-  list_node_t *node = cutils_allocate_aligned (
-      list->allocator, sizeof (list_node_t), CUTILS_ALIGNMENT);
-  if (node == NULL)
+  if (index >= list->len)
     {
-      g_last_error = LIST_NO_MEMORY;
+      g_last_error = LIST_OUT_OF_RANGE;
       return false;
     }
 
-  node->data = cutils_allocate_aligned (list->allocator, list->elem_len,
-                                        CUTILS_ALIGNMENT);
-  if (node->data == NULL)
+  node_remove (list, locate (list, index), index, out);
+  return true;
+}
+
+bool
+list_clear (list_t *list)
+{
+  g_last_error = LIST_OK;
+
+  if (list == NULL)
     {
-      cutils_deallocate (list->allocator, node);
-      g_last_error = LIST_NO_MEMORY;
+      g_last_error = LIST_NULL_PTR;
       return false;
     }
 
-  if (!check_timeout ((uint32_t)start_time, timeout_ms))
+  while (list->head != NULL)
     {
-      cutils_deallocate (list->allocator, node->data);
+      list_node_t *node = list->head;
+      list->head = node->next;
       cutils_deallocate (list->allocator, node);
-      g_last_error = LIST_TIMEOUT;
-      return false;
     }
 
-  memcpy (node->data, elem, list->elem_len);
-  node->next = current;
-  node->prev = current->prev;
-  current->prev->next = node;
-  current->prev = node;
-  list->len++;
+  list->tail = NULL;
+  list->len = 0;
+  list->cursor->node = NULL;
+  list->cursor->index = 0;
 
   return true;
 }
 
 bool
-list_insert (list_t *list, size_t index, const void *elem)
-{
-  return list_insert_timeout (list, index, elem, CUTILS_MAX_OPERATION_TIME_MS);
-}
-
-bool
-list_remove (list_t *list, size_t index, void *out)
+list_splice (list_t *dst, size_t index, list_t *src)
 {
   g_last_error = LIST_OK;
 
-  if (list == NULL)
+  if (dst == NULL || src == NULL)
     {
       g_last_error = LIST_NULL_PTR;
       return false;
     }
 
-  if (index >= list->len)
+  if (!check_transfer (dst, src))
+    {
+      return false;
+    }
+
+  if (index > dst->len)
     {
       g_last_error = LIST_OUT_OF_RANGE;
       return false;
     }
 
-  if (index == 0)
+  if (src->head == NULL)
     {
-      return list_pop_front (list, out);
+      return true;
     }
 
-  if (index == list->len - 1)
+  list_node_t *next = index < dst->len ? locate (dst, index) : NULL;
+  list_node_t *prev = next != NULL ? next->prev : dst->tail;
+
+  src->head->prev = prev;
+  src->tail->next = next;
+
+  if (prev != NULL)
     {
-      return list_pop_back (list, out);
+      prev->next = src->head;
+    }
+  else
+    {
+      dst->head = src->head;
     }
 
-  list_node_t *current = list->head;
-  for (size_t i = 0; i < index; i++)
+  if (next != NULL)
     {
-      current = current->next;
+      next->prev = src->tail;
+    }
+  else
+    {
+      dst->tail = src->tail;
     }
 
-  if (out != NULL)
+  if (dst->cursor->node != NULL && index <= dst->cursor->index)
     {
-      memcpy (out, current->data, list->elem_len);
+      dst->cursor->index += src->len;
     }
 
-  current->prev->next = current->next;
-  current->next->prev = current->prev;
+  dst->len += src->len;
 
-  cutils_deallocate (list->allocator, current->data);
-  cutils_deallocate (list->allocator, current);
-  list->len--;
+  src->head = NULL;
+  src->tail = NULL;
+  src->len = 0;
+  src->cursor->node = NULL;
+  src->cursor->index = 0;
 
   return true;
 }
 
 bool
-list_clear (list_t *list)
+list_merge (list_t *dst, list_t *src,
+            int (*compare) (const void *a, const void *b))
 {
   g_last_error = LIST_OK;
 
-  if (list == NULL)
+  if (dst == NULL || src == NULL || compare == NULL)
     {
       g_last_error = LIST_NULL_PTR;
       return false;
     }
 
-  while (list->head != NULL)
+  if (!check_transfer (dst, src))
     {
-      list_node_t *node = list->head;
-      list->head = node->next;
-      cutils_deallocate (list->allocator, node->data);
-      cutils_deallocate (list->allocator, node);
+      return false;
     }
 
-  list->tail = NULL;
-  list->len = 0;
+  if (src->head == NULL)
+    {
+      return true;
+    }
+
+  adopt_chain (dst, merge_chains (dst->head, src->head, compare));
+  dst->len += src->len;
+
+  src->head = NULL;
+  src->tail = NULL;
+  src->len = 0;
+  src->cursor->node = NULL;
+  src->cursor->index = 0;
 
   return true;
 }
 
+bool
+list_sort (list_t *list, int (*compare) (const void *a, const void *b))
+{
+  g_last_error = LIST_OK;
+
+  if (list == NULL || compare == NULL)
+    {
+      g_last_error = LIST_NULL_PTR;
+      return false;
+    }
+
+  if (list->len < 2)
+    {
+      return true;
+    }
+
+  /*
+   * pending[i] holds a sorted run of 2^i nodes or is empty. Each node is
+   * added like a binary increment, merging equal-sized runs as it carries.
+   * Runs in higher slots hold earlier nodes, so merging them on the left
+   * keeps the sort stable.
+   */
+  list_node_t *pending[sizeof (size_t) * 8] = { 0 };
+  list_node_t *node = list->head;
+
+  while (node != NULL)
+    {
+      list_node_t *carry = node;
+      node = node->next;
+      carry->next = NULL;
+
+      size_t i = 0;
+      while (pending[i] != NULL)
+        {
+          carry = merge_chains (pending[i], carry, compare);
+          pending[i] = NULL;
+          i++;
+        }
+      pending[i] = carry;
+    }
+
+  list_node_t *sorted = NULL;
+  for (size_t i = 0; i < sizeof (size_t) * 8; i++)
+    {
+      if (pending[i] != NULL)
+        {
+          sorted = merge_chains (pending[i], sorted, compare);
+        }
+    }
+
+  adopt_chain (list, sorted);
+  return true;
+}
+
 bool
 list_is_empty (const list_t *list)
 {
@@ -609,7 +851,7 @@ list_memory_usage (const list_t *list)
       g_last_error = LIST_NULL_PTR;
       return 0;
     }
-  return sizeof (list_t)
+  return sizeof (list_t) + sizeof (list_cursor_t)
          + (list->len * (sizeof (list_node_t) + list->elem_len));
 }
 
@@ -625,7 +867,7 @@ list_can_perform_operation (const list_t *list,
 
   size_t required_memory = sizeof (list_node_t) + list->elem_len;
   return cutils_can_allocate (list->allocator, required_memory,
-                              CUTILS_ALIGNMENT);
+                              alignof (list_node_t));
 }
 
 // Iterator implementation
@@ -695,3 +937,66 @@ list_iterator_is_valid (const list_iterator_t *it)
 {
   return it != NULL && it->list != NULL && it->current != NULL;
 }
+
+bool
+list_insert_at_timeout (list_iterator_t *it, const void *elem,
+                        uint32_t timeout_ms)
+{
+  g_last_error = LIST_OK;
+
+  if (it == NULL || it->list == NULL || elem == NULL)
+    {
+      g_last_error = LIST_NULL_PTR;
+      return false;
+    }
+
+  list_t *list = it->list;
+  list_node_t *node = node_create (list, elem, timeout_ms);
+  if (node == NULL)
+    {
+      return false;
+    }
+
+  if (it->current != NULL)
+    {
+      node_link (list, node, it->current, INDEX_UNKNOWN);
+    }
+  else
+    {
+      node_link (list, node, NULL, list->len);
+      it->index = list->len - 1;
+    }
+
+  it->current = node;
+  return true;
+}
+
+bool
+list_insert_at (list_iterator_t *it, const void *elem)
+{
+  return list_insert_at_timeout (it, elem, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+list_remove_at (list_iterator_t *it, void *out)
+{
+  g_last_error = LIST_OK;
+
+  if (it == NULL || it->list == NULL)
+    {
+      g_last_error = LIST_NULL_PTR;
+      return false;
+    }
+
+  if (it->current == NULL)
+    {
+      g_last_error = LIST_OUT_OF_RANGE;
+      return false;
+    }
+
+  list_node_t *next = it->current->next;
+  node_remove (it->list, it->current, INDEX_UNKNOWN, out);
+  it->current = next;
+
+  return true;
+}
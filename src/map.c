@@ -20,6 +20,152 @@ check_timeout ([[maybe_unused]] uint32_t start_time_ms,
 #endif
 }
 
+static inline void *
+node_key (map_node_t *node)
+{
+  return node->data;
+}
+
+static inline void *
+node_value (const map_t *map, map_node_t *node)
+{
+  return node->data + map->value_offset;
+}
+
+static inline int
+compare_i32 (const void *a, const void *b)
+{
+  int32_t x;
+  int32_t y;
+  memcpy (&x, a, sizeof (x));
+  memcpy (&y, b, sizeof (y));
+  return (x > y) - (x < y);
+}
+
+static inline int
+compare_u32 (const void *a, const void *b)
+{
+  uint32_t x;
+  uint32_t y;
+  memcpy (&x, a, sizeof (x));
+  memcpy (&y, b, sizeof (y));
+  return (x > y) - (x < y);
+}
+
+static inline int
+compare_i64 (const void *a, const void *b)
+{
+  int64_t x;
+  int64_t y;
+  memcpy (&x, a, sizeof (x));
+  memcpy (&y, b, sizeof (y));
+  return (x > y) - (x < y);
+}
+
+static inline int
+compare_u64 (const void *a, const void *b)
+{
+  uint64_t x;
+  uint64_t y;
+  memcpy (&x, a, sizeof (x));
+  memcpy (&y, b, sizeof (y));
+  return (x > y) - (x < y);
+}
+
+static inline uint32_t
+string_length (const void *key)
+{
+  uint32_t length;
+  memcpy (&length, key, sizeof (length));
+  return length;
+}
+
+static inline int
+compare_string (const void *a, const void *b)
+{
+  uint32_t length_a = string_length (a);
+  uint32_t length_b = string_length (b);
+  int cmp = memcmp ((const unsigned char *)a + sizeof (uint32_t),
+                    (const unsigned char *)b + sizeof (uint32_t),
+                    length_a < length_b ? length_a : length_b);
+  if (cmp != 0)
+    {
+      return cmp;
+    }
+  return (length_a > length_b) - (length_a < length_b);
+}
+
+/*
+ * Compares two keys of the given kind. Called with a constant kind, this
+ * folds to the single comparison for that kind.
+ */
+[[gnu::always_inline]] static inline int
+compare_kind (const map_t *map, map_key_kind_t kind, const void *a,
+              const void *b)
+{
+  switch (kind)
+    {
+    case MAP_KEY_I32:
+      return compare_i32 (a, b);
+    case MAP_KEY_U32:
+      return compare_u32 (a, b);
+    case MAP_KEY_I64:
+      return compare_i64 (a, b);
+    case MAP_KEY_U64:
+      return compare_u64 (a, b);
+    case MAP_KEY_BYTES:
+      return memcmp (a, b, map->key_size);
+    case MAP_KEY_STRING:
+      return compare_string (a, b);
+    case MAP_KEY_CUSTOM:
+    default:
+      return map->compare (a, b);
+    }
+}
+
+static inline int
+compare_keys (const map_t *map, const void *a, const void *b)
+{
+  return compare_kind (map, map->key_kind, a, b);
+}
+
+/*
+ * Returns fn (args..., kind) with the map's key kind as a constant, so each
+ * descent loop is instantiated with its comparison inlined rather than
+ * switching on the kind at every level.
+ */
+#define DISPATCH_KEY_KIND(map, fn, ...)                                       \
+  switch ((map)->key_kind)                                                    \
+    {                                                                         \
+    case MAP_KEY_I32:                                                         \
+      return fn (__VA_ARGS__, MAP_KEY_I32);                                   \
+    case MAP_KEY_U32:                                                         \
+      return fn (__VA_ARGS__, MAP_KEY_U32);                                   \
+    case MAP_KEY_I64:                                                         \
+      return fn (__VA_ARGS__, MAP_KEY_I64);                                   \
+    case MAP_KEY_U64:                                                         \
+      return fn (__VA_ARGS__, MAP_KEY_U64);                                   \
+    case MAP_KEY_BYTES:                                                       \
+      return fn (__VA_ARGS__, MAP_KEY_BYTES);                                 \
+    case MAP_KEY_STRING:                                                      \
+      return fn (__VA_ARGS__, MAP_KEY_STRING);                                \
+    case MAP_KEY_CUSTOM:                                                      \
+    default:                                                                  \
+      return fn (__VA_ARGS__, MAP_KEY_CUSTOM);                                \
+    }
+
+static inline uint32_t
+node_count (const map_node_t *node)
+{
+  return node != NULL ? node->subtree_size : 0;
+}
+
+static inline void
+update_count (map_node_t *node)
+{
+  node->subtree_size = 1 + node_count (node->left) + node_count (node->right);
+}
+
 // Red-black tree helper functions
 static void
 rotate_left (map_t *map, map_node_t *node)
@@ -49,6 +195,12 @@ rotate_left (map_t *map, map_node_t *node)
 
   right->left = node;
   node->parent = right;
+
+  if (map->order_statistics)
+    {
+      right->subtree_size = node->subtree_size;
+      update_count (node);
+    }
 }
 
 static void
@@ -79,6 +231,12 @@ rotate_right (map_t *map, map_node_t *node)
 
   left->right = node;
   node->parent = left;
+
+  if (map->order_statistics)
+    {
+      left->subtree_size = node->subtree_size;
+      update_count (node);
+    }
 }
 
 static void
@@ -140,13 +298,165 @@ fix_insert (map_t *map, map_node_t *node)
 }
 
 static map_node_t *
-find_node (const map_t *map, const void *key)
+find_min (map_node_t *node)
+{
+  while (node->left != NULL)
+    {
+      node = node->left;
+    }
+  return node;
+}
+
+static map_node_t *
+find_max (map_node_t *node)
+{
+  while (node->right != NULL)
+    {
+      node = node->right;
+    }
+  return node;
+}
+
+static map_node_t *
+find_next (map_node_t *node)
+{
+  if (node->right != NULL)
+    {
+      return find_min (node->right);
+    }
+
+  map_node_t *parent = node->parent;
+  while (parent != NULL && node == parent->right)
+    {
+      node = parent;
+      parent = parent->parent;
+    }
+  return parent;
+}
+
+static void
+transplant (map_t *map, map_node_t *node, map_node_t *child)
+{
+  if (node->parent == NULL)
+    {
+      map->root = child;
+    }
+  else if (node == node->parent->left)
+    {
+      node->parent->left = child;
+    }
+  else
+    {
+      node->parent->right = child;
+    }
+
+  if (child != NULL)
+    {
+      child->parent = node->parent;
+    }
+}
+
+static inline bool
+is_red (const map_node_t *node)
+{
+  return node != NULL && node->is_red;
+}
+
+/*
+ * Restores the red-black properties after a black node was unlinked. node
+ * carries the extra black and may be NULL, so its parent is passed as well.
+ */
+static void
+fix_remove (map_t *map, map_node_t *node, map_node_t *parent)
+{
+  while (node != map->root && !is_red (node))
+    {
+      if (node == parent->left)
+        {
+          map_node_t *sibling = parent->right;
+
+          if (sibling->is_red)
+            {
+              sibling->is_red = false;
+              parent->is_red = true;
+              rotate_left (map, parent);
+              sibling = parent->right;
+            }
+
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->is_red = true;
+              node = parent;
+              parent = node->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->right))
+                {
+                  sibling->left->is_red = false;
+                  sibling->is_red = true;
+                  rotate_right (map, sibling);
+                  sibling = parent->right;
+                }
+
+              sibling->is_red = parent->is_red;
+              parent->is_red = false;
+              sibling->right->is_red = false;
+              rotate_left (map, parent);
+              node = map->root;
+            }
+        }
+      else
+        {
+          map_node_t *sibling = parent->left;
+
+          if (sibling->is_red)
+            {
+              sibling->is_red = false;
+              parent->is_red = true;
+              rotate_right (map, parent);
+              sibling = parent->left;
+            }
+
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->is_red = true;
+              node = parent;
+              parent = node->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->left))
+                {
+                  sibling->right->is_red = false;
+                  sibling->is_red = true;
+                  rotate_left (map, sibling);
+                  sibling = parent->left;
+                }
+
+              sibling->is_red = parent->is_red;
+              parent->is_red = false;
+              sibling->left->is_red = false;
+              rotate_right (map, parent);
+              node = map->root;
+            }
+        }
+    }
+
+  if (node != NULL)
+    {
+      node->is_red = false;
+    }
+}
+
+[[gnu::always_inline]] static inline map_node_t *
+find_node_kind (const map_t *map, const void *key, map_key_kind_t kind)
 {
   map_node_t *current = map->root;
 
   while (current != NULL)
     {
-      int cmp = map->compare (key, current->key);
+      int cmp = compare_kind (map, kind, key, node_key (current));
 
       if (cmp == 0)
         {
@@ -165,166 +475,122 @@ find_node (const map_t *map, const void *key)
   return NULL;
 }
 
-map_t *
-map_create_with_allocator (size_t key_size, size_t value_size,
-                           int (*compare) (const void *a, const void *b),
-                           cutils_allocator_t *allocator)
+static map_node_t *
+find_node (const map_t *map, const void *key)
 {
-  g_last_error = MAP_OK;
-
-  if (key_size == 0 || value_size == 0 || compare == NULL || allocator == NULL)
-    {
-      g_last_error = MAP_INVALID_ARG;
-      return NULL;
-    }
-
-  map_t *map
-      = cutils_allocate_aligned (allocator, sizeof (map_t), CUTILS_ALIGNMENT);
-  if (map == NULL)
-    {
-      g_last_error = MAP_NO_MEMORY;
-      return NULL;
-    }
-
-  map->root = NULL;
-  map->size = 0;
-  map->key_size = key_size;
-  map->value_size = value_size;
-  map->allocator = allocator;
-  map->compare = compare;
-
-  return map;
+  DISPATCH_KEY_KIND (map, find_node_kind, map, key);
 }
 
-map_t *
-map_create (size_t key_size, size_t value_size,
-            int (*compare) (const void *a, const void *b))
+[[gnu::always_inline]] static inline map_node_t *
+find_insert_position_kind (const map_t *map, const void *key,
+                           map_node_t **parent, int *last_cmp,
+                           map_key_kind_t kind)
 {
-  cutils_allocator_t default_allocator = cutils_create_default_allocator ();
-  return map_create_with_allocator (key_size, value_size, compare,
-                                    &default_allocator);
-}
+  map_node_t *current = map->root;
+  *parent = NULL;
+  *last_cmp = 0;
 
-static void
-destroy_node (map_t *map, map_node_t *node)
-{
-  if (node == NULL)
+  while (current != NULL)
     {
-      return;
-    }
+      int cmp = compare_kind (map, kind, key, node_key (current));
+      if (cmp == 0)
+        {
+          return current;
+        }
 
-  destroy_node (map, node->left);
-  destroy_node (map, node->right);
+      *parent = current;
+      *last_cmp = cmp;
+      current = cmp < 0 ? current->left : current->right;
+    }
 
-  cutils_deallocate (map->allocator, node->key);
-  cutils_deallocate (map->allocator, node->value);
-  cutils_deallocate (map->allocator, node);
+  return NULL;
 }
 
-void
-map_destroy (map_t *map)
+/*
+ * Descends once looking for key. Returns the matching node, or NULL with
+ * parent and last_cmp describing where a new node would be attached.
+ */
+static map_node_t *
+find_insert_position (const map_t *map, const void *key, map_node_t **parent,
+                      int *last_cmp)
 {
-  g_last_error = MAP_OK;
-
-  if (map == NULL)
-    {
-      g_last_error = MAP_NULL_PTR;
-      return;
-    }
-
-  destroy_node (map, map->root);
-  cutils_deallocate (map->allocator, map);
+  DISPATCH_KEY_KIND (map, find_insert_position_kind, map, key, parent,
+                     last_cmp);
 }
 
-bool
-map_insert_timeout (map_t *map, const void *key, const void *value,
-                    uint32_t timeout_ms)
+/*
+ * Allocates a node holding copies of key and value, or a zeroed value when
+ * value is NULL.
+ */
+static map_node_t *
+node_create (map_t *map, const void *key, const void *value,
+             uint32_t timeout_ms)
 {
-  g_last_error = MAP_OK;
-
-  if (map == NULL || key == NULL || value == NULL)
+  if (map->key_kind == MAP_KEY_STRING
+      && string_length (key) > map->key_size - sizeof (uint32_t))
     {
-      g_last_error = MAP_NULL_PTR;
-      return false;
+      g_last_error = MAP_INVALID_ARG;
+      return NULL;
     }
 
-  uint64_t start_time = cutils_get_current_time_ms ();
-
-  // Check if key already exists
-  if (find_node (map, key) != NULL)
+  if (map->order_statistics && map->size >= UINT32_MAX)
     {
-      g_last_error = MAP_KEY_EXISTS;
-      return false;
+      g_last_error = MAP_OVERFLOW;
+      return NULL;
     }
 
-  // Create new node
+  uint64_t start_time = cutils_get_current_time_ms ();
+
   map_node_t *node = cutils_allocate_aligned (
-      map->allocator, sizeof (map_node_t), CUTILS_ALIGNMENT);
+      map->allocator,
+      sizeof (map_node_t) + map->value_offset + map->value_size,
+      alignof (map_node_t));
   if (node == NULL)
     {
       g_last_error = MAP_NO_MEMORY;
-      return false;
+      return NULL;
     }
 
-  node->key = cutils_allocate_aligned (map->allocator, map->key_size,
-                                       CUTILS_ALIGNMENT);
-  if (node->key == NULL)
+  if (!check_timeout ((uint32_t)start_time, timeout_ms))
     {
       cutils_deallocate (map->allocator, node);
-      g_last_error = MAP_NO_MEMORY;
-      return false;
+      g_last_error = MAP_TIMEOUT;
+      return NULL;
     }
 
-  node->value = cutils_allocate_aligned (map->allocator, map->value_size,
-                                         CUTILS_ALIGNMENT);
-  if (node->value == NULL)
+  memcpy (node_key (node), key, map->key_size);
+  if (value != NULL)
     {
-      cutils_deallocate (map->allocator, node->key);
-      cutils_deallocate (map->allocator, node);
-      g_last_error = MAP_NO_MEMORY;
-      return false;
+      memcpy (node_value (map, node), value, map->value_size);
     }
-
-  if (!check_timeout ((uint32_t)start_time, timeout_ms))
+  else
     {
-      cutils_deallocate (map->allocator, node->value);
-      cutils_deallocate (map->allocator, node->key);
-      cutils_deallocate (map->allocator, node);
-      g_last_error = MAP_TIMEOUT;
-      return false;
+      memset (node_value (map, node), 0, map->value_size);
     }
 
-  memcpy (node->key, key, map->key_size);
-  memcpy (node->value, value, map->value_size);
   node->left = NULL;
   node->right = NULL;
   node->parent = NULL;
   node->is_red = true;
+  node->subtree_size = 1;
 
-  // Insert node
-  map_node_t *current = map->root;
-  map_node_t *parent = NULL;
-
-  while (current != NULL)
-    {
-      parent = current;
-      if (map->compare (key, current->key) < 0)
-        {
-          current = current->left;
-        }
-      else
-        {
-          current = current->right;
-        }
-    }
+  return node;
+}
 
+/*
+ * Links a new node at the position found by find_insert_position and
+ * rebalances.
+ */
+static void
+node_attach (map_t *map, map_node_t *node, map_node_t *parent, int last_cmp)
+{
   node->parent = parent;
 
   if (parent == NULL)
     {
       map->root = node;
     }
-  else if (map->compare (key, parent->key) < 0)
+  else if (last_cmp < 0)
     {
       parent->left = node;
     }
@@ -333,124 +599,609 @@ map_insert_timeout (map_t *map, const void *key, const void *value,
       parent->right = node;
     }
 
+  if (map->order_statistics)
+    {
+      for (map_node_t *ancestor = parent; ancestor != NULL;
+           ancestor = ancestor->parent)
+        {
+          ancestor->subtree_size++;
+        }
+    }
+
   fix_insert (map, node);
   map->size++;
-
-  return true;
 }
 
-bool
+static map_t *
+map_alloc (size_t key_size, size_t value_size, map_key_kind_t kind,
+           int (*compare) (const void *a, const void *b),
+           cutils_allocator_t *allocator)
+{
+  if (key_size == 0 || value_size == 0 || allocator == NULL)
+    {
+      g_last_error = MAP_INVALID_ARG;
+      return NULL;
+    }
+
+  // Values are aligned to the largest power of two dividing into their size
+  size_t value_align = alignof (max_align_t);
+  while (value_align > value_size)
+    {
+      value_align /= 2;
+    }
+
+  if (key_size > SIZE_MAX / 2 - value_size)
+    {
+      g_last_error = MAP_OVERFLOW;
+      return NULL;
+    }
+
+  map_t *map
+      = cutils_allocate_aligned (allocator, sizeof (map_t), CUTILS_ALIGNMENT);
+  if (map == NULL)
+    {
+      g_last_error = MAP_NO_MEMORY;
+      return NULL;
+    }
+
+  map->root = NULL;
+  map->size = 0;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->value_offset = (key_size + value_align - 1) & ~(value_align - 1);
+  map->allocator = allocator;
+  map->key_kind = kind;
+  map->order_statistics = false;
+  map->compare = compare;
+
+  return map;
+}
+
+map_t *
+map_create_with_allocator (size_t key_size, size_t value_size,
+                           int (*compare) (const void *a, const void *b),
+                           cutils_allocator_t *allocator)
+{
+  g_last_error = MAP_OK;
+
+  if (compare == NULL)
+    {
+      g_last_error = MAP_INVALID_ARG;
+      return NULL;
+    }
+
+  return map_alloc (key_size, value_size, MAP_KEY_CUSTOM, compare,
+                    allocator);
+}
+
+map_t *
+map_create (size_t key_size, size_t value_size,
+            int (*compare) (const void *a, const void *b))
+{
+  return map_create_with_allocator (key_size, value_size, compare,
+                                    cutils_get_default_allocator ());
+}
+
+map_t *
+map_create_keyed_with_allocator (map_key_kind_t kind, size_t key_size,
+                                 size_t value_size,
+                                 cutils_allocator_t *allocator)
+{
+  g_last_error = MAP_OK;
+
+  int (*compare) (const void *a, const void *b) = NULL;
+  size_t expected_size = key_size;
+
+  switch (kind)
+    {
+    case MAP_KEY_I32:
+      compare = compare_i32;
+      expected_size = sizeof (int32_t);
+      break;
+    case MAP_KEY_U32:
+      compare = compare_u32;
+      expected_size = sizeof (uint32_t);
+      break;
+    case MAP_KEY_I64:
+      compare = compare_i64;
+      expected_size = sizeof (int64_t);
+      break;
+    case MAP_KEY_U64:
+      compare = compare_u64;
+      expected_size = sizeof (uint64_t);
+      break;
+    case MAP_KEY_BYTES:
+      // memcmp needs key_size, so only compare_keys can order these keys
+      break;
+    case MAP_KEY_STRING:
+      compare = compare_string;
+      if (key_size <= sizeof (uint32_t))
+        {
+          expected_size = 0;
+        }
+      break;
+    case MAP_KEY_CUSTOM:
+    default:
+      g_last_error = MAP_INVALID_ARG;
+      return NULL;
+    }
+
+  if (key_size != expected_size)
+    {
+      g_last_error = MAP_INVALID_ARG;
+      return NULL;
+    }
+
+  return map_alloc (key_size, value_size, kind, compare, allocator);
+}
+
+map_t *
+map_create_keyed (map_key_kind_t kind, size_t key_size, size_t value_size)
+{
+  return map_create_keyed_with_allocator (kind, key_size, value_size,
+                                          cutils_get_default_allocator ());
+}
+
+static void
+destroy_node (map_t *map, map_node_t *node)
+{
+  if (node == NULL)
+    {
+      return;
+    }
+
+  destroy_node (map, node->left);
+  destroy_node (map, node->right);
+
+  cutils_deallocate (map->allocator, node);
+}
+
+void
+map_destroy (map_t *map)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return;
+    }
+
+  destroy_node (map, map->root);
+  cutils_deallocate (map->allocator, map);
+}
+
+bool
+map_insert_timeout (map_t *map, const void *key, const void *value,
+                    uint32_t timeout_ms)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL || key == NULL || value == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return false;
+    }
+
+  map_node_t *parent;
+  int last_cmp;
+  if (find_insert_position (map, key, &parent, &last_cmp) != NULL)
+    {
+      g_last_error = MAP_KEY_EXISTS;
+      return false;
+    }
+
+  map_node_t *node = node_create (map, key, value, timeout_ms);
+  if (node == NULL)
+    {
+      return false;
+    }
+
+  node_attach (map, node, parent, last_cmp);
+  return true;
+}
+
+bool
 map_insert (map_t *map, const void *key, const void *value)
 {
   return map_insert_timeout (map, key, value, CUTILS_MAX_OPERATION_TIME_MS);
 }
 
-bool
-map_remove (map_t *map, const void *key, void *out_value)
+void *
+map_get_or_insert_timeout (map_t *map, const void *key, const void *value,
+                           bool *inserted, uint32_t timeout_ms)
 {
   g_last_error = MAP_OK;
 
+  if (inserted != NULL)
+    {
+      *inserted = false;
+    }
+
   if (map == NULL || key == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return NULL;
+    }
+
+  map_node_t *parent;
+  int last_cmp;
+  map_node_t *node = find_insert_position (map, key, &parent, &last_cmp);
+  if (node != NULL)
+    {
+      return node_value (map, node);
+    }
+
+  node = node_create (map, key, value, timeout_ms);
+  if (node == NULL)
+    {
+      return NULL;
+    }
+
+  node_attach (map, node, parent, last_cmp);
+
+  if (inserted != NULL)
+    {
+      *inserted = true;
+    }
+
+  return node_value (map, node);
+}
+
+void *
+map_get_or_insert (map_t *map, const void *key, const void *value,
+                   bool *inserted)
+{
+  return map_get_or_insert_timeout (map, key, value, inserted,
+                                    CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+map_insert_or_assign_timeout (map_t *map, const void *key, const void *value,
+                              uint32_t timeout_ms)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL || key == NULL || value == NULL)
     {
       g_last_error = MAP_NULL_PTR;
       return false;
     }
 
-  map_node_t *node = find_node (map, key);
+  map_node_t *parent;
+  int last_cmp;
+  map_node_t *node = find_insert_position (map, key, &parent, &last_cmp);
+  if (node != NULL)
+    {
+      memcpy (node_value (map, node), value, map->value_size);
+      return true;
+    }
+
+  node = node_create (map, key, value, timeout_ms);
   if (node == NULL)
     {
-      g_last_error = MAP_KEY_NOT_FOUND;
       return false;
     }
 
-  if (out_value != NULL)
+  node_attach (map, node, parent, last_cmp);
+  return true;
+}
+
+bool
+map_insert_or_assign (map_t *map, const void *key, const void *value)
+{
+  return map_insert_or_assign_timeout (map, key, value,
+                                       CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+/*
+ * Links nodes[0..count) into a perfectly balanced subtree. Nodes on the
+ * deepest level are red and all others black, which gives every path the
+ * same black height whether or not the bottom level is full.
+ */
+static map_node_t *
+build_balanced (map_node_t **nodes, size_t count, size_t depth,
+                size_t red_depth, map_node_t *parent)
+{
+  if (count == 0)
     {
-      memcpy (out_value, node->value, map->value_size);
+      return NULL;
     }
 
-  // TODO: Implement red-black tree deletion
-  // This is a simplified version that doesn't maintain red-black properties
+  size_t mid = count / 2;
+  map_node_t *node = nodes[mid];
+  node->parent = parent;
+  node->is_red = depth > 0 && depth == red_depth;
+  // Only read with order statistics, which cap the size at UINT32_MAX
+  node->subtree_size = (uint32_t)count;
+  node->left = build_balanced (nodes, mid, depth + 1, red_depth, node);
+  node->right = build_balanced (nodes + mid + 1, count - mid - 1, depth + 1,
+                                red_depth, node);
+  return node;
+}
 
-  if (node->left == NULL)
+/*
+ * Merges n sorted pairs into the map, or replaces its contents when replace
+ * is set, then relinks every node into a balanced tree. New nodes are all
+ * allocated before the tree is touched, so failure leaves it unchanged.
+ */
+static bool
+bulk_load (map_t *map, const void *keys, const void *values, size_t n,
+           bool replace, uint32_t timeout_ms)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL || (n > 0 && (keys == NULL || values == NULL)))
+    {
+      g_last_error = MAP_NULL_PTR;
+      return false;
+    }
+
+  const unsigned char *key_bytes = keys;
+  const unsigned char *value_bytes = values;
+
+  for (size_t i = 1; i < n; i++)
     {
-      if (node->parent == NULL)
+      if (compare_keys (map, key_bytes + (i - 1) * map->key_size,
+                        key_bytes + i * map->key_size)
+          >= 0)
         {
-          map->root = node->right;
+          g_last_error = MAP_INVALID_ARG;
+          return false;
         }
-      else if (node == node->parent->left)
+    }
+
+  size_t existing = replace ? 0 : map->size;
+  if (n > SIZE_MAX / sizeof (map_node_t *) - existing
+      || (map->order_statistics && n > UINT32_MAX - existing))
+    {
+      g_last_error = MAP_OVERFLOW;
+      return false;
+    }
+
+  if (existing + n == 0)
+    {
+      destroy_node (map, map->root);
+      map->root = NULL;
+      map->size = 0;
+      return true;
+    }
+
+  map_node_t **nodes = cutils_allocate_aligned (
+      map->allocator, (existing + n) * sizeof (map_node_t *),
+      alignof (map_node_t *));
+  if (nodes == NULL)
+    {
+      g_last_error = MAP_NO_MEMORY;
+      return false;
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  // Allocate nodes for the keys not yet present, after the existing slots
+  map_node_t *first = replace || map->root == NULL ? NULL
+                                                   : find_min (map->root);
+  map_node_t *node = first;
+  size_t added = 0;
+  for (size_t i = 0; i < n; i++)
+    {
+      const void *key = key_bytes + i * map->key_size;
+      int cmp = 1;
+      while (node != NULL
+             && (cmp = compare_keys (map, node_key (node), key)) < 0)
         {
-          node->parent->left = node->right;
+          node = find_next (node);
         }
-      else
+      if (node != NULL && cmp == 0)
         {
-          node->parent->right = node->right;
+          continue;
         }
 
-      if (node->right != NULL)
+      map_node_t *fresh
+          = node_create (map, key, value_bytes + i * map->value_size,
+                         timeout_ms);
+      if (fresh != NULL && !check_timeout ((uint32_t)start_time, timeout_ms))
         {
-          node->right->parent = node->parent;
+          cutils_deallocate (map->allocator, fresh);
+          fresh = NULL;
+          g_last_error = MAP_TIMEOUT;
+        }
+      if (fresh == NULL)
+        {
+          for (size_t j = 0; j < added; j++)
+            {
+              cutils_deallocate (map->allocator, nodes[existing + j]);
+            }
+          cutils_deallocate (map->allocator, nodes);
+          return false;
         }
+      nodes[existing + added++] = fresh;
     }
-  else if (node->right == NULL)
+
+  /*
+   * Merge existing and new nodes into key order. The write index never
+   * passes the next unread new node, so this works in place.
+   */
+  size_t count = 0;
+  size_t next_fresh = existing;
+  node = first;
+  for (size_t i = 0; i < n; i++)
     {
-      if (node->parent == NULL)
+      const void *key = key_bytes + i * map->key_size;
+      int cmp = 1;
+      while (node != NULL
+             && (cmp = compare_keys (map, node_key (node), key)) < 0)
         {
-          map->root = node->left;
+          nodes[count++] = node;
+          node = find_next (node);
         }
-      else if (node == node->parent->left)
+      if (node != NULL && cmp == 0)
         {
-          node->parent->left = node->left;
-        }
-      else
-        {
-          node->parent->right = node->left;
+          memcpy (node_value (map, node), value_bytes + i * map->value_size,
+                  map->value_size);
+          nodes[count++] = node;
+          node = find_next (node);
+          continue;
         }
+      nodes[count++] = nodes[next_fresh++];
+    }
+  while (node != NULL)
+    {
+      nodes[count++] = node;
+      node = find_next (node);
+    }
 
-      if (node->left != NULL)
-        {
-          node->left->parent = node->parent;
-        }
+  if (replace)
+    {
+      destroy_node (map, map->root);
     }
-  else
+
+  size_t red_depth = 0;
+  while ((count >> red_depth) > 1)
     {
-      map_node_t *successor = node->right;
+      red_depth++;
+    }
 
-      while (successor->left != NULL)
-        {
-          successor = successor->left;
-        }
+  map->root = build_balanced (nodes, count, 0, red_depth, NULL);
+  map->size = count;
+
+  cutils_deallocate (map->allocator, nodes);
+  return true;
+}
+
+bool
+map_build_from_sorted_timeout (map_t *map, const void *keys,
+                               const void *values, size_t n,
+                               uint32_t timeout_ms)
+{
+  return bulk_load (map, keys, values, n, true, timeout_ms);
+}
+
+bool
+map_build_from_sorted (map_t *map, const void *keys, const void *values,
+                       size_t n)
+{
+  return map_build_from_sorted_timeout (map, keys, values, n,
+                                        CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+map_merge_sorted_timeout (map_t *map, const void *keys, const void *values,
+                          size_t n, uint32_t timeout_ms)
+{
+  return bulk_load (map, keys, values, n, false, timeout_ms);
+}
+
+bool
+map_merge_sorted (map_t *map, const void *keys, const void *values, size_t n)
+{
+  return map_merge_sorted_timeout (map, keys, values, n,
+                                   CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+void *
+map_find_ptr (const map_t *map, const void *key)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return NULL;
+    }
+
+  map_node_t *node = find_node (map, key);
+  if (node == NULL)
+    {
+      g_last_error = MAP_KEY_NOT_FOUND;
+      return NULL;
+    }
 
-      if (successor != node->right)
+  return node_value (map, node);
+}
+
+bool
+map_remove (map_t *map, const void *key, void *out_value)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return false;
+    }
+
+  map_node_t *node = find_node (map, key);
+  if (node == NULL)
+    {
+      g_last_error = MAP_KEY_NOT_FOUND;
+      return false;
+    }
+
+  if (out_value != NULL)
+    {
+      memcpy (out_value, node_value (map, node), map->value_size);
+    }
+
+  map_node_t *child;
+  map_node_t *child_parent;
+  bool removed_red = node->is_red;
+
+  if (map->order_statistics)
+    {
+      // Shrink the path above the slot that is physically unlinked
+      map_node_t *ancestor = node->left != NULL && node->right != NULL
+                                 ? find_min (node->right)->parent
+                                 : node->parent;
+      for (; ancestor != NULL; ancestor = ancestor->parent)
         {
-          successor->parent->left = successor->right;
-          if (successor->right != NULL)
-            {
-              successor->right->parent = successor->parent;
-            }
-          successor->right = node->right;
-          node->right->parent = successor;
+          ancestor->subtree_size--;
         }
+    }
+
+  if (node->left == NULL)
+    {
+      child = node->right;
+      child_parent = node->parent;
+      transplant (map, node, node->right);
+    }
+  else if (node->right == NULL)
+    {
+      child = node->left;
+      child_parent = node->parent;
+      transplant (map, node, node->left);
+    }
+  else
+    {
+      // Replace the node by its in-order successor, which has no left child
+      map_node_t *successor = find_min (node->right);
+      removed_red = successor->is_red;
+      child = successor->right;
 
-      if (node->parent == NULL)
-        {
-          map->root = successor;
-        }
-      else if (node == node->parent->left)
+      if (successor->parent == node)
         {
-          node->parent->left = successor;
+          child_parent = successor;
         }
       else
         {
-          node->parent->right = successor;
+          child_parent = successor->parent;
+          transplant (map, successor, successor->right);
+          successor->right = node->right;
+          successor->right->parent = successor;
         }
 
-      successor->parent = node->parent;
+      transplant (map, node, successor);
       successor->left = node->left;
-      node->left->parent = successor;
+      successor->left->parent = successor;
+      successor->is_red = node->is_red;
+      successor->subtree_size = node->subtree_size;
+    }
+
+  if (!removed_red)
+    {
+      fix_remove (map, child, child_parent);
     }
 
-  cutils_deallocate (map->allocator, node->key);
-  cutils_deallocate (map->allocator, node->value);
   cutils_deallocate (map->allocator, node);
   map->size--;
 
@@ -475,7 +1226,7 @@ map_get (const map_t *map, const void *key, void *out_value)
       return false;
     }
 
-  memcpy (out_value, node->value, map->value_size);
+  memcpy (out_value, node_value (map, node), map->value_size);
   return true;
 }
 
@@ -546,7 +1297,7 @@ map_memory_usage (const map_t *map)
     }
   return sizeof (map_t)
          + (map->size
-            * (sizeof (map_node_t) + map->key_size + map->value_size));
+            * (sizeof (map_node_t) + map->value_offset + map->value_size));
 }
 
 bool
@@ -560,42 +1311,138 @@ map_can_perform_operation (const map_t *map,
     }
 
   size_t required_memory
-      = sizeof (map_node_t) + map->key_size + map->value_size;
+      = sizeof (map_node_t) + map->value_offset + map->value_size;
   return cutils_can_allocate (map->allocator, required_memory,
-                              CUTILS_ALIGNMENT);
+                              alignof (map_node_t));
 }
 
-map_result_t
-map_get_error (void)
+static size_t
+subtree_height (const map_node_t *node)
 {
-  return g_last_error;
+  if (node == NULL)
+    {
+      return 0;
+    }
+
+  size_t left = subtree_height (node->left);
+  size_t right = subtree_height (node->right);
+  return 1 + (left > right ? left : right);
 }
 
-// Iterator implementation
-static map_node_t *
-find_min (map_node_t *node)
+/*
+ * Returns the black height of a subtree whose keys must lie strictly
+ * between those of lower and upper (NULL for unbounded), or SIZE_MAX if any
+ * ordering, link or red-black property is violated inside it.
+ */
+static size_t
+validate_subtree (const map_t *map, map_node_t *node, map_node_t *lower,
+                  map_node_t *upper)
 {
-  while (node->left != NULL)
+  if (node == NULL)
     {
-      node = node->left;
+      return 1;
     }
-  return node;
+
+  if ((lower != NULL
+       && compare_keys (map, node_key (node), node_key (lower)) <= 0)
+      || (upper != NULL
+          && compare_keys (map, node_key (node), node_key (upper)) >= 0))
+    {
+      return SIZE_MAX;
+    }
+
+  if ((node->left != NULL && node->left->parent != node)
+      || (node->right != NULL && node->right->parent != node))
+    {
+      return SIZE_MAX;
+    }
+
+  if (node->is_red && (is_red (node->left) || is_red (node->right)))
+    {
+      return SIZE_MAX;
+    }
+
+  size_t left_black = validate_subtree (map, node->left, lower, node);
+  size_t right_black = validate_subtree (map, node->right, node, upper);
+  if (left_black == SIZE_MAX || left_black != right_black)
+    {
+      return SIZE_MAX;
+    }
+
+  return left_black + (node->is_red ? 0 : 1);
 }
 
-static map_node_t *
-find_max (map_node_t *node)
+// Returns the number of nodes below node, or SIZE_MAX on a stale count
+static size_t
+validate_counts (const map_node_t *node)
 {
-  while (node->right != NULL)
+  if (node == NULL)
     {
-      node = node->right;
+      return 0;
     }
-  return node;
+
+  size_t left = validate_counts (node->left);
+  size_t right = validate_counts (node->right);
+  if (left == SIZE_MAX || right == SIZE_MAX
+      || node->subtree_size != left + right + 1)
+    {
+      return SIZE_MAX;
+    }
+
+  return node->subtree_size;
+}
+
+size_t
+map_height (const map_t *map)
+{
+  if (map == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return 0;
+    }
+  return subtree_height (map->root);
+}
+
+bool
+map_validate (const map_t *map)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return false;
+    }
+
+  if (map->root == NULL)
+    {
+      return map->size == 0;
+    }
+
+  if (map->root->parent != NULL || map->root->is_red)
+    {
+      return false;
+    }
+
+  if (validate_subtree (map, map->root, NULL, NULL) == SIZE_MAX)
+    {
+      return false;
+    }
+
+  return !map->order_statistics || validate_counts (map->root) != SIZE_MAX;
+}
+
+map_result_t
+map_get_error (void)
+{
+  return g_last_error;
 }
 
+// Iterator implementation
 map_iterator_t
 map_begin (map_t *map)
 {
-  map_iterator_t it = { map, NULL, false };
+  map_iterator_t it = { map, NULL, false, NULL };
 
   if (map != NULL && map->root != NULL)
     {
@@ -609,7 +1456,7 @@ map_begin (map_t *map)
 map_iterator_t
 map_end (map_t *map)
 {
-  map_iterator_t it = { map, NULL, false };
+  map_iterator_t it = { map, NULL, false, NULL };
 
   if (map != NULL && map->root != NULL)
     {
@@ -620,6 +1467,245 @@ map_end (map_t *map)
   return it;
 }
 
+[[gnu::always_inline]] static inline map_node_t *
+find_bound_kind (const map_t *map, const void *key, bool strict,
+                 map_key_kind_t kind)
+{
+  map_node_t *current = map->root;
+  map_node_t *bound = NULL;
+
+  while (current != NULL)
+    {
+      int cmp = compare_kind (map, kind, key, node_key (current));
+      if (cmp < 0 || (cmp == 0 && !strict))
+        {
+          bound = current;
+          current = current->left;
+        }
+      else
+        {
+          current = current->right;
+        }
+    }
+
+  return bound;
+}
+
+/*
+ * Finds the first node whose key is not less than key, or greater than key
+ * when strict is set.
+ */
+static map_node_t *
+find_bound (const map_t *map, const void *key, bool strict)
+{
+  DISPATCH_KEY_KIND (map, find_bound_kind, map, key, strict);
+}
+
+// Finds the node with the greatest key not greater than key
+static map_node_t *
+find_floor (const map_t *map, const void *key)
+{
+  map_node_t *current = map->root;
+  map_node_t *best = NULL;
+
+  while (current != NULL)
+    {
+      int cmp = compare_keys (map, key, node_key (current));
+      if (cmp == 0)
+        {
+          return current;
+        }
+      if (cmp > 0)
+        {
+          best = current;
+          current = current->right;
+        }
+      else
+        {
+          current = current->left;
+        }
+    }
+
+  return best;
+}
+
+static map_iterator_t
+iterator_at (map_t *map, map_node_t *node)
+{
+  map_iterator_t it = { map, node, node != NULL, NULL };
+  return it;
+}
+
+map_iterator_t
+map_lower_bound (map_t *map, const void *key)
+{
+  if (map == NULL || key == NULL)
+    {
+      return iterator_at (map, NULL);
+    }
+
+  return iterator_at (map, find_bound (map, key, false));
+}
+
+map_iterator_t
+map_upper_bound (map_t *map, const void *key)
+{
+  if (map == NULL || key == NULL)
+    {
+      return iterator_at (map, NULL);
+    }
+
+  return iterator_at (map, find_bound (map, key, true));
+}
+
+map_iterator_t
+map_floor (map_t *map, const void *key)
+{
+  if (map == NULL || key == NULL)
+    {
+      return iterator_at (map, NULL);
+    }
+
+  return iterator_at (map, find_floor (map, key));
+}
+
+map_iterator_t
+map_ceiling (map_t *map, const void *key)
+{
+  return map_lower_bound (map, key);
+}
+
+map_iterator_t
+map_range (map_t *map, const void *low, const void *high)
+{
+  map_iterator_t it
+      = low != NULL ? map_lower_bound (map, low) : map_begin (map);
+
+  it.upper = high;
+  if (it.current != NULL && high != NULL
+      && compare_keys (map, node_key (it.current), high) >= 0)
+    {
+      it.current = NULL;
+      it.is_valid = false;
+    }
+
+  return it;
+}
+
+static uint32_t
+fill_counts (map_node_t *node)
+{
+  if (node == NULL)
+    {
+      return 0;
+    }
+
+  uint32_t left = fill_counts (node->left);
+  node->subtree_size = 1 + left + fill_counts (node->right);
+  return node->subtree_size;
+}
+
+bool
+map_enable_order_statistics (map_t *map)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return false;
+    }
+
+  if (map->size > UINT32_MAX)
+    {
+      g_last_error = MAP_OVERFLOW;
+      return false;
+    }
+
+  if (!map->order_statistics)
+    {
+      fill_counts (map->root);
+      map->order_statistics = true;
+    }
+
+  return true;
+}
+
+map_iterator_t
+map_select (map_t *map, size_t rank)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return iterator_at (map, NULL);
+    }
+
+  if (!map->order_statistics)
+    {
+      g_last_error = MAP_INVALID_ARG;
+      return iterator_at (map, NULL);
+    }
+
+  map_node_t *current = map->root;
+  while (current != NULL)
+    {
+      size_t left = node_count (current->left);
+      if (rank == left)
+        {
+          return iterator_at (map, current);
+        }
+      if (rank < left)
+        {
+          current = current->left;
+        }
+      else
+        {
+          rank -= left + 1;
+          current = current->right;
+        }
+    }
+
+  g_last_error = MAP_KEY_NOT_FOUND;
+  return iterator_at (map, NULL);
+}
+
+size_t
+map_rank (const map_t *map, const void *key)
+{
+  g_last_error = MAP_OK;
+
+  if (map == NULL || key == NULL)
+    {
+      g_last_error = MAP_NULL_PTR;
+      return 0;
+    }
+
+  if (!map->order_statistics)
+    {
+      g_last_error = MAP_INVALID_ARG;
+      return 0;
+    }
+
+  size_t rank = 0;
+  map_node_t *current = map->root;
+  while (current != NULL)
+    {
+      if (compare_keys (map, key, node_key (current)) <= 0)
+        {
+          current = current->left;
+        }
+      else
+        {
+          rank += node_count (current->left) + 1;
+          current = current->right;
+        }
+    }
+
+  return rank;
+}
+
 bool
 map_iterator_next (map_iterator_t *it)
 {
@@ -643,6 +1729,12 @@ map_iterator_next (map_iterator_t *it)
       it->current = parent;
     }
 
+  if (it->current != NULL && it->upper != NULL
+      && compare_keys (it->map, node_key (it->current), it->upper) >= 0)
+    {
+      it->current = NULL;
+    }
+
   it->is_valid = it->current != NULL;
   return it->is_valid;
 }
@@ -683,8 +1775,8 @@ map_iterator_get (map_iterator_t *it, void *out_key, void *out_value)
       return false;
     }
 
-  memcpy (out_key, it->current->key, it->map->key_size);
-  memcpy (out_value, it->current->value, it->map->value_size);
+  memcpy (out_key, node_key (it->current), it->map->key_size);
+  memcpy (out_value, node_value (it->map, it->current), it->map->value_size);
   return true;
 }
 
@@ -696,7 +1788,7 @@ map_iterator_set (map_iterator_t *it, const void *value)
       return false;
     }
 
-  memcpy (it->current->value, value, it->map->value_size);
+  memcpy (node_value (it->map, it->current), value, it->map->value_size);
   return true;
 }
 
@@ -0,0 +1,701 @@
+// mremap is a GNU extension
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "cutils/mmap_vector.h"
+#include "cutils/config.h"
+#include "cutils/time.h"
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#if CUTILS_ENABLE_MMAP && (defined(__unix__) || defined(__APPLE__))
+#define MMAP_SUPPORTED 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MMAP_SUPPORTED 0
+#endif
+
+#define MMAP_VECTOR_MAGIC UINT64_C (0x31434556504D4D43) // "CMMPVEC1"
+#define MMAP_VECTOR_VERSION 1
+#define HEADER_SIZE sizeof (mmap_vector_header_t)
+
+static thread_local mmap_vector_result_t g_last_error = MMAP_VECTOR_OK;
+
+static bool
+check_timeout (uint32_t start_time_ms, uint32_t timeout_ms)
+{
+  uint32_t current_time = (uint32_t)cutils_get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+}
+
+[[gnu::always_inline]] static inline uint64_t
+mix64 (uint64_t x)
+{
+  x *= UINT64_C (0x9E3779B97F4A7C15);
+  return x ^ (x >> 32);
+}
+
+/*
+ * Checksum over the element bytes. Four independent lanes keep the
+ * multiplier busy, so checking a large file runs at memory speed.
+ */
+static uint64_t
+checksum (const void *data, size_t bytes)
+{
+  const uint8_t *p = data;
+  uint64_t lanes[4] = { 1, 2, 3, 4 };
+  size_t i = 0;
+
+  for (; i + 32 <= bytes; i += 32)
+    {
+      for (size_t j = 0; j < 4; j++)
+        {
+          uint64_t word;
+          memcpy (&word, p + i + (j * 8), sizeof (word));
+          lanes[j] = mix64 (lanes[j] ^ word);
+        }
+    }
+
+  uint64_t tail = 0;
+  memcpy (&tail, p + i, bytes - i < 8 ? bytes - i : 8);
+  for (size_t k = i + 8; k < bytes; k++)
+    {
+      tail = mix64 (tail ^ p[k]);
+    }
+
+  uint64_t hash = bytes;
+  for (size_t j = 0; j < 4; j++)
+    {
+      hash = mix64 (hash ^ lanes[j]);
+    }
+  return mix64 (hash ^ tail);
+}
+
+static bool
+is_writable (const mmap_vector_t *vec)
+{
+  if ((vec->flags & MMAP_VECTOR_READ_ONLY) != 0)
+    {
+      g_last_error = MMAP_VECTOR_NOT_WRITABLE;
+      return false;
+    }
+  return true;
+}
+
+static uint64_t
+data_checksum (const mmap_vector_t *vec)
+{
+  return checksum (vec->data, (size_t)vec->header->len * vec->elem_len);
+}
+
+/*
+ * Platform layer: everything that touches file descriptors or mappings.
+ */
+
+#if MMAP_SUPPORTED
+static void
+set_mapping (mmap_vector_t *vec, void *map, size_t map_size)
+{
+  vec->header = map;
+  vec->data = (char *)map + HEADER_SIZE;
+  vec->map_size = map_size;
+}
+
+static void *
+os_map (int fd, size_t size, bool writable)
+{
+  int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *map = mmap (NULL, size, prot, MAP_SHARED, fd, 0);
+  return map == MAP_FAILED ? NULL : map;
+}
+
+static void
+os_unmap (void *map, size_t size)
+{
+  munmap (map, size);
+}
+
+static bool
+os_resize (mmap_vector_t *vec, size_t new_size)
+{
+  if (ftruncate (vec->fd, (off_t)new_size) != 0)
+    {
+      return false;
+    }
+
+#ifdef __linux__
+  void *map = mremap (vec->header, vec->map_size, new_size, MREMAP_MAYMOVE);
+  if (map == MAP_FAILED)
+    {
+      return false;
+    }
+#else
+  void *map = os_map (vec->fd, new_size, true);
+  if (map == NULL)
+    {
+      return false;
+    }
+  os_unmap (vec->header, vec->map_size);
+#endif
+
+  set_mapping (vec, map, new_size);
+  return true;
+}
+
+static bool
+os_flush (mmap_vector_t *vec)
+{
+  return msync (vec->header, vec->map_size, MS_SYNC) == 0;
+}
+
+static void
+os_close (mmap_vector_t *vec)
+{
+  os_unmap (vec->header, vec->map_size);
+  close (vec->fd);
+}
+
+/*
+ * Opens and maps the file, writing a fresh header if it is new. Leaves the
+ * handle's mapping fields set on success.
+ */
+static bool
+os_open (mmap_vector_t *vec, const char *path, size_t elem_len)
+{
+  bool writable = (vec->flags & MMAP_VECTOR_READ_ONLY) == 0;
+  int oflags = writable ? O_RDWR : O_RDONLY;
+  if (writable && (vec->flags & MMAP_VECTOR_CREATE) != 0)
+    {
+      oflags |= O_CREAT;
+    }
+
+  vec->fd = open (path, oflags, 0644);
+  if (vec->fd < 0)
+    {
+      g_last_error = MMAP_VECTOR_IO_ERROR;
+      return false;
+    }
+
+  struct stat st;
+  if (fstat (vec->fd, &st) != 0)
+    {
+      close (vec->fd);
+      g_last_error = MMAP_VECTOR_IO_ERROR;
+      return false;
+    }
+
+  size_t size = (size_t)st.st_size;
+  bool fresh = size == 0 && writable && (vec->flags & MMAP_VECTOR_CREATE);
+
+  if (fresh)
+    {
+      if (elem_len == 0)
+        {
+          close (vec->fd);
+          g_last_error = MMAP_VECTOR_INVALID_ARG;
+          return false;
+        }
+
+      size = HEADER_SIZE + (CUTILS_VECTOR_INIT_CAPACITY * elem_len);
+      if (ftruncate (vec->fd, (off_t)size) != 0)
+        {
+          close (vec->fd);
+          g_last_error = MMAP_VECTOR_IO_ERROR;
+          return false;
+        }
+    }
+  else if (size < HEADER_SIZE)
+    {
+      close (vec->fd);
+      g_last_error = MMAP_VECTOR_CORRUPT;
+      return false;
+    }
+
+  void *map = os_map (vec->fd, size, writable);
+  if (map == NULL)
+    {
+      close (vec->fd);
+      g_last_error = MMAP_VECTOR_IO_ERROR;
+      return false;
+    }
+  set_mapping (vec, map, size);
+
+  if (fresh)
+    {
+      *vec->header = (mmap_vector_header_t){
+        .magic = MMAP_VECTOR_MAGIC,
+        .version = MMAP_VECTOR_VERSION,
+        .elem_len = elem_len,
+        .capacity = CUTILS_VECTOR_INIT_CAPACITY,
+        .checksum = checksum (vec->data, 0),
+      };
+    }
+
+  return true;
+}
+#else
+static bool
+os_resize ([[maybe_unused]] mmap_vector_t *vec,
+           [[maybe_unused]] size_t new_size)
+{
+  return false;
+}
+
+static bool
+os_flush ([[maybe_unused]] mmap_vector_t *vec)
+{
+  return false;
+}
+
+static void
+os_close ([[maybe_unused]] mmap_vector_t *vec)
+{
+}
+
+static bool
+os_open ([[maybe_unused]] mmap_vector_t *vec,
+         [[maybe_unused]] const char *path, [[maybe_unused]] size_t elem_len)
+{
+  g_last_error = MMAP_VECTOR_UNSUPPORTED;
+  return false;
+}
+#endif
+
+/* Checks that the mapped header describes a file of this size */
+static bool
+header_valid (const mmap_vector_t *vec)
+{
+  const mmap_vector_header_t *h = vec->header;
+
+  if (h->magic != MMAP_VECTOR_MAGIC || h->version != MMAP_VECTOR_VERSION
+      || h->elem_len == 0 || h->len > h->capacity)
+    {
+      return false;
+    }
+
+  size_t room = (vec->map_size - HEADER_SIZE) / h->elem_len;
+  return h->capacity <= room;
+}
+
+static bool
+grow (mmap_vector_t *vec, size_t capacity)
+{
+  if ((SIZE_MAX - HEADER_SIZE) / vec->elem_len < capacity)
+    {
+      g_last_error = MMAP_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  size_t size = HEADER_SIZE + (capacity * vec->elem_len);
+  if (size > vec->map_size && !os_resize (vec, size))
+    {
+      g_last_error = MMAP_VECTOR_IO_ERROR;
+      return false;
+    }
+
+  vec->header->capacity = capacity;
+  vec->header->dirty = 1;
+  return true;
+}
+
+mmap_vector_t *
+mmap_vector_open_with_allocator (const char *path, size_t elem_len,
+                                 uint32_t flags, cutils_allocator_t *allocator)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (path == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return NULL;
+    }
+
+  if (allocator == NULL)
+    {
+      g_last_error = MMAP_VECTOR_INVALID_ARG;
+      return NULL;
+    }
+
+  mmap_vector_t *vec = cutils_allocate_aligned (
+      allocator, sizeof (mmap_vector_t), CUTILS_ALIGNMENT);
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NO_MEMORY;
+      return NULL;
+    }
+
+  vec->flags = flags;
+  vec->allocator = allocator;
+
+  if (!os_open (vec, path, elem_len))
+    {
+      cutils_deallocate (allocator, vec);
+      return NULL;
+    }
+
+  mmap_vector_result_t error = MMAP_VECTOR_OK;
+  if (!header_valid (vec))
+    {
+      error = MMAP_VECTOR_CORRUPT;
+    }
+  else if (elem_len != 0 && elem_len != vec->header->elem_len)
+    {
+      error = MMAP_VECTOR_INVALID_ARG;
+    }
+  else
+    {
+      vec->elem_len = (size_t)vec->header->elem_len;
+      if ((flags & MMAP_VECTOR_VERIFY) != 0 && !mmap_vector_verify (vec))
+        {
+          error = MMAP_VECTOR_CORRUPT;
+        }
+    }
+
+  if (error != MMAP_VECTOR_OK)
+    {
+      os_close (vec);
+      cutils_deallocate (allocator, vec);
+      g_last_error = error;
+      return NULL;
+    }
+
+  return vec;
+}
+
+mmap_vector_t *
+mmap_vector_open (const char *path, size_t elem_len, uint32_t flags)
+{
+  return mmap_vector_open_with_allocator (path, elem_len, flags,
+                                          cutils_get_default_allocator ());
+}
+
+bool
+mmap_vector_close (mmap_vector_t *vec)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  bool synced = (vec->flags & MMAP_VECTOR_READ_ONLY) != 0
+                || mmap_vector_sync (vec);
+
+  os_close (vec);
+  cutils_deallocate (vec->allocator, vec);
+
+  return synced;
+}
+
+bool
+mmap_vector_sync (mmap_vector_t *vec)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!is_writable (vec))
+    {
+      return false;
+    }
+
+  vec->header->checksum = data_checksum (vec);
+  vec->header->dirty = 0;
+
+  if (!os_flush (vec))
+    {
+      g_last_error = MMAP_VECTOR_IO_ERROR;
+      return false;
+    }
+
+  return true;
+}
+
+bool
+mmap_vector_verify (const mmap_vector_t *vec)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (vec->header->dirty != 0
+      || vec->header->checksum != data_checksum (vec))
+    {
+      g_last_error = MMAP_VECTOR_CORRUPT;
+      return false;
+    }
+
+  return true;
+}
+
+bool
+mmap_vector_push_timeout (mmap_vector_t *vec, const void *elem,
+                          uint32_t timeout_ms)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL || elem == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!is_writable (vec))
+    {
+      return false;
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+  mmap_vector_header_t *h = vec->header;
+
+  if (h->len >= h->capacity)
+    {
+      if (!check_timeout ((uint32_t)start_time, timeout_ms))
+        {
+          g_last_error = MMAP_VECTOR_TIMEOUT;
+          return false;
+        }
+
+      size_t capacity
+          = h->capacity == 0
+                ? CUTILS_VECTOR_INIT_CAPACITY
+                : (size_t)h->capacity * CUTILS_VECTOR_GROWTH_FACTOR;
+      if (capacity <= h->capacity)
+        {
+          g_last_error = MMAP_VECTOR_OVERFLOW;
+          return false;
+        }
+
+      if (!grow (vec, capacity))
+        {
+          return false;
+        }
+      h = vec->header;
+    }
+
+  memcpy ((char *)vec->data + ((size_t)h->len * vec->elem_len), elem,
+          vec->elem_len);
+  h->len++;
+  h->dirty = 1;
+
+  return true;
+}
+
+bool
+mmap_vector_push (mmap_vector_t *vec, const void *elem)
+{
+  return mmap_vector_push_timeout (vec, elem, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+mmap_vector_pop (mmap_vector_t *vec, void *out)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!is_writable (vec))
+    {
+      return false;
+    }
+
+  if (vec->header->len == 0)
+    {
+      g_last_error = MMAP_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  vec->header->len--;
+  vec->header->dirty = 1;
+  if (out != NULL)
+    {
+      memcpy (out,
+              (char *)vec->data + ((size_t)vec->header->len * vec->elem_len),
+              vec->elem_len);
+    }
+
+  return true;
+}
+
+bool
+mmap_vector_get (const mmap_vector_t *vec, size_t index, void *out)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL || out == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= vec->header->len)
+    {
+      g_last_error = MMAP_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  memcpy (out, (const char *)vec->data + (index * vec->elem_len),
+          vec->elem_len);
+  return true;
+}
+
+bool
+mmap_vector_set (mmap_vector_t *vec, size_t index, const void *elem)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL || elem == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!is_writable (vec))
+    {
+      return false;
+    }
+
+  if (index >= vec->header->len)
+    {
+      g_last_error = MMAP_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  memcpy ((char *)vec->data + (index * vec->elem_len), elem, vec->elem_len);
+  vec->header->dirty = 1;
+  return true;
+}
+
+const void *
+mmap_vector_data (const mmap_vector_t *vec)
+{
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return NULL;
+    }
+  return vec->data;
+}
+
+bool
+mmap_vector_view (const mmap_vector_t *vec, vector_t *out)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL || out == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  out->data = vec->data;
+  out->len = (size_t)vec->header->len;
+  out->capacity = (size_t)vec->header->len;
+  out->elem_len = vec->elem_len;
+  out->allocator = NULL;
+
+  return true;
+}
+
+bool
+mmap_vector_reserve (mmap_vector_t *vec, size_t capacity)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!is_writable (vec))
+    {
+      return false;
+    }
+
+  if (capacity <= vec->header->capacity)
+    {
+      return true;
+    }
+
+  return grow (vec, capacity);
+}
+
+bool
+mmap_vector_clear (mmap_vector_t *vec)
+{
+  g_last_error = MMAP_VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!is_writable (vec))
+    {
+      return false;
+    }
+
+  vec->header->len = 0;
+  vec->header->dirty = 1;
+  return true;
+}
+
+size_t
+mmap_vector_length (const mmap_vector_t *vec)
+{
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return (size_t)vec->header->len;
+}
+
+size_t
+mmap_vector_capacity (const mmap_vector_t *vec)
+{
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return (size_t)vec->header->capacity;
+}
+
+size_t
+mmap_vector_element_size (const mmap_vector_t *vec)
+{
+  if (vec == NULL)
+    {
+      g_last_error = MMAP_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return vec->elem_len;
+}
+
+mmap_vector_result_t
+mmap_vector_get_error (void)
+{
+  return g_last_error;
+}
@@ -0,0 +1,191 @@
+#include "cutils/mpsc_queue.h"
+#include "cutils/config.h"
+#include <stdatomic.h>
+#include <threads.h>
+
+static thread_local mpsc_queue_result_t g_last_error = MPSC_QUEUE_OK;
+
+static inline void
+push_node (mpsc_queue_t *queue, mpsc_queue_node_t *node)
+{
+  atomic_store_explicit (&node->next, NULL, memory_order_relaxed);
+  mpsc_queue_node_t *prev
+      = atomic_exchange_explicit (&queue->head, node, memory_order_acq_rel);
+  atomic_store_explicit (&prev->next, node, memory_order_release);
+}
+
+/*
+ * Pops one node. The stub is skipped when it is at the tail and pushed back
+ * when the last real node is taken, so the tail never runs dry.
+ */
+static mpsc_queue_node_t *
+pop_node (mpsc_queue_t *queue)
+{
+  mpsc_queue_node_t *tail = queue->tail;
+  mpsc_queue_node_t *next
+      = atomic_load_explicit (&tail->next, memory_order_acquire);
+
+  if (tail == &queue->stub)
+    {
+      if (next == NULL)
+        {
+          bool pending = atomic_load_explicit (&queue->head,
+                                               memory_order_acquire)
+                         != tail;
+          g_last_error = pending ? MPSC_QUEUE_RETRY : MPSC_QUEUE_EMPTY;
+          return NULL;
+        }
+      queue->tail = next;
+      tail = next;
+      next = atomic_load_explicit (&tail->next, memory_order_acquire);
+    }
+
+  if (next != NULL)
+    {
+      queue->tail = next;
+      return tail;
+    }
+
+  if (atomic_load_explicit (&queue->head, memory_order_acquire) != tail)
+    {
+      g_last_error = MPSC_QUEUE_RETRY;
+      return NULL;
+    }
+
+  push_node (queue, &queue->stub);
+
+  next = atomic_load_explicit (&tail->next, memory_order_acquire);
+  if (next != NULL)
+    {
+      queue->tail = next;
+      return tail;
+    }
+
+  g_last_error = MPSC_QUEUE_RETRY;
+  return NULL;
+}
+
+void
+mpsc_queue_init (mpsc_queue_t *queue)
+{
+  g_last_error = MPSC_QUEUE_OK;
+
+  if (queue == NULL)
+    {
+      g_last_error = MPSC_QUEUE_NULL_PTR;
+      return;
+    }
+
+  atomic_init (&queue->stub.next, NULL);
+  atomic_init (&queue->head, &queue->stub);
+  queue->tail = &queue->stub;
+}
+
+bool
+mpsc_queue_push (mpsc_queue_t *queue, mpsc_queue_node_t *node)
+{
+  g_last_error = MPSC_QUEUE_OK;
+
+  if (queue == NULL || node == NULL)
+    {
+      g_last_error = MPSC_QUEUE_NULL_PTR;
+      return false;
+    }
+
+  push_node (queue, node);
+  return true;
+}
+
+mpsc_queue_node_t *
+mpsc_queue_pop (mpsc_queue_t *queue)
+{
+  g_last_error = MPSC_QUEUE_OK;
+
+  if (queue == NULL)
+    {
+      g_last_error = MPSC_QUEUE_NULL_PTR;
+      return NULL;
+    }
+
+  return pop_node (queue);
+}
+
+mpsc_queue_node_t *
+mpsc_queue_pop_all (mpsc_queue_t *queue, size_t *count)
+{
+  g_last_error = MPSC_QUEUE_OK;
+
+  if (count != NULL)
+    {
+      *count = 0;
+    }
+
+  if (queue == NULL)
+    {
+      g_last_error = MPSC_QUEUE_NULL_PTR;
+      return NULL;
+    }
+
+  mpsc_queue_node_t *first = pop_node (queue);
+  if (first == NULL)
+    {
+      return NULL;
+    }
+
+  mpsc_queue_node_t *last = first;
+  size_t popped = 1;
+
+  mpsc_queue_node_t *node;
+  while ((node = pop_node (queue)) != NULL)
+    {
+      atomic_store_explicit (&last->next, node, memory_order_relaxed);
+      last = node;
+      popped++;
+    }
+  atomic_store_explicit (&last->next, NULL, memory_order_relaxed);
+
+  // Running out after popping something is success unless a push stalled
+  if (g_last_error == MPSC_QUEUE_EMPTY)
+    {
+      g_last_error = MPSC_QUEUE_OK;
+    }
+
+  if (count != NULL)
+    {
+      *count = popped;
+    }
+
+  return first;
+}
+
+mpsc_queue_node_t *
+mpsc_queue_next (const mpsc_queue_node_t *node)
+{
+  if (node == NULL)
+    {
+      return NULL;
+    }
+
+  return atomic_load_explicit (&node->next, memory_order_relaxed);
+}
+
+bool
+mpsc_queue_is_empty (mpsc_queue_t *queue)
+{
+  if (queue == NULL)
+    {
+      g_last_error = MPSC_QUEUE_NULL_PTR;
+      return true;
+    }
+
+  mpsc_queue_node_t *tail = queue->tail;
+  return tail == &queue->stub
+         && atomic_load_explicit (&tail->next, memory_order_acquire) == NULL
+         && atomic_load_explicit (&queue->head, memory_order_acquire) == tail;
+}
+
+mpsc_queue_result_t
+mpsc_queue_get_error (void)
+{
+  return g_last_error;
+}
@@ -62,9 +62,8 @@ queue_create_with_allocator (size_t elem_size, size_t initial_capacity,
 queue_t *
 queue_create (size_t elem_size, size_t initial_capacity)
 {
-  cutils_allocator_t default_allocator = cutils_create_default_allocator ();
   return queue_create_with_allocator (elem_size, initial_capacity,
-                                      &default_allocator);
+                                      cutils_get_default_allocator ());
 }
 
 void
@@ -82,6 +81,113 @@ queue_destroy (queue_t *queue)
   cutils_deallocate (queue->allocator, queue);
 }
 
+/*
+ * Copies the queued elements of src, oldest first, to the start of a flat
+ * buffer.
+ */
+static void
+copy_linear (void *dst, const queue_t *src)
+{
+  size_t first_part = src->capacity - src->head;
+  if (first_part > src->size)
+    {
+      first_part = src->size;
+    }
+
+  memcpy (dst, (char *)src->data + (src->head * src->elem_size),
+          first_part * src->elem_size);
+  memcpy ((char *)dst + (first_part * src->elem_size), src->data,
+          (src->size - first_part) * src->elem_size);
+}
+
+bool
+queue_copy_into (queue_t *dst, const queue_t *src)
+{
+  g_last_error = QUEUE_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = QUEUE_NULL_PTR;
+      return false;
+    }
+
+  if (dst->elem_size != src->elem_size)
+    {
+      g_last_error = QUEUE_INVALID_ARG;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  if (dst->capacity < src->size)
+    {
+      void *new_data = cutils_allocate_aligned (
+          dst->allocator, src->size * dst->elem_size, CUTILS_ALIGNMENT);
+      if (new_data == NULL)
+        {
+          g_last_error = QUEUE_NO_MEMORY;
+          return false;
+        }
+
+      cutils_deallocate (dst->allocator, dst->data);
+      dst->data = new_data;
+      dst->capacity = src->size;
+    }
+
+  if (src->size > 0)
+    {
+      copy_linear (dst->data, src);
+    }
+
+  dst->size = src->size;
+  dst->head = 0;
+  dst->tail = dst->size < dst->capacity ? dst->size : 0;
+
+  return true;
+}
+
+bool
+queue_move (queue_t *dst, queue_t *src)
+{
+  g_last_error = QUEUE_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = QUEUE_NULL_PTR;
+      return false;
+    }
+
+  if (dst->elem_size != src->elem_size
+      || !cutils_allocator_equal (dst->allocator, src->allocator))
+    {
+      g_last_error = QUEUE_INVALID_ARG;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  cutils_deallocate (dst->allocator, dst->data);
+  dst->data = src->data;
+  dst->size = src->size;
+  dst->capacity = src->capacity;
+  dst->head = src->head;
+  dst->tail = src->tail;
+
+  src->data = NULL;
+  src->size = 0;
+  src->capacity = 0;
+  src->head = 0;
+  src->tail = 0;
+
+  return true;
+}
+
 static bool
 resize_if_needed (queue_t *queue, uint32_t timeout_ms)
 {
@@ -91,7 +197,7 @@ resize_if_needed (queue_t *queue, uint32_t timeout_ms)
     }
 
   uint64_t start_time = cutils_get_current_time_ms ();
-  size_t new_capacity = queue->capacity * 2;
+  size_t new_capacity = queue->capacity > 0 ? queue->capacity * 2 : 1;
 
   if (!queue_can_perform_operation (queue, new_capacity * queue->elem_size))
     {
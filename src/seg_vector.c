@@ -0,0 +1,423 @@
+#include "cutils/seg_vector.h"
+#include "cutils/config.h"
+#include "cutils/time.h"
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#define SEG_BASE ((size_t)1 << CUTILS_SEG_VECTOR_BASE_SHIFT)
+
+static thread_local seg_vector_result_t g_last_error = SEG_VECTOR_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+static inline size_t
+chunk_elems (size_t chunk)
+{
+  return SEG_BASE << chunk;
+}
+
+/*
+ * Chunk k starts at global index SEG_BASE * (2^k - 1), so after biasing
+ * the index by SEG_BASE the chunk is given by the position of the top bit.
+ */
+static inline size_t
+locate (size_t index, size_t *offset)
+{
+  size_t biased = index + SEG_BASE;
+  size_t top = (sizeof (unsigned long long) * 8) - 1
+               - (size_t)__builtin_clzll ((unsigned long long)biased);
+  size_t chunk = top - CUTILS_SEG_VECTOR_BASE_SHIFT;
+
+  *offset = biased - ((size_t)1 << top);
+  return chunk;
+}
+
+static inline char *
+elem_ptr (const seg_vector_t *seg, size_t index)
+{
+  size_t offset;
+  size_t chunk = locate (index, &offset);
+  return (char *)seg->chunks[chunk] + (offset * seg->elem_len);
+}
+
+static bool
+add_chunk (seg_vector_t *seg)
+{
+  size_t chunk = seg->chunk_count;
+  if (chunk >= CUTILS_SEG_VECTOR_MAX_CHUNKS
+      || chunk >= (sizeof (size_t) * 8) - CUTILS_SEG_VECTOR_BASE_SHIFT)
+    {
+      g_last_error = SEG_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  size_t elems = chunk_elems (chunk);
+  if (SIZE_MAX / seg->elem_len < elems
+      || SIZE_MAX - seg->capacity - SEG_BASE < elems)
+    {
+      g_last_error = SEG_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  void *data = cutils_allocate_aligned (seg->allocator, elems * seg->elem_len,
+                                        CUTILS_ALIGNMENT);
+  if (data == NULL)
+    {
+      g_last_error = SEG_VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  seg->chunks[chunk] = data;
+  seg->chunk_count++;
+  seg->capacity += elems;
+
+  return true;
+}
+
+seg_vector_t *
+seg_vector_create_with_allocator (size_t elem_len,
+                                  cutils_allocator_t *allocator)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (elem_len == 0 || allocator == NULL)
+    {
+      g_last_error = SEG_VECTOR_INVALID_ARG;
+      return NULL;
+    }
+
+  seg_vector_t *seg = cutils_allocate_aligned (
+      allocator, sizeof (seg_vector_t), CUTILS_ALIGNMENT);
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NO_MEMORY;
+      return NULL;
+    }
+
+  for (size_t i = 0; i < CUTILS_SEG_VECTOR_MAX_CHUNKS; i++)
+    {
+      seg->chunks[i] = NULL;
+    }
+  seg->chunk_count = 0;
+  seg->len = 0;
+  seg->capacity = 0;
+  seg->elem_len = elem_len;
+  seg->allocator = allocator;
+
+  return seg;
+}
+
+seg_vector_t *
+seg_vector_create (size_t elem_len)
+{
+  return seg_vector_create_with_allocator (elem_len,
+                                           cutils_get_default_allocator ());
+}
+
+void
+seg_vector_destroy (seg_vector_t *seg)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return;
+    }
+
+  for (size_t i = 0; i < seg->chunk_count; i++)
+    {
+      cutils_deallocate (seg->allocator, seg->chunks[i]);
+    }
+  cutils_deallocate (seg->allocator, seg);
+}
+
+bool
+seg_vector_push_timeout (seg_vector_t *seg, const void *elem,
+                         uint32_t timeout_ms)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL || elem == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  if (seg->len >= seg->capacity)
+    {
+      if (!check_timeout ((uint32_t)start_time, timeout_ms))
+        {
+          g_last_error = SEG_VECTOR_TIMEOUT;
+          return false;
+        }
+
+      if (!add_chunk (seg))
+        {
+          return false;
+        }
+    }
+
+  memcpy (elem_ptr (seg, seg->len), elem, seg->elem_len);
+  seg->len++;
+
+  return true;
+}
+
+bool
+seg_vector_push (seg_vector_t *seg, const void *elem)
+{
+  return seg_vector_push_timeout (seg, elem, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+seg_vector_pop (seg_vector_t *seg, void *out)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (seg->len == 0)
+    {
+      g_last_error = SEG_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  seg->len--;
+  if (out != NULL)
+    {
+      memcpy (out, elem_ptr (seg, seg->len), seg->elem_len);
+    }
+
+  return true;
+}
+
+bool
+seg_vector_get (const seg_vector_t *seg, size_t index, void *out)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL || out == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= seg->len)
+    {
+      g_last_error = SEG_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  memcpy (out, elem_ptr (seg, index), seg->elem_len);
+  return true;
+}
+
+bool
+seg_vector_set (seg_vector_t *seg, size_t index, const void *elem)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL || elem == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= seg->len)
+    {
+      g_last_error = SEG_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  memcpy (elem_ptr (seg, index), elem, seg->elem_len);
+  return true;
+}
+
+void *
+seg_vector_at (const seg_vector_t *seg, size_t index)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return NULL;
+    }
+
+  if (index >= seg->len)
+    {
+      g_last_error = SEG_VECTOR_OUT_OF_RANGE;
+      return NULL;
+    }
+
+  return elem_ptr (seg, index);
+}
+
+bool
+seg_vector_reserve (seg_vector_t *seg, size_t capacity)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  while (seg->capacity < capacity)
+    {
+      if (!add_chunk (seg))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+bool
+seg_vector_shrink (seg_vector_t *seg)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  size_t used = seg_vector_chunk_count (seg);
+  while (seg->chunk_count > used)
+    {
+      seg->chunk_count--;
+      cutils_deallocate (seg->allocator, seg->chunks[seg->chunk_count]);
+      seg->chunks[seg->chunk_count] = NULL;
+      seg->capacity -= chunk_elems (seg->chunk_count);
+    }
+
+  return true;
+}
+
+bool
+seg_vector_clear (seg_vector_t *seg)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  seg->len = 0;
+  return true;
+}
+
+size_t
+seg_vector_chunk_count (const seg_vector_t *seg)
+{
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  if (seg->len == 0)
+    {
+      return 0;
+    }
+
+  size_t offset;
+  return locate (seg->len - 1, &offset) + 1;
+}
+
+seg_vector_span_t
+seg_vector_chunk (const seg_vector_t *seg, size_t chunk)
+{
+  g_last_error = SEG_VECTOR_OK;
+
+  seg_vector_span_t span = { NULL, 0, 0, 0 };
+
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return span;
+    }
+
+  if (chunk >= seg_vector_chunk_count (seg))
+    {
+      g_last_error = SEG_VECTOR_OUT_OF_RANGE;
+      return span;
+    }
+
+  size_t first = chunk_elems (chunk) - SEG_BASE;
+  size_t len = seg->len - first;
+  if (len > chunk_elems (chunk))
+    {
+      len = chunk_elems (chunk);
+    }
+
+  span.data = seg->chunks[chunk];
+  span.len = len;
+  span.elem_len = seg->elem_len;
+  span.first_index = first;
+  return span;
+}
+
+size_t
+seg_vector_length (const seg_vector_t *seg)
+{
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return seg->len;
+}
+
+size_t
+seg_vector_capacity (const seg_vector_t *seg)
+{
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return seg->capacity;
+}
+
+size_t
+seg_vector_memory_usage (const seg_vector_t *seg)
+{
+  if (seg == NULL)
+    {
+      g_last_error = SEG_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return sizeof (seg_vector_t) + (seg->capacity * seg->elem_len);
+}
+
+seg_vector_result_t
+seg_vector_get_error (void)
+{
+  return g_last_error;
+}
@@ -0,0 +1,720 @@
+#include "cutils/soa_vector.h"
+#include "cutils/config.h"
+#include "cutils/time.h"
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+static thread_local soa_vector_result_t g_last_error = SOA_VECTOR_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+// Bytes taken by one column of the given capacity, padded to the alignment
+static bool
+column_bytes (size_t capacity, size_t elem_len, size_t *out)
+{
+  if (SIZE_MAX / elem_len < capacity)
+    {
+      return false;
+    }
+
+  size_t bytes = capacity * elem_len;
+  if (bytes > SIZE_MAX - (CUTILS_SOA_COLUMN_ALIGNMENT - 1))
+    {
+      return false;
+    }
+
+  *out = (bytes + (CUTILS_SOA_COLUMN_ALIGNMENT - 1))
+         & ~(size_t)(CUTILS_SOA_COLUMN_ALIGNMENT - 1);
+  return true;
+}
+
+static bool
+block_bytes (const soa_vector_t *soa, size_t capacity, size_t *out)
+{
+  size_t total = 0;
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      size_t bytes;
+      if (!column_bytes (capacity, soa->column_sizes[c], &bytes)
+          || SIZE_MAX - total < bytes)
+        {
+          return false;
+        }
+      total += bytes;
+    }
+
+  *out = total;
+  return true;
+}
+
+// Lays the columns out back to back in block, sizes were checked already
+static void
+assign_columns (const soa_vector_t *soa, char *block, size_t capacity,
+                void **columns)
+{
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      size_t bytes = 0;
+      column_bytes (capacity, soa->column_sizes[c], &bytes);
+      columns[c] = block;
+      block += bytes;
+    }
+}
+
+static bool
+reallocate (soa_vector_t *soa, size_t capacity)
+{
+  size_t total;
+  if (!block_bytes (soa, capacity, &total))
+    {
+      g_last_error = SOA_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  char *block = cutils_allocate_aligned (soa->allocator, total,
+                                         CUTILS_SOA_COLUMN_ALIGNMENT);
+  if (block == NULL)
+    {
+      g_last_error = SOA_VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  void *columns[CUTILS_SOA_MAX_COLUMNS];
+  assign_columns (soa, block, capacity, columns);
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      if (soa->len > 0)
+        {
+          memcpy (columns[c], soa->columns[c],
+                  soa->len * soa->column_sizes[c]);
+        }
+      soa->columns[c] = columns[c];
+    }
+
+  cutils_deallocate (soa->allocator, soa->data);
+  soa->data = block;
+  soa->capacity = capacity;
+
+  return true;
+}
+
+soa_vector_t *
+soa_vector_create_with_allocator (const size_t *column_sizes,
+                                  size_t column_count, size_t init_capacity,
+                                  cutils_allocator_t *allocator)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (column_sizes == NULL || allocator == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return NULL;
+    }
+
+  if (column_count == 0 || column_count > CUTILS_SOA_MAX_COLUMNS)
+    {
+      g_last_error = SOA_VECTOR_INVALID_ARG;
+      return NULL;
+    }
+
+  for (size_t c = 0; c < column_count; c++)
+    {
+      if (column_sizes[c] == 0)
+        {
+          g_last_error = SOA_VECTOR_INVALID_ARG;
+          return NULL;
+        }
+    }
+
+  if (init_capacity == 0)
+    {
+      init_capacity = CUTILS_VECTOR_INIT_CAPACITY;
+    }
+
+  soa_vector_t *soa = cutils_allocate_aligned (
+      allocator, sizeof (soa_vector_t), CUTILS_ALIGNMENT);
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NO_MEMORY;
+      return NULL;
+    }
+
+  soa->data = NULL;
+  soa->column_count = column_count;
+  soa->len = 0;
+  soa->capacity = 0;
+  soa->allocator = allocator;
+  for (size_t c = 0; c < column_count; c++)
+    {
+      soa->column_sizes[c] = column_sizes[c];
+      soa->columns[c] = NULL;
+    }
+
+  if (!reallocate (soa, init_capacity))
+    {
+      cutils_deallocate (allocator, soa);
+      return NULL;
+    }
+
+  return soa;
+}
+
+soa_vector_t *
+soa_vector_create (const size_t *column_sizes, size_t column_count,
+                   size_t init_capacity)
+{
+  return soa_vector_create_with_allocator (column_sizes, column_count,
+                                           init_capacity,
+                                           cutils_get_default_allocator ());
+}
+
+void
+soa_vector_destroy (soa_vector_t *soa)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return;
+    }
+
+  cutils_deallocate (soa->allocator, soa->data);
+  cutils_deallocate (soa->allocator, soa);
+}
+
+bool
+soa_vector_push_timeout (soa_vector_t *soa, const void *const *fields,
+                         uint32_t timeout_ms)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || fields == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      if (fields[c] == NULL)
+        {
+          g_last_error = SOA_VECTOR_NULL_PTR;
+          return false;
+        }
+    }
+
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  if (soa->len >= soa->capacity)
+    {
+      if (soa->capacity > SIZE_MAX / CUTILS_VECTOR_GROWTH_FACTOR)
+        {
+          g_last_error = SOA_VECTOR_OVERFLOW;
+          return false;
+        }
+
+      if (!check_timeout ((uint32_t)start_time, timeout_ms))
+        {
+          g_last_error = SOA_VECTOR_TIMEOUT;
+          return false;
+        }
+
+      if (!reallocate (soa, soa->capacity * CUTILS_VECTOR_GROWTH_FACTOR))
+        {
+          return false;
+        }
+    }
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      size_t elem_len = soa->column_sizes[c];
+      memcpy ((char *)soa->columns[c] + (soa->len * elem_len), fields[c],
+              elem_len);
+    }
+  soa->len++;
+
+  return true;
+}
+
+bool
+soa_vector_push (soa_vector_t *soa, const void *const *fields)
+{
+  return soa_vector_push_timeout (soa, fields, CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+soa_vector_pop (soa_vector_t *soa, void *const *out)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (soa->len == 0)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  soa->len--;
+
+  if (out != NULL)
+    {
+      for (size_t c = 0; c < soa->column_count; c++)
+        {
+          if (out[c] != NULL)
+            {
+              size_t elem_len = soa->column_sizes[c];
+              memcpy (out[c], (char *)soa->columns[c] + (soa->len * elem_len),
+                      elem_len);
+            }
+        }
+    }
+
+  return true;
+}
+
+bool
+soa_vector_get (const soa_vector_t *soa, size_t index, void *const *out)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || out == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= soa->len)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      if (out[c] != NULL)
+        {
+          size_t elem_len = soa->column_sizes[c];
+          memcpy (out[c], (const char *)soa->columns[c] + (index * elem_len),
+                  elem_len);
+        }
+    }
+
+  return true;
+}
+
+bool
+soa_vector_set (soa_vector_t *soa, size_t index, const void *const *fields)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || fields == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= soa->len)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      if (fields[c] == NULL)
+        {
+          g_last_error = SOA_VECTOR_NULL_PTR;
+          return false;
+        }
+    }
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      size_t elem_len = soa->column_sizes[c];
+      memcpy ((char *)soa->columns[c] + (index * elem_len), fields[c],
+              elem_len);
+    }
+
+  return true;
+}
+
+bool
+soa_vector_get_field (const soa_vector_t *soa, size_t index, size_t column,
+                      void *out)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || out == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= soa->len || column >= soa->column_count)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  size_t elem_len = soa->column_sizes[column];
+  memcpy (out, (const char *)soa->columns[column] + (index * elem_len),
+          elem_len);
+  return true;
+}
+
+bool
+soa_vector_set_field (soa_vector_t *soa, size_t index, size_t column,
+                      const void *value)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || value == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (index >= soa->len || column >= soa->column_count)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  size_t elem_len = soa->column_sizes[column];
+  memcpy ((char *)soa->columns[column] + (index * elem_len), value, elem_len);
+  return true;
+}
+
+soa_vector_span_t
+soa_vector_column (const soa_vector_t *soa, size_t column)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  soa_vector_span_t span = { NULL, 0, 0 };
+
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return span;
+    }
+
+  if (column >= soa->column_count)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return span;
+    }
+
+  span.data = soa->columns[column];
+  span.len = soa->len;
+  span.elem_len = soa->column_sizes[column];
+  return span;
+}
+
+bool
+soa_vector_reserve (soa_vector_t *soa, size_t capacity)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (capacity <= soa->capacity)
+    {
+      return true;
+    }
+
+  return reallocate (soa, capacity);
+}
+
+bool
+soa_vector_permute (soa_vector_t *soa, const size_t *perm)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || perm == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  for (size_t i = 0; i < soa->len; i++)
+    {
+      if (perm[i] >= soa->len)
+        {
+          g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+          return false;
+        }
+    }
+
+  size_t total;
+  if (!block_bytes (soa, soa->capacity, &total))
+    {
+      g_last_error = SOA_VECTOR_OVERFLOW;
+      return false;
+    }
+
+  // Gather into a fresh block, each column is read and written once
+  char *block = cutils_allocate_aligned (soa->allocator, total,
+                                         CUTILS_SOA_COLUMN_ALIGNMENT);
+  if (block == NULL)
+    {
+      g_last_error = SOA_VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  void *columns[CUTILS_SOA_MAX_COLUMNS];
+  assign_columns (soa, block, soa->capacity, columns);
+
+  for (size_t c = 0; c < soa->column_count; c++)
+    {
+      size_t elem_len = soa->column_sizes[c];
+      const char *src = soa->columns[c];
+      char *dst = columns[c];
+
+      for (size_t i = 0; i < soa->len; i++)
+        {
+          memcpy (dst + (i * elem_len), src + (perm[i] * elem_len), elem_len);
+        }
+      soa->columns[c] = dst;
+    }
+
+  cutils_deallocate (soa->allocator, soa->data);
+  soa->data = block;
+
+  return true;
+}
+
+/*
+ * Sorting works on a temporary vector of (key, index) records so the key
+ * column can be sorted with the vector sorts, then applies the resulting
+ * permutation to every column.
+ */
+static char *
+build_sort_records (const soa_vector_t *soa, size_t column,
+                    size_t *out_record_len)
+{
+  size_t elem_len = soa->column_sizes[column];
+  size_t index_offset
+      = (elem_len + sizeof (size_t) - 1) & ~(sizeof (size_t) - 1);
+  size_t record_len = index_offset + sizeof (size_t);
+
+  if (SIZE_MAX / record_len < soa->len)
+    {
+      g_last_error = SOA_VECTOR_OVERFLOW;
+      return NULL;
+    }
+
+  char *records = cutils_allocate_aligned (
+      soa->allocator, soa->len * record_len, CUTILS_ALIGNMENT);
+  if (records == NULL)
+    {
+      g_last_error = SOA_VECTOR_NO_MEMORY;
+      return NULL;
+    }
+
+  const char *keys = soa->columns[column];
+  for (size_t i = 0; i < soa->len; i++)
+    {
+      char *record = records + (i * record_len);
+      memcpy (record, keys + (i * elem_len), elem_len);
+      memcpy (record + index_offset, &i, sizeof (i));
+    }
+
+  *out_record_len = record_len;
+  return records;
+}
+
+static bool
+apply_sort_records (soa_vector_t *soa, char *records, size_t record_len)
+{
+  size_t index_offset = record_len - sizeof (size_t);
+
+  // Compact the indices in place; slot i never overlaps a later record
+  for (size_t i = 0; i < soa->len; i++)
+    {
+      size_t index;
+      memcpy (&index, records + (i * record_len) + index_offset,
+              sizeof (index));
+      memcpy (records + (i * sizeof (size_t)), &index, sizeof (index));
+    }
+
+  bool ok = soa_vector_permute (soa, (const size_t *)(void *)records);
+  cutils_deallocate (soa->allocator, records);
+  return ok;
+}
+
+bool
+soa_vector_sort_by_column (soa_vector_t *soa, size_t column,
+                           int (*compare) (const void *a, const void *b))
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL || compare == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (column >= soa->column_count)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  if (soa->len < 2)
+    {
+      return true;
+    }
+
+  size_t record_len;
+  char *records = build_sort_records (soa, column, &record_len);
+  if (records == NULL)
+    {
+      return false;
+    }
+
+  // The key leads each record, so compare applies to records unchanged
+  vector_t view = { records, soa->len, soa->len, record_len, soa->allocator };
+  vector_sort (&view, compare);
+
+  return apply_sort_records (soa, records, record_len);
+}
+
+bool
+soa_vector_sort_by_key (soa_vector_t *soa, size_t column,
+                        vector_key_type_t key_type)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (column >= soa->column_count)
+    {
+      g_last_error = SOA_VECTOR_OUT_OF_RANGE;
+      return false;
+    }
+
+  size_t key_len = key_type <= VECTOR_KEY_F32 ? sizeof (uint32_t)
+                                              : sizeof (uint64_t);
+  if (key_type > VECTOR_KEY_F64 || soa->column_sizes[column] != key_len)
+    {
+      g_last_error = SOA_VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  if (soa->len < 2)
+    {
+      return true;
+    }
+
+  size_t record_len;
+  char *records = build_sort_records (soa, column, &record_len);
+  if (records == NULL)
+    {
+      return false;
+    }
+
+  vector_t view = { records, soa->len, soa->len, record_len, soa->allocator };
+  if (!vector_radix_sort (&view, key_type, 0))
+    {
+      // Not enough scratch for the radix passes, sort in place instead
+      vector_sort_by_key (&view, key_type, 0);
+    }
+
+  return apply_sort_records (soa, records, record_len);
+}
+
+bool
+soa_vector_clear (soa_vector_t *soa)
+{
+  g_last_error = SOA_VECTOR_OK;
+
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return false;
+    }
+
+  soa->len = 0;
+  return true;
+}
+
+size_t
+soa_vector_length (const soa_vector_t *soa)
+{
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return soa->len;
+}
+
+size_t
+soa_vector_capacity (const soa_vector_t *soa)
+{
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return soa->capacity;
+}
+
+size_t
+soa_vector_column_count (const soa_vector_t *soa)
+{
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return 0;
+    }
+  return soa->column_count;
+}
+
+size_t
+soa_vector_memory_usage (const soa_vector_t *soa)
+{
+  if (soa == NULL)
+    {
+      g_last_error = SOA_VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  size_t total = 0;
+  block_bytes (soa, soa->capacity, &total);
+  return sizeof (soa_vector_t) + total;
+}
+
+soa_vector_result_t
+soa_vector_get_error (void)
+{
+  return g_last_error;
+}
@@ -41,7 +41,7 @@ resize_if_needed (string_t *str, size_t required_capacity, uint32_t timeout_ms)
       return false;
     }
 
-  size_t new_capacity = str->capacity;
+  size_t new_capacity = str->capacity > 0 ? str->capacity : 1;
   while (new_capacity < required_capacity)
     {
       if (new_capacity > SIZE_MAX / 2)
@@ -117,8 +117,8 @@ string_create_with_allocator (size_t initial_capacity,
 string_t *
 string_create (size_t initial_capacity)
 {
-  cutils_allocator_t default_allocator = cutils_create_default_allocator ();
-  return string_create_with_allocator (initial_capacity, &default_allocator);
+  return string_create_with_allocator (initial_capacity,
+                                       cutils_get_default_allocator ());
 }
 
 string_t *
@@ -149,8 +149,8 @@ string_from_cstr_with_allocator (const char *cstr,
 string_t *
 string_from_cstr (const char *cstr)
 {
-  cutils_allocator_t default_allocator = cutils_create_default_allocator ();
-  return string_from_cstr_with_allocator (cstr, &default_allocator);
+  return string_from_cstr_with_allocator (cstr,
+                                          cutils_get_default_allocator ());
 }
 
 void
@@ -171,6 +171,100 @@ string_destroy (string_t *str)
   cutils_deallocate (str->allocator, str);
 }
 
+bool
+string_copy_into (string_t *dst, const string_t *src)
+{
+  g_last_error = STRING_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = STRING_NULL_PTR;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  // dst's old contents are overwritten, so don't carry them across a resize;
+  // a failed resize leaves dst as it was
+  size_t old_length = dst->length;
+  dst->length = 0;
+  if (!resize_if_needed (dst, src->length + 1, UINT32_MAX))
+    {
+      dst->length = old_length;
+      return false;
+    }
+
+  if (src->length > 0)
+    {
+      memcpy (dst->data, src->data, src->length);
+    }
+  dst->data[src->length] = '\0';
+  dst->length = src->length;
+
+  return true;
+}
+
+bool
+string_move (string_t *dst, string_t *src)
+{
+  g_last_error = STRING_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = STRING_NULL_PTR;
+      return false;
+    }
+
+  if (!cutils_allocator_equal (dst->allocator, src->allocator))
+    {
+      g_last_error = STRING_INVALID_ARG;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  cutils_deallocate (dst->allocator, dst->data);
+  dst->data = src->data;
+  dst->length = src->length;
+  dst->capacity = src->capacity;
+
+  src->data = NULL;
+  src->length = 0;
+  src->capacity = 0;
+
+  return true;
+}
+
+char *
+string_take (string_t *str, size_t *out_length)
+{
+  g_last_error = STRING_OK;
+
+  if (str == NULL)
+    {
+      g_last_error = STRING_NULL_PTR;
+      return NULL;
+    }
+
+  char *data = str->data;
+  if (out_length != NULL)
+    {
+      *out_length = str->length;
+    }
+
+  str->data = NULL;
+  str->length = 0;
+  str->capacity = 0;
+
+  return data;
+}
+
 bool
 string_append_timeout (string_t *str, const char *cstr, uint32_t timeout_ms)
 {
@@ -0,0 +1,625 @@
+#include "cutils/unrolled_list.h"
+#include "cutils/config.h"
+#include "cutils/time.h"
+#include <string.h>
+#include <threads.h>
+
+#define MIN_NODE_ELEMS 4
+
+static thread_local unrolled_list_result_t g_last_error = UNROLLED_LIST_OK;
+
+static bool
+check_timeout ([[maybe_unused]] uint32_t start_time_ms,
+               [[maybe_unused]] uint32_t timeout_ms)
+{
+#if CUTILS_PLATFORM_BARE_METAL
+  // Implement platform-specific time check
+  return true;
+#else
+  uint32_t current_time = get_current_time_ms ();
+  return (current_time - start_time_ms) <= timeout_ms;
+#endif
+}
+
+static inline unsigned char *
+node_elem (const unrolled_list_t *list, unrolled_list_node_t *node,
+           size_t offset)
+{
+  return node->data + (offset * list->elem_len);
+}
+
+static inline size_t
+node_size (const unrolled_list_t *list)
+{
+  return sizeof (unrolled_list_node_t)
+         + (list->node_capacity * list->elem_len);
+}
+
+static unrolled_list_node_t *
+node_create (unrolled_list_t *list, uint32_t timeout_ms)
+{
+  uint64_t start_time = cutils_get_current_time_ms ();
+
+  unrolled_list_node_t *node = cutils_allocate_aligned (
+      list->allocator, node_size (list), alignof (unrolled_list_node_t));
+  if (node == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NO_MEMORY;
+      return NULL;
+    }
+
+  if (!check_timeout ((uint32_t)start_time, timeout_ms))
+    {
+      cutils_deallocate (list->allocator, node);
+      g_last_error = UNROLLED_LIST_TIMEOUT;
+      return NULL;
+    }
+
+  node->next = NULL;
+  node->prev = NULL;
+  node->count = 0;
+  return node;
+}
+
+/*
+ * Links node after pos, or at the head when pos is NULL.
+ */
+static void
+node_link_after (unrolled_list_t *list, unrolled_list_node_t *pos,
+                 unrolled_list_node_t *node)
+{
+  node->prev = pos;
+  node->next = pos != NULL ? pos->next : list->head;
+
+  if (node->next != NULL)
+    {
+      node->next->prev = node;
+    }
+  else
+    {
+      list->tail = node;
+    }
+
+  if (pos != NULL)
+    {
+      pos->next = node;
+    }
+  else
+    {
+      list->head = node;
+    }
+
+  list->node_count++;
+}
+
+static void
+node_destroy (unrolled_list_t *list, unrolled_list_node_t *node)
+{
+  if (node->prev != NULL)
+    {
+      node->prev->next = node->next;
+    }
+  else
+    {
+      list->head = node->next;
+    }
+
+  if (node->next != NULL)
+    {
+      node->next->prev = node->prev;
+    }
+  else
+    {
+      list->tail = node->prev;
+    }
+
+  list->node_count--;
+  cutils_deallocate (list->allocator, node);
+}
+
+/*
+ * Finds the node holding an element, walking from whichever end is closer.
+ * index must be less than the list length.
+ */
+static unrolled_list_node_t *
+locate (const unrolled_list_t *list, size_t index, size_t *offset)
+{
+  unrolled_list_node_t *node;
+
+  if (index < list->len / 2)
+    {
+      node = list->head;
+      while (index >= node->count)
+        {
+          index -= node->count;
+          node = node->next;
+        }
+      *offset = index;
+    }
+  else
+    {
+      size_t from_end = list->len - index;
+      node = list->tail;
+      while (from_end > node->count)
+        {
+          from_end -= node->count;
+          node = node->prev;
+        }
+      *offset = node->count - from_end;
+    }
+
+  return node;
+}
+
+/*
+ * Moves the upper half of a full node into a new node linked after it.
+ */
+static unrolled_list_node_t *
+node_split (unrolled_list_t *list, unrolled_list_node_t *node,
+            uint32_t timeout_ms)
+{
+  unrolled_list_node_t *upper = node_create (list, timeout_ms);
+  if (upper == NULL)
+    {
+      return NULL;
+    }
+
+  size_t half = node->count / 2;
+  upper->count = node->count - half;
+  memcpy (upper->data, node_elem (list, node, half),
+          upper->count * list->elem_len);
+  node->count = half;
+
+  node_link_after (list, node, upper);
+  return upper;
+}
+
+/*
+ * Merges an underfull node with a neighbour when both fit in one node.
+ */
+static void
+node_rebalance (unrolled_list_t *list, unrolled_list_node_t *node)
+{
+  if (node->count == 0)
+    {
+      node_destroy (list, node);
+      return;
+    }
+
+  if (node->count >= list->node_capacity / 2)
+    {
+      return;
+    }
+
+  unrolled_list_node_t *next = node->next;
+  unrolled_list_node_t *prev = node->prev;
+
+  if (next != NULL && node->count + next->count <= list->node_capacity)
+    {
+      memcpy (node_elem (list, node, node->count), next->data,
+              next->count * list->elem_len);
+      node->count += next->count;
+      node_destroy (list, next);
+    }
+  else if (prev != NULL && prev->count + node->count <= list->node_capacity)
+    {
+      memcpy (node_elem (list, prev, prev->count), node->data,
+              node->count * list->elem_len);
+      prev->count += node->count;
+      node_destroy (list, node);
+    }
+}
+
+unrolled_list_t *
+unrolled_list_create_with_allocator (size_t elem_len,
+                                     cutils_allocator_t *allocator)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (elem_len == 0 || allocator == NULL)
+    {
+      g_last_error = UNROLLED_LIST_INVALID_ARG;
+      return NULL;
+    }
+
+  if (elem_len > (SIZE_MAX - sizeof (unrolled_list_node_t)) / MIN_NODE_ELEMS)
+    {
+      g_last_error = UNROLLED_LIST_OVERFLOW;
+      return NULL;
+    }
+
+  unrolled_list_t *list = cutils_allocate_aligned (
+      allocator, sizeof (unrolled_list_t), CUTILS_ALIGNMENT);
+  if (list == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NO_MEMORY;
+      return NULL;
+    }
+
+  size_t capacity = 0;
+  if (CUTILS_UNROLLED_LIST_NODE_BYTES > sizeof (unrolled_list_node_t))
+    {
+      capacity = (CUTILS_UNROLLED_LIST_NODE_BYTES
+                  - sizeof (unrolled_list_node_t))
+                 / elem_len;
+    }
+
+  list->head = NULL;
+  list->tail = NULL;
+  list->len = 0;
+  list->node_count = 0;
+  list->node_capacity = capacity < MIN_NODE_ELEMS ? MIN_NODE_ELEMS : capacity;
+  list->elem_len = elem_len;
+  list->allocator = allocator;
+
+  return list;
+}
+
+unrolled_list_t *
+unrolled_list_create (size_t elem_len)
+{
+  return unrolled_list_create_with_allocator (elem_len,
+                                              cutils_get_default_allocator ());
+}
+
+void
+unrolled_list_destroy (unrolled_list_t *list)
+{
+  if (list == NULL)
+    {
+      return;
+    }
+
+  unrolled_list_clear (list);
+  cutils_deallocate (list->allocator, list);
+}
+
+bool
+unrolled_list_insert_timeout (unrolled_list_t *list, size_t index,
+                              const void *elem, uint32_t timeout_ms)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (list == NULL || elem == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  if (index > list->len)
+    {
+      g_last_error = UNROLLED_LIST_OUT_OF_RANGE;
+      return false;
+    }
+
+  unrolled_list_node_t *node;
+  size_t offset;
+
+  if (index == list->len)
+    {
+      node = list->tail;
+      if (node == NULL || node->count == list->node_capacity)
+        {
+          node = node_create (list, timeout_ms);
+          if (node == NULL)
+            {
+              return false;
+            }
+          node_link_after (list, list->tail, node);
+        }
+      offset = node->count;
+    }
+  else if (index == 0 && list->head->count == list->node_capacity)
+    {
+      node = node_create (list, timeout_ms);
+      if (node == NULL)
+        {
+          return false;
+        }
+      node_link_after (list, NULL, node);
+      offset = 0;
+    }
+  else
+    {
+      node = locate (list, index, &offset);
+      if (node->count == list->node_capacity)
+        {
+          unrolled_list_node_t *upper = node_split (list, node, timeout_ms);
+          if (upper == NULL)
+            {
+              return false;
+            }
+          if (offset > node->count)
+            {
+              offset -= node->count;
+              node = upper;
+            }
+        }
+    }
+
+  memmove (node_elem (list, node, offset + 1), node_elem (list, node, offset),
+           (node->count - offset) * list->elem_len);
+  memcpy (node_elem (list, node, offset), elem, list->elem_len);
+  node->count++;
+  list->len++;
+
+  return true;
+}
+
+bool
+unrolled_list_insert (unrolled_list_t *list, size_t index, const void *elem)
+{
+  return unrolled_list_insert_timeout (list, index, elem,
+                                       CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+unrolled_list_push_front_timeout (unrolled_list_t *list, const void *elem,
+                                  uint32_t timeout_ms)
+{
+  return unrolled_list_insert_timeout (list, 0, elem, timeout_ms);
+}
+
+bool
+unrolled_list_push_front (unrolled_list_t *list, const void *elem)
+{
+  return unrolled_list_insert_timeout (list, 0, elem,
+                                       CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+unrolled_list_push_back_timeout (unrolled_list_t *list, const void *elem,
+                                 uint32_t timeout_ms)
+{
+  if (list == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  return unrolled_list_insert_timeout (list, list->len, elem, timeout_ms);
+}
+
+bool
+unrolled_list_push_back (unrolled_list_t *list, const void *elem)
+{
+  return unrolled_list_push_back_timeout (list, elem,
+                                          CUTILS_MAX_OPERATION_TIME_MS);
+}
+
+bool
+unrolled_list_remove (unrolled_list_t *list, size_t index, void *out)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  if (index >= list->len)
+    {
+      g_last_error = UNROLLED_LIST_OUT_OF_RANGE;
+      return false;
+    }
+
+  size_t offset;
+  unrolled_list_node_t *node = locate (list, index, &offset);
+
+  if (out != NULL)
+    {
+      memcpy (out, node_elem (list, node, offset), list->elem_len);
+    }
+
+  memmove (node_elem (list, node, offset), node_elem (list, node, offset + 1),
+           (node->count - offset - 1) * list->elem_len);
+  node->count--;
+  list->len--;
+
+  node_rebalance (list, node);
+  return true;
+}
+
+bool
+unrolled_list_pop_front (unrolled_list_t *list, void *out)
+{
+  return unrolled_list_remove (list, 0, out);
+}
+
+bool
+unrolled_list_pop_back (unrolled_list_t *list, void *out)
+{
+  if (list == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  return unrolled_list_remove (list, list->len - 1, out);
+}
+
+bool
+unrolled_list_get (const unrolled_list_t *list, size_t index, void *out)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (list == NULL || out == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  if (index >= list->len)
+    {
+      g_last_error = UNROLLED_LIST_OUT_OF_RANGE;
+      return false;
+    }
+
+  size_t offset;
+  unrolled_list_node_t *node = locate (list, index, &offset);
+  memcpy (out, node_elem (list, node, offset), list->elem_len);
+  return true;
+}
+
+bool
+unrolled_list_set (unrolled_list_t *list, size_t index, const void *elem)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (list == NULL || elem == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  if (index >= list->len)
+    {
+      g_last_error = UNROLLED_LIST_OUT_OF_RANGE;
+      return false;
+    }
+
+  size_t offset;
+  unrolled_list_node_t *node = locate (list, index, &offset);
+  memcpy (node_elem (list, node, offset), elem, list->elem_len);
+  return true;
+}
+
+void *
+unrolled_list_at (const unrolled_list_t *list, size_t index)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return NULL;
+    }
+
+  if (index >= list->len)
+    {
+      g_last_error = UNROLLED_LIST_OUT_OF_RANGE;
+      return NULL;
+    }
+
+  size_t offset;
+  unrolled_list_node_t *node = locate (list, index, &offset);
+  return node_elem (list, node, offset);
+}
+
+bool
+unrolled_list_clear (unrolled_list_t *list)
+{
+  g_last_error = UNROLLED_LIST_OK;
+
+  if (list == NULL)
+    {
+      g_last_error = UNROLLED_LIST_NULL_PTR;
+      return false;
+    }
+
+  unrolled_list_node_t *node = list->head;
+  while (node != NULL)
+    {
+      unrolled_list_node_t *next = node->next;
+      cutils_deallocate (list->allocator, node);
+      node = next;
+    }
+
+  list->head = NULL;
+  list->tail = NULL;
+  list->len = 0;
+  list->node_count = 0;
+
+  return true;
+}
+
+size_t
+unrolled_list_length (const unrolled_list_t *list)
+{
+  return list ? list->len : 0;
+}
+
+size_t
+unrolled_list_node_count (const unrolled_list_t *list)
+{
+  return list ? list->node_count : 0;
+}
+
+size_t
+unrolled_list_node_capacity (const unrolled_list_t *list)
+{
+  return list ? list->node_capacity : 0;
+}
+
+size_t
+unrolled_list_memory_usage (const unrolled_list_t *list)
+{
+  if (list == NULL)
+    {
+      return 0;
+    }
+
+  return sizeof (unrolled_list_t) + (list->node_count * node_size (list));
+}
+
+unrolled_list_iterator_t
+unrolled_list_begin (unrolled_list_t *list)
+{
+  unrolled_list_iterator_t it = { list, list ? list->head : NULL, 0, 0 };
+  return it;
+}
+
+bool
+unrolled_list_iterator_next (unrolled_list_iterator_t *it)
+{
+  if (it == NULL || it->node == NULL)
+    {
+      return false;
+    }
+
+  it->index++;
+  if (++it->offset >= it->node->count)
+    {
+      it->node = it->node->next;
+      it->offset = 0;
+    }
+
+  return it->node != NULL;
+}
+
+void *
+unrolled_list_iterator_at (const unrolled_list_iterator_t *it)
+{
+  if (it == NULL || it->list == NULL || it->node == NULL)
+    {
+      return NULL;
+    }
+
+  return node_elem (it->list, it->node, it->offset);
+}
+
+bool
+unrolled_list_iterator_get (const unrolled_list_iterator_t *it, void *out)
+{
+  void *elem = unrolled_list_iterator_at (it);
+  if (elem == NULL || out == NULL)
+    {
+      return false;
+    }
+
+  memcpy (out, elem, it->list->elem_len);
+  return true;
+}
+
+bool
+unrolled_list_iterator_is_valid (const unrolled_list_iterator_t *it)
+{
+  return it != NULL && it->list != NULL && it->node != NULL;
+}
+
+unrolled_list_result_t
+unrolled_list_get_error (void)
+{
+  return g_last_error;
+}
@@ -1,5 +1,6 @@
 #include "cutils/vector.h"
 #include "cutils/config.h"
+#include "cutils/cpu.h"
 #include "cutils/time.h"
 #include <string.h>
 
@@ -7,6 +8,10 @@
 #include <stdlib.h>
 #include <threads.h>
 
+#if CUTILS_SIMD_X86
+#include <immintrin.h>
+#endif
+
 static thread_local vector_result_t g_last_error = VECTOR_OK;
 
 static bool
@@ -22,6 +27,38 @@ check_timeout ([[maybe_unused]] uint32_t start_time_ms,
 #endif
 }
 
+/*
+ * Moves the live elements into a fresh block of the requested capacity from
+ * the vector's own allocator. A capacity of zero releases the buffer.
+ */
+static bool
+reallocate (vector_t *vec, size_t capacity)
+{
+  void *new_data = NULL;
+
+  if (capacity > 0)
+    {
+      new_data = cutils_allocate_aligned (
+          vec->allocator, capacity * vec->elem_len, CUTILS_ALIGNMENT);
+      if (new_data == NULL)
+        {
+          g_last_error = VECTOR_NO_MEMORY;
+          return false;
+        }
+
+      if (vec->len > 0)
+        {
+          memcpy (new_data, vec->data, vec->len * vec->elem_len);
+        }
+    }
+
+  cutils_deallocate (vec->allocator, vec->data);
+  vec->data = new_data;
+  vec->capacity = capacity;
+
+  return true;
+}
+
 vector_t *
 vector_create_with_allocator (size_t init_capacity, size_t elem_len,
                               cutils_allocator_t *allocator)
@@ -73,9 +110,8 @@ vector_create_with_allocator (size_t init_capacity, size_t elem_len,
 vector_t *
 vector_create (size_t init_capacity, size_t elem_len)
 {
-  cutils_allocator_t default_allocator = cutils_create_default_allocator ();
   return vector_create_with_allocator (init_capacity, elem_len,
-                                       &default_allocator);
+                                       cutils_get_default_allocator ());
 }
 
 static bool
@@ -152,45 +188,138 @@ vector_copy (const vector_t *vec)
       return NULL;
     }
 
-  vector_t *copy_vec = malloc (sizeof (vector_t));
+  vector_t *copy_vec = vector_create_with_allocator (
+      vec->len, vec->elem_len, vec->allocator);
   if (copy_vec == NULL)
     {
-      g_last_error = VECTOR_NO_MEMORY;
       return NULL;
     }
 
-  copy_vec->data = malloc (vec->elem_len * vec->capacity);
-  if (copy_vec->data == NULL)
+  if (vec->len > 0)
     {
-      free (copy_vec);
-      g_last_error = VECTOR_NO_MEMORY;
-      return NULL;
+      memcpy (copy_vec->data, vec->data, vec->elem_len * vec->len);
     }
-
-  memcpy (copy_vec->data, vec->data, vec->elem_len * vec->len);
-  copy_vec->capacity = vec->capacity;
   copy_vec->len = vec->len;
-  copy_vec->elem_len = vec->elem_len;
 
   return copy_vec;
 }
 
-void
-vector_destroy (vector_t *vec)
+bool
+vector_copy_into (vector_t *dst, const vector_t *src)
+{
+  g_last_error = VECTOR_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (dst->elem_len != src->elem_len)
+    {
+      g_last_error = VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  if (dst->capacity < src->len)
+    {
+      // Nothing in dst survives, so drop it before growing to avoid a copy;
+      // a failed reallocation leaves dst as it was
+      size_t old_len = dst->len;
+      dst->len = 0;
+      if (!reallocate (dst, src->len))
+        {
+          dst->len = old_len;
+          return false;
+        }
+    }
+
+  if (src->len > 0)
+    {
+      memcpy (dst->data, src->data, src->len * src->elem_len);
+    }
+  dst->len = src->len;
+
+  return true;
+}
+
+bool
+vector_move (vector_t *dst, vector_t *src)
+{
+  g_last_error = VECTOR_OK;
+
+  if (dst == NULL || src == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (dst->elem_len != src->elem_len
+      || !cutils_allocator_equal (dst->allocator, src->allocator))
+    {
+      g_last_error = VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  if (dst == src)
+    {
+      return true;
+    }
+
+  cutils_deallocate (dst->allocator, dst->data);
+  dst->data = src->data;
+  dst->len = src->len;
+  dst->capacity = src->capacity;
+
+  src->data = NULL;
+  src->len = 0;
+  src->capacity = 0;
+
+  return true;
+}
+
+void *
+vector_take (vector_t *vec, size_t *out_len)
 {
   g_last_error = VECTOR_OK;
 
   if (vec == NULL)
     {
       g_last_error = VECTOR_NULL_PTR;
+      return NULL;
+    }
+
+  void *data = vec->data;
+  if (out_len != NULL)
+    {
+      *out_len = vec->len;
     }
 
-  if (vec->data != NULL)
+  vec->data = NULL;
+  vec->len = 0;
+  vec->capacity = 0;
+
+  return data;
+}
+
+void
+vector_destroy (vector_t *vec)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL)
     {
-      free (vec->data);
+      g_last_error = VECTOR_NULL_PTR;
+      return;
     }
 
-  free (vec);
+  cutils_deallocate (vec->allocator, vec->data);
+  cutils_deallocate (vec->allocator, vec);
 }
 
 bool
@@ -289,15 +418,10 @@ vector_insert (vector_t *vec, size_t index, const void *elem)
           return false;
         }
 
-      void *new_data = realloc (vec->data, new_capacity * vec->elem_len);
-      if (new_data == NULL)
+      if (!reallocate (vec, new_capacity))
         {
-          g_last_error = VECTOR_NO_MEMORY;
           return false;
         }
-
-      vec->data = new_data;
-      vec->capacity = new_capacity;
     }
 
   if (index < vec->len)
@@ -347,7 +471,7 @@ vector_remove (vector_t *vec, size_t index, void *out)
 }
 
 bool
-vector_reserve (vector_t *vec, size_t capacity)
+vector_swap_remove (vector_t *vec, size_t index, void *out)
 {
   g_last_error = VECTOR_OK;
 
@@ -357,32 +481,30 @@ vector_reserve (vector_t *vec, size_t capacity)
       return false;
     }
 
-  if (capacity <= vec->capacity)
+  if (index >= vec->len)
     {
-      return true;
+      g_last_error = VECTOR_OUT_OF_RANGE;
+      return false;
     }
 
-  if (SIZE_MAX / vec->elem_len < capacity)
+  char *slot = (char *)vec->data + (index * vec->elem_len);
+  if (out != NULL)
     {
-      g_last_error = VECTOR_OVERFLOW;
-      return false;
+      memcpy (out, slot, vec->elem_len);
     }
 
-  void *new_data = realloc (vec->data, capacity * vec->elem_len);
-  if (new_data == NULL)
+  if (index < vec->len - 1)
     {
-      g_last_error = VECTOR_NO_MEMORY;
-      return false;
+      memcpy (slot, (char *)vec->data + ((vec->len - 1) * vec->elem_len),
+              vec->elem_len);
     }
 
-  vec->data = new_data;
-  vec->capacity = capacity;
-
+  vec->len--;
   return true;
 }
 
 bool
-vector_shrink (vector_t *vec)
+vector_reserve (vector_t *vec, size_t capacity)
 {
   g_last_error = VECTOR_OK;
 
@@ -392,30 +514,37 @@ vector_shrink (vector_t *vec)
       return false;
     }
 
-  if (vec->len == vec->capacity)
+  if (capacity <= vec->capacity)
     {
       return true;
     }
 
-  if (vec->len == 0)
+  if (SIZE_MAX / vec->elem_len < capacity)
     {
-      free (vec->data);
-      vec->data = NULL;
-      vec->capacity = 0;
-      return true;
+      g_last_error = VECTOR_OVERFLOW;
+      return false;
     }
 
-  void *new_data = realloc (vec->data, vec->len * vec->elem_len);
-  if (new_data == NULL)
+  return reallocate (vec, capacity);
+}
+
+bool
+vector_shrink (vector_t *vec)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL)
     {
-      g_last_error = VECTOR_NO_MEMORY;
+      g_last_error = VECTOR_NULL_PTR;
       return false;
     }
 
-  vec->data = new_data;
-  vec->capacity = vec->len;
+  if (vec->len == vec->capacity)
+    {
+      return true;
+    }
 
-  return true;
+  return reallocate (vec, vec->len);
 }
 
 bool
@@ -507,3 +636,1634 @@ vector_can_perform_operation (const vector_t *vec, size_t required_capacity)
   return cutils_can_allocate (vec->allocator, new_capacity * vec->elem_len,
                               CUTILS_ALIGNMENT);
 }
+
+// Sorting implementation
+typedef struct
+{
+  size_t elem_len;
+  size_t key_offset;
+  int (*compare) (const void *a, const void *b);
+} sort_ctx_t;
+
+typedef bool (*sort_less_fn) (const sort_ctx_t *ctx, const char *a,
+                              const char *b);
+
+typedef struct
+{
+  char *base;
+  size_t len;
+  size_t depth;
+} sort_range_t;
+
+#define SORT_NINTHER_THRESHOLD 128
+#define SORT_PARTIAL_INSERTION_LIMIT 16
+
+static void
+swap_bytes (char *a, char *b, size_t elem_len)
+{
+  unsigned char tmp[64];
+
+  while (elem_len > 0)
+    {
+      size_t chunk = elem_len < sizeof (tmp) ? elem_len : sizeof (tmp);
+      memcpy (tmp, a, chunk);
+      memcpy (a, b, chunk);
+      memcpy (b, tmp, chunk);
+      a += chunk;
+      b += chunk;
+      elem_len -= chunk;
+    }
+}
+
+// Word-sized elements are swapped inline, everything else goes out of line
+[[gnu::always_inline]] static inline void
+swap_elems (char *a, char *b, size_t elem_len)
+{
+  if (elem_len == sizeof (uint64_t))
+    {
+      uint64_t tmp;
+      memcpy (&tmp, a, sizeof (tmp));
+      memcpy (a, b, sizeof (tmp));
+      memcpy (b, &tmp, sizeof (tmp));
+    }
+  else if (elem_len == sizeof (uint32_t))
+    {
+      uint32_t tmp;
+      memcpy (&tmp, a, sizeof (tmp));
+      memcpy (a, b, sizeof (tmp));
+      memcpy (b, &tmp, sizeof (tmp));
+    }
+  else
+    {
+      swap_bytes (a, b, elem_len);
+    }
+}
+
+[[gnu::always_inline]] static inline void
+copy_elem (char *dst, const char *src, size_t elem_len)
+{
+  switch (elem_len)
+    {
+    case 4:
+      memcpy (dst, src, 4);
+      return;
+    case 8:
+      memcpy (dst, src, 8);
+      return;
+    case 16:
+      memcpy (dst, src, 16);
+      return;
+    default:
+      memcpy (dst, src, elem_len);
+      return;
+    }
+}
+
+static size_t
+floor_log2 (size_t n)
+{
+  size_t log = 0;
+  while (n > 1)
+    {
+      n >>= 1;
+      log++;
+    }
+  return log;
+}
+
+[[gnu::always_inline]] static inline void
+sort_insertion (char *base, size_t n, const sort_ctx_t *ctx, sort_less_fn less)
+{
+  size_t len = ctx->elem_len;
+
+  for (size_t i = 1; i < n; i++)
+    {
+      for (size_t j = i;
+           j > 0 && less (ctx, base + (j * len), base + ((j - 1) * len)); j--)
+        {
+          swap_elems (base + (j * len), base + ((j - 1) * len), len);
+        }
+    }
+}
+
+// Insertion sort that gives up after a bounded number of moves
+static bool
+sort_partial_insertion (char *base, size_t n, const sort_ctx_t *ctx,
+                        sort_less_fn less)
+{
+  size_t len = ctx->elem_len;
+  size_t moves = 0;
+
+  for (size_t i = 1; i < n; i++)
+    {
+      for (size_t j = i;
+           j > 0 && less (ctx, base + (j * len), base + ((j - 1) * len)); j--)
+        {
+          swap_elems (base + (j * len), base + ((j - 1) * len), len);
+          if (++moves > SORT_PARTIAL_INSERTION_LIMIT)
+            {
+              return false;
+            }
+        }
+    }
+
+  return true;
+}
+
+static void
+sort_sift_down (char *base, size_t root, size_t n, const sort_ctx_t *ctx,
+                sort_less_fn less)
+{
+  size_t len = ctx->elem_len;
+
+  for (;;)
+    {
+      size_t child = (2 * root) + 1;
+      if (child >= n)
+        {
+          return;
+        }
+
+      if (child + 1 < n
+          && less (ctx, base + (child * len), base + ((child + 1) * len)))
+        {
+          child++;
+        }
+
+      if (!less (ctx, base + (root * len), base + (child * len)))
+        {
+          return;
+        }
+
+      swap_elems (base + (root * len), base + (child * len), len);
+      root = child;
+    }
+}
+
+// Fallback path only, kept out of line to bound code size per instantiation
+static void
+sort_heapsort (char *base, size_t n, const sort_ctx_t *ctx, sort_less_fn less)
+{
+  size_t len = ctx->elem_len;
+
+  for (size_t i = n / 2; i-- > 0;)
+    {
+      sort_sift_down (base, i, n, ctx, less);
+    }
+
+  for (size_t end = n - 1; end > 0; end--)
+    {
+      swap_elems (base, base + (end * len), len);
+      sort_sift_down (base, 0, end, ctx, less);
+    }
+}
+
+static void
+sort3 (char *base, size_t a, size_t b, size_t c, const sort_ctx_t *ctx,
+       sort_less_fn less)
+{
+  size_t len = ctx->elem_len;
+  char *pa = base + (a * len);
+  char *pb = base + (b * len);
+  char *pc = base + (c * len);
+
+  if (less (ctx, pb, pa))
+    {
+      swap_elems (pa, pb, len);
+    }
+  if (less (ctx, pc, pb))
+    {
+      swap_elems (pb, pc, len);
+      if (less (ctx, pb, pa))
+        {
+          swap_elems (pa, pb, len);
+        }
+    }
+}
+
+[[gnu::always_inline]] static inline void
+sort_introsort (char *base, size_t n, const sort_ctx_t *ctx, sort_less_fn less)
+{
+  // Larger halves are deferred, so the stack never exceeds log2(n) entries
+  sort_range_t stack[sizeof (size_t) * 8];
+  size_t top = 0;
+  size_t depth = 2 * floor_log2 (n);
+  size_t len = ctx->elem_len;
+
+  for (;;)
+    {
+      bool done = false;
+
+      while (!done && n > CUTILS_VECTOR_SORT_INSERTION_THRESHOLD)
+        {
+          if (depth == 0)
+            {
+              sort_heapsort (base, n, ctx, less);
+              done = true;
+              break;
+            }
+          depth--;
+
+          // Move the median of three (or ninther) pivot to the front
+          size_t mid = n / 2;
+          if (n > SORT_NINTHER_THRESHOLD)
+            {
+              sort3 (base, 0, mid, n - 1, ctx, less);
+              sort3 (base, 1, mid - 1, n - 2, ctx, less);
+              sort3 (base, 2, mid + 1, n - 3, ctx, less);
+              sort3 (base, mid - 1, mid, mid + 1, ctx, less);
+            }
+          else
+            {
+              sort3 (base, 0, mid, n - 1, ctx, less);
+            }
+          swap_elems (base, base + (mid * len), len);
+
+          // Hoare partition around base[0]
+          size_t i = 0;
+          size_t j = n;
+          bool swapped = false;
+          for (;;)
+            {
+              do
+                {
+                  i++;
+                }
+              while (i < n && less (ctx, base + (i * len), base));
+              do
+                {
+                  j--;
+                }
+              while (less (ctx, base, base + (j * len)));
+
+              if (i >= j)
+                {
+                  break;
+                }
+              swap_elems (base + (i * len), base + (j * len), len);
+              swapped = true;
+            }
+          swap_elems (base, base + (j * len), len);
+
+          char *left = base;
+          size_t left_len = j;
+          char *right = base + ((j + 1) * len);
+          size_t right_len = n - j - 1;
+
+          // Input looked presorted, try to finish both sides cheaply
+          if (!swapped && sort_partial_insertion (left, left_len, ctx, less)
+              && sort_partial_insertion (right, right_len, ctx, less))
+            {
+              done = true;
+              break;
+            }
+
+          // Highly unbalanced split, shuffle to break adversarial patterns
+          if (left_len < n / 8 || right_len < n / 8)
+            {
+              if (left_len >= CUTILS_VECTOR_SORT_INSERTION_THRESHOLD)
+                {
+                  swap_elems (left, left + ((left_len / 4) * len), len);
+                  swap_elems (left + ((left_len - 1) * len),
+                              left + ((left_len - (left_len / 4)) * len),
+                              len);
+                }
+              if (right_len >= CUTILS_VECTOR_SORT_INSERTION_THRESHOLD)
+                {
+                  swap_elems (right, right + ((right_len / 4) * len), len);
+                  swap_elems (right + ((right_len - 1) * len),
+                              right + ((right_len - (right_len / 4)) * len),
+                              len);
+                }
+            }
+
+          if (left_len < right_len)
+            {
+              stack[top++] = (sort_range_t){ right, right_len, depth };
+              n = left_len;
+            }
+          else
+            {
+              stack[top++] = (sort_range_t){ left, left_len, depth };
+              base = right;
+              n = right_len;
+            }
+        }
+
+      if (!done)
+        {
+          sort_insertion (base, n, ctx, less);
+        }
+
+      if (top == 0)
+        {
+          return;
+        }
+
+      top--;
+      base = stack[top].base;
+      n = stack[top].len;
+      depth = stack[top].depth;
+    }
+}
+
+static bool
+less_compare (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return ctx->compare (a, b) < 0;
+}
+
+[[gnu::always_inline]] static inline uint64_t
+load_key (vector_key_type_t key_type, const char *p)
+{
+  switch (key_type)
+    {
+    case VECTOR_KEY_U32:
+    case VECTOR_KEY_I32:
+    case VECTOR_KEY_F32:
+      {
+        uint32_t bits;
+        memcpy (&bits, p, sizeof (bits));
+        return bits;
+      }
+    default:
+      {
+        uint64_t bits;
+        memcpy (&bits, p, sizeof (bits));
+        return bits;
+      }
+    }
+}
+
+// Maps a key to an unsigned integer with the same ordering
+[[gnu::always_inline]] static inline uint64_t
+radix_key (vector_key_type_t key_type, const char *p)
+{
+  uint64_t bits = load_key (key_type, p);
+
+  switch (key_type)
+    {
+    case VECTOR_KEY_I32:
+      return bits ^ UINT32_C (0x80000000);
+    case VECTOR_KEY_F32:
+      return (bits & UINT32_C (0x80000000)) != 0
+                 ? ~bits & UINT32_C (0xFFFFFFFF)
+                 : bits | UINT32_C (0x80000000);
+    case VECTOR_KEY_I64:
+      return bits ^ UINT64_C (0x8000000000000000);
+    case VECTOR_KEY_F64:
+      return (bits & UINT64_C (0x8000000000000000)) != 0
+                 ? ~bits
+                 : bits | UINT64_C (0x8000000000000000);
+    default:
+      return bits;
+    }
+}
+
+static size_t
+key_size (vector_key_type_t key_type)
+{
+  switch (key_type)
+    {
+    case VECTOR_KEY_U32:
+    case VECTOR_KEY_I32:
+    case VECTOR_KEY_F32:
+      return sizeof (uint32_t);
+    case VECTOR_KEY_U64:
+    case VECTOR_KEY_I64:
+    case VECTOR_KEY_F64:
+      return sizeof (uint64_t);
+    default:
+      return 0;
+    }
+}
+
+// Compares two keys of the given type, the type is a constant after inlining
+[[gnu::always_inline]] static inline bool
+key_less (vector_key_type_t key_type, const char *a, const char *b)
+{
+  switch (key_type)
+    {
+    case VECTOR_KEY_U32:
+      {
+        uint32_t ka;
+        uint32_t kb;
+        memcpy (&ka, a, sizeof (ka));
+        memcpy (&kb, b, sizeof (kb));
+        return ka < kb;
+      }
+    case VECTOR_KEY_I32:
+      {
+        int32_t ka;
+        int32_t kb;
+        memcpy (&ka, a, sizeof (ka));
+        memcpy (&kb, b, sizeof (kb));
+        return ka < kb;
+      }
+    case VECTOR_KEY_F32:
+      {
+        float ka;
+        float kb;
+        memcpy (&ka, a, sizeof (ka));
+        memcpy (&kb, b, sizeof (kb));
+        return ka < kb;
+      }
+    case VECTOR_KEY_U64:
+      {
+        uint64_t ka;
+        uint64_t kb;
+        memcpy (&ka, a, sizeof (ka));
+        memcpy (&kb, b, sizeof (kb));
+        return ka < kb;
+      }
+    case VECTOR_KEY_I64:
+      {
+        int64_t ka;
+        int64_t kb;
+        memcpy (&ka, a, sizeof (ka));
+        memcpy (&kb, b, sizeof (kb));
+        return ka < kb;
+      }
+    case VECTOR_KEY_F64:
+      {
+        double ka;
+        double kb;
+        memcpy (&ka, a, sizeof (ka));
+        memcpy (&kb, b, sizeof (kb));
+        return ka < kb;
+      }
+    }
+
+  return false;
+}
+
+static bool
+less_u32 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return key_less (VECTOR_KEY_U32, a + ctx->key_offset, b + ctx->key_offset);
+}
+
+static bool
+less_i32 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return key_less (VECTOR_KEY_I32, a + ctx->key_offset, b + ctx->key_offset);
+}
+
+static bool
+less_f32 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return key_less (VECTOR_KEY_F32, a + ctx->key_offset, b + ctx->key_offset);
+}
+
+static bool
+less_u64 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return key_less (VECTOR_KEY_U64, a + ctx->key_offset, b + ctx->key_offset);
+}
+
+static bool
+less_i64 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return key_less (VECTOR_KEY_I64, a + ctx->key_offset, b + ctx->key_offset);
+}
+
+static bool
+less_f64 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return key_less (VECTOR_KEY_F64, a + ctx->key_offset, b + ctx->key_offset);
+}
+
+// Radix order for floats, used for the small-input path of radix sort
+static bool
+less_radix_f32 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return radix_key (VECTOR_KEY_F32, a + ctx->key_offset)
+         < radix_key (VECTOR_KEY_F32, b + ctx->key_offset);
+}
+
+static bool
+less_radix_f64 (const sort_ctx_t *ctx, const char *a, const char *b)
+{
+  return radix_key (VECTOR_KEY_F64, a + ctx->key_offset)
+         < radix_key (VECTOR_KEY_F64, b + ctx->key_offset);
+}
+
+static bool
+validate_key (const vector_t *vec, vector_key_type_t key_type,
+              size_t key_offset)
+{
+  size_t size = key_size (key_type);
+
+  if (size == 0 || key_offset > vec->elem_len
+      || vec->elem_len - key_offset < size)
+    {
+      g_last_error = VECTOR_INVALID_ARG;
+      return false;
+    }
+
+  return true;
+}
+
+bool
+vector_sort (vector_t *vec, int (*compare) (const void *a, const void *b))
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || compare == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (vec->len < 2)
+    {
+      return true;
+    }
+
+  sort_ctx_t ctx = { vec->elem_len, 0, compare };
+  sort_introsort (vec->data, vec->len, &ctx, less_compare);
+
+  return true;
+}
+
+bool
+vector_sort_by_key (vector_t *vec, vector_key_type_t key_type,
+                    size_t key_offset)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!validate_key (vec, key_type, key_offset))
+    {
+      return false;
+    }
+
+  if (vec->len < 2)
+    {
+      return true;
+    }
+
+  sort_ctx_t ctx = { vec->elem_len, key_offset, NULL };
+
+  switch (key_type)
+    {
+    case VECTOR_KEY_U32:
+      sort_introsort (vec->data, vec->len, &ctx, less_u32);
+      break;
+    case VECTOR_KEY_I32:
+      sort_introsort (vec->data, vec->len, &ctx, less_i32);
+      break;
+    case VECTOR_KEY_F32:
+      sort_introsort (vec->data, vec->len, &ctx, less_f32);
+      break;
+    case VECTOR_KEY_U64:
+      sort_introsort (vec->data, vec->len, &ctx, less_u64);
+      break;
+    case VECTOR_KEY_I64:
+      sort_introsort (vec->data, vec->len, &ctx, less_i64);
+      break;
+    case VECTOR_KEY_F64:
+      sort_introsort (vec->data, vec->len, &ctx, less_f64);
+      break;
+    }
+
+  return true;
+}
+
+[[gnu::always_inline]] static inline void
+radix_sort_impl (char *data, char *scratch, size_t *counts, size_t n,
+                 size_t elem_len, size_t key_offset,
+                 vector_key_type_t key_type)
+{
+  size_t passes = key_size (key_type);
+
+  // Histogram every digit in a single read of the input
+  memset (counts, 0, passes * 256 * sizeof (size_t));
+  for (size_t i = 0; i < n; i++)
+    {
+      uint64_t key = radix_key (key_type, data + (i * elem_len) + key_offset);
+      for (size_t pass = 0; pass < passes; pass++)
+        {
+          counts[(pass * 256) + ((key >> (pass * 8)) & 0xFF)]++;
+        }
+    }
+
+  uint64_t first_key = radix_key (key_type, data + key_offset);
+  char *src = data;
+  char *dst = scratch;
+
+  for (size_t pass = 0; pass < passes; pass++)
+    {
+      size_t *count = counts + (pass * 256);
+      size_t shift = pass * 8;
+
+      // Every key shares this digit, the pass would be a plain copy
+      if (count[(first_key >> shift) & 0xFF] == n)
+        {
+          continue;
+        }
+
+      size_t sum = 0;
+      for (size_t digit = 0; digit < 256; digit++)
+        {
+          size_t tmp = count[digit];
+          count[digit] = sum;
+          sum += tmp;
+        }
+
+      for (size_t i = 0; i < n; i++)
+        {
+          const char *elem = src + (i * elem_len);
+          uint64_t key = radix_key (key_type, elem + key_offset);
+          size_t pos = count[(key >> shift) & 0xFF]++;
+          copy_elem (dst + (pos * elem_len), elem, elem_len);
+        }
+
+      char *tmp = src;
+      src = dst;
+      dst = tmp;
+    }
+
+  if (src != data)
+    {
+      memcpy (data, src, n * elem_len);
+    }
+}
+
+bool
+vector_radix_sort (vector_t *vec, vector_key_type_t key_type,
+                   size_t key_offset)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return false;
+    }
+
+  if (!validate_key (vec, key_type, key_offset))
+    {
+      return false;
+    }
+
+  if (vec->len < 2)
+    {
+      return true;
+    }
+
+  // Small inputs: a stable insertion sort beats the histogram passes
+  if (vec->len < CUTILS_VECTOR_SORT_RADIX_THRESHOLD)
+    {
+      sort_ctx_t ctx = { vec->elem_len, key_offset, NULL };
+      sort_less_fn less = NULL;
+      switch (key_type)
+        {
+        case VECTOR_KEY_U32:
+          less = less_u32;
+          break;
+        case VECTOR_KEY_I32:
+          less = less_i32;
+          break;
+        case VECTOR_KEY_F32:
+          less = less_radix_f32;
+          break;
+        case VECTOR_KEY_U64:
+          less = less_u64;
+          break;
+        case VECTOR_KEY_I64:
+          less = less_i64;
+          break;
+        case VECTOR_KEY_F64:
+          less = less_radix_f64;
+          break;
+        }
+      sort_insertion (vec->data, vec->len, &ctx, less);
+      return true;
+    }
+
+  size_t passes = key_size (key_type);
+  if (SIZE_MAX / vec->elem_len < vec->len)
+    {
+      g_last_error = VECTOR_OVERFLOW;
+      return false;
+    }
+
+  size_t data_size = vec->len * vec->elem_len;
+  size_t counts_size = passes * 256 * sizeof (size_t);
+  if (SIZE_MAX - counts_size < data_size)
+    {
+      g_last_error = VECTOR_OVERFLOW;
+      return false;
+    }
+
+  // Histogram first, it is size_t aligned regardless of elem_len
+  char *scratch = cutils_allocate_aligned (
+      vec->allocator, counts_size + data_size, CUTILS_ALIGNMENT);
+  if (scratch == NULL)
+    {
+      g_last_error = VECTOR_NO_MEMORY;
+      return false;
+    }
+
+  size_t *counts = (size_t *)(void *)scratch;
+  char *buffer = scratch + counts_size;
+
+  switch (key_type)
+    {
+    case VECTOR_KEY_U32:
+      radix_sort_impl (vec->data, buffer, counts, vec->len, vec->elem_len,
+                       key_offset, VECTOR_KEY_U32);
+      break;
+    case VECTOR_KEY_I32:
+      radix_sort_impl (vec->data, buffer, counts, vec->len, vec->elem_len,
+                       key_offset, VECTOR_KEY_I32);
+      break;
+    case VECTOR_KEY_F32:
+      radix_sort_impl (vec->data, buffer, counts, vec->len, vec->elem_len,
+                       key_offset, VECTOR_KEY_F32);
+      break;
+    case VECTOR_KEY_U64:
+      radix_sort_impl (vec->data, buffer, counts, vec->len, vec->elem_len,
+                       key_offset, VECTOR_KEY_U64);
+      break;
+    case VECTOR_KEY_I64:
+      radix_sort_impl (vec->data, buffer, counts, vec->len, vec->elem_len,
+                       key_offset, VECTOR_KEY_I64);
+      break;
+    case VECTOR_KEY_F64:
+      radix_sort_impl (vec->data, buffer, counts, vec->len, vec->elem_len,
+                       key_offset, VECTOR_KEY_F64);
+      break;
+    }
+
+  cutils_deallocate (vec->allocator, scratch);
+  return true;
+}
+
+// Searching implementation
+static bool
+is_word_size (size_t elem_len)
+{
+  return elem_len == 1 || elem_len == 2 || elem_len == 4 || elem_len == 8;
+}
+
+[[gnu::always_inline]] static inline uint64_t
+load_word (const char *p, size_t width)
+{
+  switch (width)
+    {
+    case 1:
+      {
+        uint8_t word;
+        memcpy (&word, p, sizeof (word));
+        return word;
+      }
+    case 2:
+      {
+        uint16_t word;
+        memcpy (&word, p, sizeof (word));
+        return word;
+      }
+    case 4:
+      {
+        uint32_t word;
+        memcpy (&word, p, sizeof (word));
+        return word;
+      }
+    default:
+      {
+        uint64_t word;
+        memcpy (&word, p, sizeof (word));
+        return word;
+      }
+    }
+}
+
+[[gnu::always_inline]] static inline size_t
+find_scalar_w (const char *data, size_t start, size_t n, size_t width,
+               uint64_t needle)
+{
+  for (size_t i = start; i < n; i++)
+    {
+      if (load_word (data + (i * width), width) == needle)
+        {
+          return i;
+        }
+    }
+  return SIZE_MAX;
+}
+
+[[gnu::always_inline]] static inline size_t
+count_scalar_w (const char *data, size_t start, size_t n, size_t width,
+                uint64_t needle)
+{
+  size_t count = 0;
+  for (size_t i = start; i < n; i++)
+    {
+      count += load_word (data + (i * width), width) == needle;
+    }
+  return count;
+}
+
+static size_t
+find_scalar (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return find_scalar_w (data, 0, n, 1, needle);
+    case 2:
+      return find_scalar_w (data, 0, n, 2, needle);
+    case 4:
+      return find_scalar_w (data, 0, n, 4, needle);
+    default:
+      return find_scalar_w (data, 0, n, 8, needle);
+    }
+}
+
+static size_t
+count_scalar (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return count_scalar_w (data, 0, n, 1, needle);
+    case 2:
+      return count_scalar_w (data, 0, n, 2, needle);
+    case 4:
+      return count_scalar_w (data, 0, n, 4, needle);
+    default:
+      return count_scalar_w (data, 0, n, 8, needle);
+    }
+}
+
+#if CUTILS_SIMD_X86
+[[gnu::target ("sse2"), gnu::always_inline]] static inline __m128i
+sse2_broadcast (uint64_t needle, size_t width)
+{
+  switch (width)
+    {
+    case 1:
+      return _mm_set1_epi8 ((char)needle);
+    case 2:
+      return _mm_set1_epi16 ((short)needle);
+    case 4:
+      return _mm_set1_epi32 ((int)needle);
+    default:
+      return _mm_set1_epi64x ((long long)needle);
+    }
+}
+
+[[gnu::target ("sse2"), gnu::always_inline]] static inline uint32_t
+sse2_match_mask (const char *p, __m128i needle, size_t width)
+{
+  __m128i block = _mm_loadu_si128 ((const void *)p);
+  __m128i eq;
+
+  switch (width)
+    {
+    case 1:
+      eq = _mm_cmpeq_epi8 (block, needle);
+      break;
+    case 2:
+      eq = _mm_cmpeq_epi16 (block, needle);
+      break;
+    case 4:
+      eq = _mm_cmpeq_epi32 (block, needle);
+      break;
+    default:
+      // No 64-bit compare before SSE4.1, both 32-bit halves must match
+      eq = _mm_cmpeq_epi32 (block, needle);
+      eq = _mm_and_si128 (eq, _mm_shuffle_epi32 (eq, 0xB1));
+      break;
+    }
+
+  return (uint32_t)_mm_movemask_epi8 (eq);
+}
+
+[[gnu::target ("sse2"), gnu::always_inline]] static inline size_t
+find_sse2_w (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  __m128i v = sse2_broadcast (needle, width);
+  size_t per_block = 16 / width;
+  size_t i = 0;
+
+  for (; i + (4 * per_block) <= n; i += 4 * per_block)
+    {
+      const char *p = data + (i * width);
+      uint64_t mask = (uint64_t)sse2_match_mask (p, v, width)
+                      | ((uint64_t)sse2_match_mask (p + 16, v, width) << 16)
+                      | ((uint64_t)sse2_match_mask (p + 32, v, width) << 32)
+                      | ((uint64_t)sse2_match_mask (p + 48, v, width) << 48);
+      if (mask != 0)
+        {
+          return i + ((size_t)__builtin_ctzll (mask) / width);
+        }
+    }
+
+  return find_scalar_w (data, i, n, width, needle);
+}
+
+[[gnu::target ("sse2"), gnu::always_inline]] static inline size_t
+count_sse2_w (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  __m128i v = sse2_broadcast (needle, width);
+  size_t per_block = 16 / width;
+  size_t bits = 0;
+  size_t i = 0;
+
+  for (; i + per_block <= n; i += per_block)
+    {
+      bits += (size_t)__builtin_popcount (
+          sse2_match_mask (data + (i * width), v, width));
+    }
+
+  return (bits / width) + count_scalar_w (data, i, n, width, needle);
+}
+
+[[gnu::target ("sse2")]] static size_t
+find_sse2 (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return find_sse2_w (data, n, 1, needle);
+    case 2:
+      return find_sse2_w (data, n, 2, needle);
+    case 4:
+      return find_sse2_w (data, n, 4, needle);
+    default:
+      return find_sse2_w (data, n, 8, needle);
+    }
+}
+
+[[gnu::target ("sse2")]] static size_t
+count_sse2 (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return count_sse2_w (data, n, 1, needle);
+    case 2:
+      return count_sse2_w (data, n, 2, needle);
+    case 4:
+      return count_sse2_w (data, n, 4, needle);
+    default:
+      return count_sse2_w (data, n, 8, needle);
+    }
+}
+
+[[gnu::target ("avx2,popcnt"), gnu::always_inline]] static inline __m256i
+avx2_broadcast (uint64_t needle, size_t width)
+{
+  switch (width)
+    {
+    case 1:
+      return _mm256_set1_epi8 ((char)needle);
+    case 2:
+      return _mm256_set1_epi16 ((short)needle);
+    case 4:
+      return _mm256_set1_epi32 ((int)needle);
+    default:
+      return _mm256_set1_epi64x ((long long)needle);
+    }
+}
+
+[[gnu::target ("avx2,popcnt"), gnu::always_inline]] static inline uint32_t
+avx2_match_mask (const char *p, __m256i needle, size_t width)
+{
+  __m256i block = _mm256_loadu_si256 ((const void *)p);
+  __m256i eq;
+
+  switch (width)
+    {
+    case 1:
+      eq = _mm256_cmpeq_epi8 (block, needle);
+      break;
+    case 2:
+      eq = _mm256_cmpeq_epi16 (block, needle);
+      break;
+    case 4:
+      eq = _mm256_cmpeq_epi32 (block, needle);
+      break;
+    default:
+      eq = _mm256_cmpeq_epi64 (block, needle);
+      break;
+    }
+
+  return (uint32_t)_mm256_movemask_epi8 (eq);
+}
+
+[[gnu::target ("avx2,popcnt"), gnu::always_inline]] static inline size_t
+find_avx2_w (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  __m256i v = avx2_broadcast (needle, width);
+  size_t per_block = 32 / width;
+  size_t i = 0;
+
+  // Two blocks per iteration, one cache line, a single branch
+  for (; i + (2 * per_block) <= n; i += 2 * per_block)
+    {
+      const char *p = data + (i * width);
+      uint64_t mask = (uint64_t)avx2_match_mask (p, v, width)
+                      | ((uint64_t)avx2_match_mask (p + 32, v, width) << 32);
+      if (mask != 0)
+        {
+          return i + ((size_t)__builtin_ctzll (mask) / width);
+        }
+    }
+
+  return find_scalar_w (data, i, n, width, needle);
+}
+
+[[gnu::target ("avx2,popcnt"), gnu::always_inline]] static inline size_t
+count_avx2_w (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  __m256i v = avx2_broadcast (needle, width);
+  size_t per_block = 32 / width;
+  size_t bits = 0;
+  size_t i = 0;
+
+  for (; i + per_block <= n; i += per_block)
+    {
+      bits += (size_t)__builtin_popcount (
+          avx2_match_mask (data + (i * width), v, width));
+    }
+
+  return (bits / width) + count_scalar_w (data, i, n, width, needle);
+}
+
+[[gnu::target ("avx2,popcnt")]] static size_t
+find_avx2 (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return find_avx2_w (data, n, 1, needle);
+    case 2:
+      return find_avx2_w (data, n, 2, needle);
+    case 4:
+      return find_avx2_w (data, n, 4, needle);
+    default:
+      return find_avx2_w (data, n, 8, needle);
+    }
+}
+
+[[gnu::target ("avx2,popcnt")]] static size_t
+count_avx2 (const char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return count_avx2_w (data, n, 1, needle);
+    case 2:
+      return count_avx2_w (data, n, 2, needle);
+    case 4:
+      return count_avx2_w (data, n, 4, needle);
+    default:
+      return count_avx2_w (data, n, 8, needle);
+    }
+}
+#endif
+
+static size_t
+find_elem (const vector_t *vec, const void *elem)
+{
+  const char *data = vec->data;
+
+  if (!is_word_size (vec->elem_len))
+    {
+      for (size_t i = 0; i < vec->len; i++)
+        {
+          if (memcmp (data + (i * vec->elem_len), elem, vec->elem_len) == 0)
+            {
+              return i;
+            }
+        }
+      return SIZE_MAX;
+    }
+
+  uint64_t needle = load_word (elem, vec->elem_len);
+
+#if CUTILS_SIMD_X86
+  if (cutils_cpu_has (CUTILS_CPU_AVX2))
+    {
+      return find_avx2 (data, vec->len, vec->elem_len, needle);
+    }
+  if (cutils_cpu_has (CUTILS_CPU_SSE2))
+    {
+      return find_sse2 (data, vec->len, vec->elem_len, needle);
+    }
+#endif
+
+  return find_scalar (data, vec->len, vec->elem_len, needle);
+}
+
+size_t
+vector_find (const vector_t *vec, const void *elem)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || elem == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return SIZE_MAX;
+    }
+
+  size_t index = find_elem (vec, elem);
+  if (index == SIZE_MAX)
+    {
+      g_last_error = VECTOR_NOT_FOUND;
+    }
+
+  return index;
+}
+
+size_t
+vector_count (const vector_t *vec, const void *elem)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || elem == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  const char *data = vec->data;
+
+  if (!is_word_size (vec->elem_len))
+    {
+      size_t count = 0;
+      for (size_t i = 0; i < vec->len; i++)
+        {
+          count += memcmp (data + (i * vec->elem_len), elem, vec->elem_len)
+                   == 0;
+        }
+      return count;
+    }
+
+  uint64_t needle = load_word (elem, vec->elem_len);
+
+#if CUTILS_SIMD_X86
+  if (cutils_cpu_has (CUTILS_CPU_AVX2))
+    {
+      return count_avx2 (data, vec->len, vec->elem_len, needle);
+    }
+  if (cutils_cpu_has (CUTILS_CPU_SSE2))
+    {
+      return count_sse2 (data, vec->len, vec->elem_len, needle);
+    }
+#endif
+
+  return count_scalar (data, vec->len, vec->elem_len, needle);
+}
+
+bool
+vector_contains (const vector_t *vec, const void *elem)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || elem == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return false;
+    }
+
+  return find_elem (vec, elem) != SIZE_MAX;
+}
+
+// Branchless binary search, the halving step compiles to a conditional move
+[[gnu::always_inline]] static inline size_t
+bound_by_compare (const vector_t *vec, const void *elem,
+                  int (*compare) (const void *a, const void *b), bool upper)
+{
+  const char *data = vec->data;
+  const char *base = data;
+  size_t n = vec->len;
+
+  if (n == 0)
+    {
+      return 0;
+    }
+
+  while (n > 1)
+    {
+      size_t half = n / 2;
+      const char *probe = base + (half * vec->elem_len);
+      int cmp = compare (probe, elem);
+      base = (upper ? cmp <= 0 : cmp < 0) ? probe : base;
+      n -= half;
+    }
+
+  int cmp = compare (base, elem);
+  size_t index = (size_t)(base - data) / vec->elem_len;
+  return index + (size_t)(upper ? cmp <= 0 : cmp < 0);
+}
+
+[[gnu::always_inline]] static inline size_t
+bound_by_key (const vector_t *vec, vector_key_type_t key_type,
+              size_t key_offset, const char *key, bool upper)
+{
+  const char *keys = (const char *)vec->data + key_offset;
+  const char *base = keys;
+  size_t n = vec->len;
+
+  if (n == 0)
+    {
+      return 0;
+    }
+
+  while (n > 1)
+    {
+      size_t half = n / 2;
+      const char *probe = base + (half * vec->elem_len);
+      bool right = upper ? !key_less (key_type, key, probe)
+                         : key_less (key_type, probe, key);
+      base = right ? probe : base;
+      n -= half;
+    }
+
+  bool past = upper ? !key_less (key_type, key, base)
+                    : key_less (key_type, base, key);
+  return ((size_t)(base - keys) / vec->elem_len) + (size_t)past;
+}
+
+static size_t
+bound_by_key_dispatch (const vector_t *vec, vector_key_type_t key_type,
+                       size_t key_offset, const char *key, bool upper)
+{
+  switch (key_type)
+    {
+    case VECTOR_KEY_U32:
+      return upper ? bound_by_key (vec, VECTOR_KEY_U32, key_offset, key, true)
+                   : bound_by_key (vec, VECTOR_KEY_U32, key_offset, key,
+                                   false);
+    case VECTOR_KEY_I32:
+      return upper ? bound_by_key (vec, VECTOR_KEY_I32, key_offset, key, true)
+                   : bound_by_key (vec, VECTOR_KEY_I32, key_offset, key,
+                                   false);
+    case VECTOR_KEY_F32:
+      return upper ? bound_by_key (vec, VECTOR_KEY_F32, key_offset, key, true)
+                   : bound_by_key (vec, VECTOR_KEY_F32, key_offset, key,
+                                   false);
+    case VECTOR_KEY_U64:
+      return upper ? bound_by_key (vec, VECTOR_KEY_U64, key_offset, key, true)
+                   : bound_by_key (vec, VECTOR_KEY_U64, key_offset, key,
+                                   false);
+    case VECTOR_KEY_I64:
+      return upper ? bound_by_key (vec, VECTOR_KEY_I64, key_offset, key, true)
+                   : bound_by_key (vec, VECTOR_KEY_I64, key_offset, key,
+                                   false);
+    case VECTOR_KEY_F64:
+      return upper ? bound_by_key (vec, VECTOR_KEY_F64, key_offset, key, true)
+                   : bound_by_key (vec, VECTOR_KEY_F64, key_offset, key,
+                                   false);
+    }
+
+  return vec->len;
+}
+
+size_t
+vector_lower_bound (const vector_t *vec, const void *elem,
+                    int (*compare) (const void *a, const void *b))
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || elem == NULL || compare == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  return bound_by_compare (vec, elem, compare, false);
+}
+
+size_t
+vector_upper_bound (const vector_t *vec, const void *elem,
+                    int (*compare) (const void *a, const void *b))
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || elem == NULL || compare == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  return bound_by_compare (vec, elem, compare, true);
+}
+
+size_t
+vector_lower_bound_by_key (const vector_t *vec, vector_key_type_t key_type,
+                           size_t key_offset, const void *key)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || key == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  if (!validate_key (vec, key_type, key_offset))
+    {
+      return 0;
+    }
+
+  return bound_by_key_dispatch (vec, key_type, key_offset, key, false);
+}
+
+size_t
+vector_upper_bound_by_key (const vector_t *vec, vector_key_type_t key_type,
+                           size_t key_offset, const void *key)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || key == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  if (!validate_key (vec, key_type, key_offset))
+    {
+      return 0;
+    }
+
+  return bound_by_key_dispatch (vec, key_type, key_offset, key, true);
+}
+
+// Compaction implementation
+static size_t
+move_run (char *data, size_t len, size_t write, size_t start, size_t end)
+{
+  if (start != write)
+    {
+      memmove (data + (write * len), data + (start * len),
+               (end - start) * len);
+    }
+  return write + (end - start);
+}
+
+static size_t
+compact_by_predicate (vector_t *vec,
+                      bool (*pred) (const void *elem, void *ctx), void *ctx,
+                      bool keep_value)
+{
+  char *data = vec->data;
+  size_t len = vec->elem_len;
+  size_t n = vec->len;
+  size_t write = 0;
+  size_t run_start = 0;
+  bool in_run = false;
+
+  // Kept elements are moved a whole run at a time
+  for (size_t i = 0; i < n; i++)
+    {
+      bool kept = pred (data + (i * len), ctx) == keep_value;
+      if (kept && !in_run)
+        {
+          run_start = i;
+          in_run = true;
+        }
+      else if (!kept && in_run)
+        {
+          write = move_run (data, len, write, run_start, i);
+          in_run = false;
+        }
+    }
+
+  if (in_run)
+    {
+      write = move_run (data, len, write, run_start, n);
+    }
+
+  vec->len = write;
+  return n - write;
+}
+
+size_t
+vector_retain (vector_t *vec, bool (*keep) (const void *elem, void *ctx),
+               void *ctx)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || keep == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  return compact_by_predicate (vec, keep, ctx, true);
+}
+
+size_t
+vector_erase_if (vector_t *vec, bool (*pred) (const void *elem, void *ctx),
+                 void *ctx)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || pred == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  return compact_by_predicate (vec, pred, ctx, false);
+}
+
+// Unconditional store, the write index only advances past kept elements
+[[gnu::always_inline]] static inline size_t
+erase_value_scalar_w (char *data, size_t start, size_t write, size_t n,
+                      size_t width, uint64_t needle)
+{
+  for (size_t i = start; i < n; i++)
+    {
+      uint64_t word = load_word (data + (i * width), width);
+      memmove (data + (write * width), data + (i * width), width);
+      write += word != needle;
+    }
+  return write;
+}
+
+static size_t
+erase_value_scalar (char *data, size_t n, size_t width, uint64_t needle)
+{
+  switch (width)
+    {
+    case 1:
+      return erase_value_scalar_w (data, 0, 0, n, 1, needle);
+    case 2:
+      return erase_value_scalar_w (data, 0, 0, n, 2, needle);
+    case 4:
+      return erase_value_scalar_w (data, 0, 0, n, 4, needle);
+    default:
+      return erase_value_scalar_w (data, 0, 0, n, 8, needle);
+    }
+}
+
+#if CUTILS_SIMD_X86
+/*
+ * Per keep mask, the 32-bit source lanes that pack the kept elements to the
+ * front, one lane index per nibble starting at the low nibble. The first
+ * table is for 4-byte elements, the second for 8-byte elements, where each
+ * element spans two lanes.
+ */
+static const uint32_t erase_lut_32[256] = {
+  0x00000000U, 0x00000000U, 0x00000001U, 0x00000010U, 0x00000002U, 0x00000020U,
+  0x00000021U, 0x00000210U, 0x00000003U, 0x00000030U, 0x00000031U, 0x00000310U,
+  0x00000032U, 0x00000320U, 0x00000321U, 0x00003210U, 0x00000004U, 0x00000040U,
+  0x00000041U, 0x00000410U, 0x00000042U, 0x00000420U, 0x00000421U, 0x00004210U,
+  0x00000043U, 0x00000430U, 0x00000431U, 0x00004310U, 0x00000432U, 0x00004320U,
+  0x00004321U, 0x00043210U, 0x00000005U, 0x00000050U, 0x00000051U, 0x00000510U,
+  0x00000052U, 0x00000520U, 0x00000521U, 0x00005210U, 0x00000053U, 0x00000530U,
+  0x00000531U, 0x00005310U, 0x00000532U, 0x00005320U, 0x00005321U, 0x00053210U,
+  0x00000054U, 0x00000540U, 0x00000541U, 0x00005410U, 0x00000542U, 0x00005420U,
+  0x00005421U, 0x00054210U, 0x00000543U, 0x00005430U, 0x00005431U, 0x00054310U,
+  0x00005432U, 0x00054320U, 0x00054321U, 0x00543210U, 0x00000006U, 0x00000060U,
+  0x00000061U, 0x00000610U, 0x00000062U, 0x00000620U, 0x00000621U, 0x00006210U,
+  0x00000063U, 0x00000630U, 0x00000631U, 0x00006310U, 0x00000632U, 0x00006320U,
+  0x00006321U, 0x00063210U, 0x00000064U, 0x00000640U, 0x00000641U, 0x00006410U,
+  0x00000642U, 0x00006420U, 0x00006421U, 0x00064210U, 0x00000643U, 0x00006430U,
+  0x00006431U, 0x00064310U, 0x00006432U, 0x00064320U, 0x00064321U, 0x00643210U,
+  0x00000065U, 0x00000650U, 0x00000651U, 0x00006510U, 0x00000652U, 0x00006520U,
+  0x00006521U, 0x00065210U, 0x00000653U, 0x00006530U, 0x00006531U, 0x00065310U,
+  0x00006532U, 0x00065320U, 0x00065321U, 0x00653210U, 0x00000654U, 0x00006540U,
+  0x00006541U, 0x00065410U, 0x00006542U, 0x00065420U, 0x00065421U, 0x00654210U,
+  0x00006543U, 0x00065430U, 0x00065431U, 0x00654310U, 0x00065432U, 0x00654320U,
+  0x00654321U, 0x06543210U, 0x00000007U, 0x00000070U, 0x00000071U, 0x00000710U,
+  0x00000072U, 0x00000720U, 0x00000721U, 0x00007210U, 0x00000073U, 0x00000730U,
+  0x00000731U, 0x00007310U, 0x00000732U, 0x00007320U, 0x00007321U, 0x00073210U,
+  0x00000074U, 0x00000740U, 0x00000741U, 0x00007410U, 0x00000742U, 0x00007420U,
+  0x00007421U, 0x00074210U, 0x00000743U, 0x00007430U, 0x00007431U, 0x00074310U,
+  0x00007432U, 0x00074320U, 0x00074321U, 0x00743210U, 0x00000075U, 0x00000750U,
+  0x00000751U, 0x00007510U, 0x00000752U, 0x00007520U, 0x00007521U, 0x00075210U,
+  0x00000753U, 0x00007530U, 0x00007531U, 0x00075310U, 0x00007532U, 0x00075320U,
+  0x00075321U, 0x00753210U, 0x00000754U, 0x00007540U, 0x00007541U, 0x00075410U,
+  0x00007542U, 0x00075420U, 0x00075421U, 0x00754210U, 0x00007543U, 0x00075430U,
+  0x00075431U, 0x00754310U, 0x00075432U, 0x00754320U, 0x00754321U, 0x07543210U,
+  0x00000076U, 0x00000760U, 0x00000761U, 0x00007610U, 0x00000762U, 0x00007620U,
+  0x00007621U, 0x00076210U, 0x00000763U, 0x00007630U, 0x00007631U, 0x00076310U,
+  0x00007632U, 0x00076320U, 0x00076321U, 0x00763210U, 0x00000764U, 0x00007640U,
+  0x00007641U, 0x00076410U, 0x00007642U, 0x00076420U, 0x00076421U, 0x00764210U,
+  0x00007643U, 0x00076430U, 0x00076431U, 0x00764310U, 0x00076432U, 0x00764320U,
+  0x00764321U, 0x07643210U, 0x00000765U, 0x00007650U, 0x00007651U, 0x00076510U,
+  0x00007652U, 0x00076520U, 0x00076521U, 0x00765210U, 0x00007653U, 0x00076530U,
+  0x00076531U, 0x00765310U, 0x00076532U, 0x00765320U, 0x00765321U, 0x07653210U,
+  0x00007654U, 0x00076540U, 0x00076541U, 0x00765410U, 0x00076542U, 0x00765420U,
+  0x00765421U, 0x07654210U, 0x00076543U, 0x00765430U, 0x00765431U, 0x07654310U,
+  0x00765432U, 0x07654320U, 0x07654321U, 0x76543210U,
+};
+static const uint32_t erase_lut_64[16] = {
+  0x00000000U, 0x00000010U, 0x00000032U, 0x00003210U, 0x00000054U, 0x00005410U,
+  0x00005432U, 0x00543210U, 0x00000076U, 0x00007610U, 0x00007632U, 0x00763210U,
+  0x00007654U, 0x00765410U, 0x00765432U, 0x76543210U,
+};
+
+/*
+ * AVX2 stream compaction: compare a block, look up the lane permutation
+ * that packs the kept lanes to the front, store the whole block at the
+ * write position and advance by the number of kept lanes. The store never
+ * passes the end of the block just read, so unread data is not clobbered.
+ */
+[[gnu::target ("avx2,popcnt")]] static size_t
+erase_value_avx2 (char *data, size_t n, size_t width, uint64_t needle)
+{
+  const uint32_t *lut = width == sizeof (uint32_t) ? erase_lut_32
+                                                   : erase_lut_64;
+  size_t lanes = 32 / width;
+  __m256i shifts = _mm256_setr_epi32 (0, 4, 8, 12, 16, 20, 24, 28);
+  __m256i nibble = _mm256_set1_epi32 (0xF);
+  __m256i v = avx2_broadcast (needle, width);
+  uint32_t all = (1U << lanes) - 1;
+  size_t write = 0;
+  size_t i = 0;
+
+  for (; i + lanes <= n; i += lanes)
+    {
+      __m256i block = _mm256_loadu_si256 ((const void *)(data + (i * width)));
+      uint32_t eq;
+      if (width == sizeof (uint32_t))
+        {
+          eq = (uint32_t)_mm256_movemask_ps (
+              _mm256_castsi256_ps (_mm256_cmpeq_epi32 (block, v)));
+        }
+      else
+        {
+          eq = (uint32_t)_mm256_movemask_pd (
+              _mm256_castsi256_pd (_mm256_cmpeq_epi64 (block, v)));
+        }
+
+      uint32_t keep = ~eq & all;
+      __m256i perm = _mm256_and_si256 (
+          _mm256_srlv_epi32 (_mm256_set1_epi32 ((int)lut[keep]), shifts),
+          nibble);
+      _mm256_storeu_si256 ((void *)(data + (write * width)),
+                           _mm256_permutevar8x32_epi32 (block, perm));
+      write += (size_t)__builtin_popcount (keep);
+    }
+
+  if (width == sizeof (uint32_t))
+    {
+      return erase_value_scalar_w (data, i, write, n, 4, needle);
+    }
+  return erase_value_scalar_w (data, i, write, n, 8, needle);
+}
+#endif
+
+size_t
+vector_erase_value (vector_t *vec, const void *elem)
+{
+  g_last_error = VECTOR_OK;
+
+  if (vec == NULL || elem == NULL)
+    {
+      g_last_error = VECTOR_NULL_PTR;
+      return 0;
+    }
+
+  char *data = vec->data;
+  size_t n = vec->len;
+  size_t write = 0;
+
+  if (!is_word_size (vec->elem_len))
+    {
+      for (size_t i = 0; i < n; i++)
+        {
+          const char *cur = data + (i * vec->elem_len);
+          if (memcmp (cur, elem, vec->elem_len) != 0)
+            {
+              if (write != i)
+                {
+                  memcpy (data + (write * vec->elem_len), cur, vec->elem_len);
+                }
+              write++;
+            }
+        }
+      vec->len = write;
+      return n - write;
+    }
+
+  uint64_t needle = load_word (elem, vec->elem_len);
+
+#if CUTILS_SIMD_X86
+  if (vec->elem_len >= sizeof (uint32_t)
+      && cutils_cpu_has (CUTILS_CPU_AVX2))
+    {
+      write = erase_value_avx2 (data, n, vec->elem_len, needle);
+      vec->len = write;
+      return n - write;
+    }
+#endif
+
+  write = erase_value_scalar (data, n, vec->elem_len, needle);
+  vec->len = write;
+  return n - write;
+}